@@ -8,7 +8,7 @@ include "scripts/actions.lua"
 
 workspace "GamepadDebug"
     configurations { "Release", "Debug" }
-    platforms { "Win32", "Win64" }
+    platforms { "Win32", "Win64", "Linux64" }
     location "build"
     language "C++"
     cppdialect "C++17"
@@ -21,6 +21,10 @@ filter { "platforms:Win64" }
     system "Windows"
     architecture "x86_64"
 
+filter { "platforms:Linux64" }
+    system "Linux"
+    architecture "x86_64"
+
 filter "configurations:Debug"
     defines { "DEBUG" }
     symbols "On"
@@ -38,11 +42,23 @@ include "vendor"
 
 project "GamepadDebug"
     kind "WindowedApp"
+    removeplatforms { "Linux64" }
     files { "src/**.cpp", "src/**.h", "README.md" }
+    removefiles { "src/cli/**" }
     includedirs { "src/include" }
-    links { "d3d9", "Cfgmgr32" }
+    links { "d3d9", "Cfgmgr32", "Winmm" }
     add_imgui {}
 
+-- Only the platform independent parts, so batch jobs can run on build servers (premake5 gmake2, make config=release_linux64)
+project "GamepadDebugCli"
+    kind "ConsoleApp"
+    files { "src/cli/**.cpp", "src/record/**.cpp", "src/gd_digest.cpp", "src/gd_fft.cpp", "src/gd_file.cpp", "src/gd_resolution.cpp", "src/gd_threadpool.cpp", "src/include/record/**.h", "src/include/gd_digest.h", "src/include/gd_fft.h", "src/include/gd_file.h", "src/include/gd_resolution.h", "src/include/gd_sample.h", "src/include/gd_threadpool.h" }
+    includedirs { "src/include" }
+
+    filter { "system:Linux" }
+        links { "pthread" }
+    filter {}
+
 local p = premake
 p.override(p.main, 'postAction', function(base)
     base()
@@ -0,0 +1,531 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Headless tool to work with recordings, also builds on Linux
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordAlign.h"
+#include "record/gd_RecordAnalytics.h"
+#include "record/gd_RecordDiff.h"
+#include "record/gd_RecordExport.h"
+#include "record/gd_RecordQuery.h"
+#include "record/gd_RecordReader.h"
+#include "record/gd_RecordScript.h"
+#include "record/gd_RecordWriter.h"
+#include "gd_threadpool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+
+static int Usage()
+{
+    fprintf(stderr,
+        "Usage: GamepadDebugCli <command> [options] <files or directories>\n"
+        "\n"
+        "Commands:\n"
+        "  info                 Show the devices and time range of recordings\n"
+        "  recover              Repair recordings that were not closed\n"
+        "  query <condition>    Find where a condition holds, e.g. \"GUIDE for>=2s\"\n"
+        "  analyze              Statistics per product over all recordings\n"
+        "  export <output>      Convert one recording, the format follows the extension (.parquet, .vcd)\n"
+        "  diff <a> <b>         Compare the behavior of a device in two recordings of the same motion\n"
+        "  align <a> <b>        Find the offset between two recordings of the same session, for diff --offset\n"
+        "  align --check <a>    Align a recording with itself, and with copies at a slower report rate with known offsets\n"
+        "  test <script>        Run a test script against every device of the recordings, fails when a test fails\n"
+        "\n"
+        "Options:\n"
+        "  --threads <n>        Number of threads, defaults to one per core\n"
+        "  --offset <us>        diff: microseconds to add to the timestamps of b, instead of aligning on the first input\n"
+        "  --device-a <id>      diff, align: device to compare, defaults to the first one\n"
+        "  --device-b <id>\n"
+        "  --guess <us>         align: start from this offset instead of the wall clock times\n"
+        "  --max-lag <us>       align: how far from the guess to search, default 2 s\n");
+    return 2;
+}
+
+// Directories are searched recursively for .gdrec files
+static bool CollectFiles(int argc, char** argv, int first, std::vector<std::string>& files, unsigned& threads)
+{
+    for (int n = first; n < argc; ++n)
+    {
+        if (!strcmp(argv[n], "--threads"))
+        {
+            if (++n >= argc)
+                return false;
+            threads = (unsigned)strtoul(argv[n], nullptr, 10);
+            continue;
+        }
+
+        std::error_code ec;
+        if (std::filesystem::is_directory(argv[n], ec))
+        {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(argv[n], ec))
+            {
+                if (entry.is_regular_file(ec) && entry.path().extension() == ".gdrec")
+                    files.push_back(entry.path().string());
+            }
+        }
+        else
+        {
+            files.push_back(argv[n]);
+        }
+    }
+    return !files.empty();
+}
+
+static int Info(const std::vector<std::string>& files)
+{
+    int result = 0;
+    for (const auto& file : files)
+    {
+        GD::Record::Reader reader;
+        if (!reader.Open(file.c_str()))
+        {
+            fprintf(stderr, "%s: %s\n", file.c_str(), reader.Error().c_str());
+            result = 1;
+            continue;
+        }
+
+        std::vector<GD::Record::KeyframeEntry> devices;
+        reader.Seek(reader.FirstTimestamp(), devices);
+        printf("%s: %.3f s, %zu chunks\n", file.c_str(), (reader.LastTimestamp() - reader.FirstTimestamp()) / 1e6, reader.ChunkCount());
+        for (const auto& device : devices)
+            printf("  device %u: slot %u, %04X / %04X / %04X\n", device.Info.Id, device.Info.Slot, device.Info.VendorId, device.Info.ProductId, device.Info.ProductVersion);
+    }
+    return result;
+}
+
+static int Recover(const std::vector<std::string>& files)
+{
+    int result = 0;
+    for (const auto& file : files)
+    {
+        GD::Record::RecoverResult recovered;
+        std::string error;
+        if (!GD::Record::Recover(file.c_str(), recovered, error))
+        {
+            fprintf(stderr, "%s: %s\n", file.c_str(), error.c_str());
+            result = 1;
+        }
+        else if (recovered.HadIndex)
+        {
+            printf("%s: ok\n", file.c_str());
+        }
+        else
+        {
+            printf("%s: recovered %u chunks, kept %llu of %llu bytes\n", file.c_str(), recovered.Chunks,
+                (unsigned long long)recovered.ValidSize, (unsigned long long)recovered.OriginalSize);
+        }
+    }
+    return result;
+}
+
+static int Query(const char* text, const std::vector<std::string>& files, unsigned threads)
+{
+    GD::Record::Condition condition;
+    std::string error;
+    if (!GD::Record::ParseCondition(text, condition, error))
+    {
+        fprintf(stderr, "Invalid query: %s\n", error.c_str());
+        return 2;
+    }
+
+    GD::Record::QueryStats stats;
+    auto matches = GD::Record::RunQuery(condition, files, threads, &stats);
+    // Timestamps are on the monotonic clock, show them from the start of their recording like Replay does
+    std::vector<uint64_t> firsts(files.size());
+    std::vector<bool> opened(files.size());
+    for (const auto& match : matches)
+    {
+        if (!opened[match.File])
+        {
+            GD::Record::Reader reader;
+            if (reader.Open(files[match.File].c_str()))
+                firsts[match.File] = reader.FirstTimestamp();
+            opened[match.File] = true;
+        }
+        uint64_t first = std::min(firsts[match.File], match.Start);
+        printf("%s: device %u, at %.3f s for %.3f s\n", files[match.File].c_str(), match.Device,
+            (match.Start - first) / 1e6, (match.End - match.Start) / 1e6);
+    }
+    fprintf(stderr, "%zu matches, decoded %llu of %llu chunks, %u files failed\n", matches.size(),
+        (unsigned long long)stats.DecodedChunks, (unsigned long long)stats.Chunks, stats.FailedFiles);
+    return stats.FailedFiles ? 1 : 0;
+}
+
+static void PrintDrift(const char* name, const uint64_t (&histogram)[GD::Record::DriftBins])
+{
+    printf("    %s drift:", name);
+    for (int bin = 0; bin < GD::Record::DriftBins; ++bin)
+    {
+        if (histogram[bin])
+            printf(" %s%d:%llu", bin == GD::Record::DriftBins - 1 ? ">=" : "<", (bin + (bin != GD::Record::DriftBins - 1)) * GD::Record::DriftBinWidth,
+                (unsigned long long)histogram[bin]);
+    }
+    printf("\n");
+}
+
+static int Analyze(const std::vector<std::string>& files, unsigned threads)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto result = GD::Record::Analyze(files, threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const auto& product : result.Products)
+    {
+        printf("%04X / %04X / %04X: %llu sessions, %.1f s, %llu samples, %llu presses, %llu missed packets\n",
+            product.Info.VendorId, product.Info.ProductId, product.Info.ProductVersion, (unsigned long long)product.Sessions,
+            product.Duration / 1e6, (unsigned long long)product.Samples, (unsigned long long)product.ButtonPresses,
+            (unsigned long long)product.MissedPackets);
+        for (int axis = 0; axis < GD::Axis_Count; ++axis)
+        {
+            const auto& stats = product.Axes[axis];
+            if (stats.Values.Count)
+                printf("    %-14s mean %9.1f  stddev %8.1f  min %6d  max %6d\n", GD::AxisName(axis), stats.Values.Mean, std::sqrt(stats.Values.Variance()), stats.Min, stats.Max);
+        }
+        if (product.Intervals.Count())
+        {
+            const auto& intervals = product.Intervals;
+            printf("    interval ms    p50 %.3f  p90 %.3f  p99 %.3f  p99.9 %.3f  max %.3f\n", intervals.Quantile(0.5) / 1000,
+                intervals.Quantile(0.9) / 1000, intervals.Quantile(0.99) / 1000, intervals.Quantile(0.999) / 1000, intervals.Max() / 1000);
+        }
+        PrintDrift("Left", product.LeftDrift);
+        PrintDrift("Right", product.RightDrift);
+    }
+    fprintf(stderr, "%llu files (%llu failed), %llu chunks in %.2f s\n", (unsigned long long)result.Files,
+        (unsigned long long)result.FailedFiles, (unsigned long long)result.Chunks, seconds);
+    return result.FailedFiles ? 1 : 0;
+}
+
+static int Test(const char* path, const std::vector<std::string>& files, unsigned threads)
+{
+    GD::Record::Script script;
+    std::string error;
+    if (!GD::Record::LoadScript(path, script, error))
+    {
+        fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return 2;
+    }
+
+    struct FileResult
+    {
+        bool Ok = false;
+        std::string Error;
+        std::vector<GD::Record::ScriptDeviceResult> Devices;
+    };
+    std::vector<FileResult> results(files.size());
+    GD::ThreadPool pool(threads);
+    GD::ParallelFor(pool, files.size(), [&](size_t n)
+        {
+            results[n].Ok = GD::Record::RunScript(script, files[n].c_str(), results[n].Devices, results[n].Error);
+        });
+
+    int passed = 0, failed = 0, result = 0;
+    for (size_t n = 0; n < files.size(); ++n)
+    {
+        if (!results[n].Ok)
+        {
+            fprintf(stderr, "%s: %s\n", files[n].c_str(), results[n].Error.c_str());
+            result = 1;
+            continue;
+        }
+        for (const auto& device : results[n].Devices)
+        {
+            printf("%s: device %u, %04X / %04X / %04X\n", files[n].c_str(), device.Info.Id, device.Info.VendorId, device.Info.ProductId, device.Info.ProductVersion);
+            for (size_t test = 0; test < device.Tests.size(); ++test)
+            {
+                const auto& outcome = device.Tests[test];
+                const char* name = script.Tests[test].Name.c_str();
+                if (outcome.State != GD::Record::Test_Passed)
+                {
+                    printf("  FAIL  %-24s %s\n", name, outcome.Message.c_str());
+                    failed++;
+                    result = 1;
+                    continue;
+                }
+                int64_t margin;
+                if (outcome.TightestMargin(script.Tests[test], margin))
+                    printf("  PASS  %-24s %.3f s, tightest margin %.1f ms\n", name, (outcome.End - outcome.Start) / 1e6, margin / 1e3);
+                else
+                    printf("  PASS  %-24s %.3f s\n", name, (outcome.End - outcome.Start) / 1e6);
+                passed++;
+            }
+        }
+    }
+    fprintf(stderr, "%d passed, %d failed\n", passed, failed);
+    return result;
+}
+
+static int Export(const char* output, const std::vector<std::string>& files)
+{
+    if (files.size() != 1)
+        return Usage();
+
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    if (!GD::Record::Export(files[0].c_str(), output, error))
+    {
+        fprintf(stderr, "%s: %s\n", files[0].c_str(), error.c_str());
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "Wrote %s in %.2f s\n", output, seconds);
+    return 0;
+}
+
+static int Diff(int argc, char** argv)
+{
+    GD::Record::DiffOptions options;
+    std::vector<const char*> files;
+    for (int n = 2; n < argc; ++n)
+    {
+        bool hasValue = n + 1 < argc;
+        if (!strcmp(argv[n], "--offset") && hasValue)
+        {
+            options.Offset = strtoll(argv[++n], nullptr, 10);
+            options.Align = false;
+        }
+        else if (!strcmp(argv[n], "--device-a") && hasValue)
+            options.DeviceA = atoi(argv[++n]);
+        else if (!strcmp(argv[n], "--device-b") && hasValue)
+            options.DeviceB = atoi(argv[++n]);
+        else
+            files.push_back(argv[n]);
+    }
+    if (files.size() != 2)
+        return Usage();
+
+    GD::Record::DiffResult result;
+    std::string error;
+    if (!GD::Record::Diff(files[0], files[1], options, result, error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    if (result.Correlation)
+        printf("aligned with correlation %.3f\n", result.Correlation);
+    printf("a: %04X / %04X / %04X, %llu samples\n", result.InfoA.VendorId, result.InfoA.ProductId, result.InfoA.ProductVersion, (unsigned long long)result.SamplesA);
+    printf("b: %04X / %04X / %04X, %llu samples\n", result.InfoB.VendorId, result.InfoB.ProductId, result.InfoB.ProductVersion, (unsigned long long)result.SamplesB);
+    printf("offset %lld us, %.3f s overlap, %llu matched edges\n\n", (long long)result.Offset, result.Overlap / 1e6, (unsigned long long)result.MatchedEdges);
+    printf("  %-30s %25s %10s\n", "", "b later than a (ms)", "p");
+    int changes = 0;
+    for (const auto& delay : result.Delays)
+    {
+        printf("%c %-30s %25.3f %10.2g\n", delay.Significant ? '*' : ' ', delay.Name.c_str(), delay.Delay, delay.PValue);
+        changes += delay.Significant;
+    }
+    printf("\n  %-30s %12s %12s %10s\n", "", "a", "b", "p");
+    for (const auto& metric : result.Metrics)
+    {
+        char p[16] = "exact";
+        if (metric.PValue >= 0)
+            snprintf(p, sizeof(p), "%.2g", metric.PValue);
+        printf("%c %-30s %12.3f %12.3f %10s\n", metric.Significant ? '*' : ' ', metric.Name.c_str(), metric.A, metric.B, p);
+        changes += metric.Significant;
+    }
+    printf("\n%d significant differences\n", changes);
+    return 0;
+}
+
+// A copy of one device of a recording, as a device that reports every period would have sent it, moved by shift
+static bool WriteReportedCopy(const char* file, const char* copy, int device, uint64_t period, int64_t shift, std::string& error)
+{
+    GD::Record::Reader reader;
+    GD::DeviceInfo info;
+    if (!reader.Open(file) || !reader.FindDevice(device, info))
+    {
+        error = std::string(file) + ": " + (reader.Error().empty() ? "device not found" : reader.Error());
+        return false;
+    }
+
+    GD::Record::DeviceStream stream(reader, info.Id);
+    GD::Sample state, reported;
+    if (!stream.Next(state))
+    {
+        error = std::string(file) + ": no samples";
+        return false;
+    }
+    GD::Record::Writer writer;
+    if (!writer.Open(copy, GD::Record::DefaultKeyframeInterval, false, (uint64_t)((int64_t)state.Timestamp + std::min<int64_t>(shift, 0))))
+    {
+        error = std::string(copy) + ": unable to create";
+        return false;
+    }
+
+    // Only changes are reported, like XInput does
+    reported = state;
+    reported.Timestamp += shift;
+    writer.AddDevice(info, reported);
+    uint64_t report = state.Timestamp + period;
+    GD::Sample sample;
+    bool more = true;
+    while (more)
+    {
+        more = stream.Next(sample);
+        while (report < (more ? sample.Timestamp : state.Timestamp + period))
+        {
+            if (memcmp(&state.Buttons, &reported.Buttons, sizeof(GD::Sample) - offsetof(GD::Sample, Buttons)))
+            {
+                reported = state;
+                reported.Timestamp = (uint64_t)((int64_t)report + shift);
+                reported.PacketNumber++;
+                writer.Append(reported);
+            }
+            report += period;
+        }
+        state = sample;
+    }
+    writer.Close();
+    return true;
+}
+
+// A recording against itself has to come out at 0, also when the search starts from a known wrong offset
+static int CheckAlign(const char* file, GD::Record::AlignOptions options)
+{
+    options.Start = GD::Record::AlignStart_Given;
+    options.DeviceB = options.DeviceA;
+    int64_t shift = (int64_t)(options.MaxLag / 2 + options.Resolution / 3);
+    int failed = 0;
+    auto check = [&](const char* name, const char* a, const char* b, int64_t guess, int64_t expected)
+        {
+            options.Guess = guess;
+            GD::Record::AlignResult result;
+            std::string error;
+            if (!GD::Record::Align(a, b, options, result, error))
+            {
+                fprintf(stderr, "%s\n", error.c_str());
+                failed++;
+                return;
+            }
+            // Well below one report interval of either recording
+            bool ok = (uint64_t)std::llabs(result.Offset - expected) <= options.Resolution / 2;
+            printf("%s, shift %lld us: offset %lld us, correlation %.3f, %s\n", name, (long long)(guess ? guess : -expected), (long long)result.Offset, result.Correlation, ok ? "ok" : "FAILED");
+            failed += !ok;
+        };
+    for (int64_t guess : { (int64_t)0, shift, -shift })
+        check("itself", file, file, guess, 0);
+
+    // Both copies report the same input, one about as often as the recording and one 4 times slower.
+    // The periods are a bit off, so the input lands at every point of their report intervals,
+    // like input from a hand does. From a recording made by a generator that is not the case.
+    GD::Record::Reader reader;
+    GD::DeviceInfo info;
+    uint64_t interval = reader.Open(file) && reader.FindDevice(options.DeviceA, info) ? GD::Record::ReportInterval(reader, info.Id) : 0;
+    uint64_t periods[2] = { std::max<uint64_t>(interval - interval / 300, 1), 4 * interval + 1 };
+    std::string copyA = std::string(file) + ".check-a.gdrec";
+    std::string copyB = std::string(file) + ".check-b.gdrec";
+    std::string error;
+    bool written = WriteReportedCopy(file, copyA.c_str(), options.DeviceA, periods[0], 0, error);
+    std::string name = "reports every " + std::to_string(periods[0]) + " and " + std::to_string(periods[1]) + " us";
+    for (int64_t offset : { (int64_t)12345, (int64_t)1500, (int64_t)2500, -shift })
+    {
+        written = written && WriteReportedCopy(file, copyB.c_str(), options.DeviceA, periods[1], offset, error);
+        if (!written)
+            break;
+        check(name.c_str(), copyA.c_str(), copyB.c_str(), 0, -offset);
+    }
+    for (const std::string& copy : { copyA, copyB })
+    {
+        std::filesystem::remove(copy);
+        std::filesystem::remove(copy + GD::Record::PyramidExtension);
+    }
+    if (!written)
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
+
+static int Align(int argc, char** argv)
+{
+    GD::Record::AlignOptions options;
+    std::vector<const char*> files;
+    bool check = false;
+    for (int n = 2; n < argc; ++n)
+    {
+        bool hasValue = n + 1 < argc;
+        if (!strcmp(argv[n], "--check"))
+            check = true;
+        else if (!strcmp(argv[n], "--guess") && hasValue)
+        {
+            options.Guess = strtoll(argv[++n], nullptr, 10);
+            options.Start = GD::Record::AlignStart_Given;
+        }
+        else if (!strcmp(argv[n], "--max-lag") && hasValue)
+            options.MaxLag = strtoull(argv[++n], nullptr, 10);
+        else if (!strcmp(argv[n], "--device-a") && hasValue)
+            options.DeviceA = atoi(argv[++n]);
+        else if (!strcmp(argv[n], "--device-b") && hasValue)
+            options.DeviceB = atoi(argv[++n]);
+        else
+            files.push_back(argv[n]);
+    }
+    if (check && files.size() == 1)
+        return CheckAlign(files[0], options);
+    if (files.size() != 2)
+        return Usage();
+
+    auto start = std::chrono::steady_clock::now();
+    GD::Record::AlignResult result;
+    std::string error;
+    if (!GD::Record::Align(files[0], files[1], options, result, error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%lld\n", (long long)result.Offset);
+    fprintf(stderr, "correlation %.3f, %llu blocks in %.2f s\n", result.Correlation, (unsigned long long)result.Blocks, seconds);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+        return Usage();
+
+    const char* command = argv[1];
+    if (!strcmp(command, "diff"))
+        return Diff(argc, argv);
+    if (!strcmp(command, "align"))
+        return Align(argc, argv);
+
+    int first = 2;
+    const char* condition = nullptr;
+    const char* output = nullptr;
+    const char* script = nullptr;
+    if (!strcmp(command, "query"))
+        condition = argv[first++];
+    else if (!strcmp(command, "test"))
+        script = argv[first++];
+    else if (!strcmp(command, "export"))
+        output = argv[first++];
+
+    std::vector<std::string> files;
+    unsigned threads = 0;
+    if (!CollectFiles(argc, argv, first, files, threads))
+        return Usage();
+
+    if (!strcmp(command, "info"))
+        return Info(files);
+    if (!strcmp(command, "recover"))
+        return Recover(files);
+    if (condition)
+        return Query(condition, files, threads);
+    if (!strcmp(command, "analyze"))
+        return Analyze(files, threads);
+    if (output)
+        return Export(output, files);
+    if (script)
+        return Test(script, files, threads);
+    return Usage();
+}
@@ -0,0 +1,157 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Test session of one device on the bench, analyzed on a thread of its own
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_bench.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+constexpr uint64_t PublishInterval = 100000;                // Microseconds
+
+
+GD::BenchSession::BenchSession(const DeviceInfo& info)
+    : m_Info(info)
+    , m_StartTime((uint64_t)time(nullptr))
+{
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        m_Deadzone[axis] = INT32_MAX;
+        m_Resolution.emplace_back(axis);
+    }
+    Publish();
+    m_Thread = std::thread(&BenchSession::WorkerProc, this);
+}
+
+GD::BenchSession::~BenchSession()
+{
+    Stop();
+}
+
+void GD::BenchSession::Push(const Sample& sample)
+{
+    bool wake;
+    {
+        std::unique_lock<std::mutex> lock(m_QueueLock);
+        // The worker only sleeps on an empty queue
+        wake = m_Queue.empty();
+        m_Queue.push_back(sample);
+    }
+    if (wake)
+        m_Wake.notify_one();
+}
+
+void GD::BenchSession::Stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_QueueLock);
+        m_Stop = true;
+    }
+    m_Wake.notify_one();
+    if (m_Thread.joinable())
+        m_Thread.join();
+}
+
+GD::Record::BenchRecord GD::BenchSession::Result() const
+{
+    std::unique_lock<std::mutex> lock(m_ResultLock);
+    return m_Result;
+}
+
+void GD::BenchSession::WorkerProc()
+{
+    uint64_t published = 0;
+    for (;;)
+    {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(m_QueueLock);
+            m_Wake.wait(lock, [this]() { return m_Stop || !m_Queue.empty(); });
+            // Swap, so the sampling thread gets the (already allocated) buffer of the last batch back
+            m_Batch.clear();
+            m_Batch.swap(m_Queue);
+            stop = m_Stop;
+        }
+
+        m_PeakBacklog = std::max(m_PeakBacklog, m_Batch.size());
+        for (const auto& sample : m_Batch)
+            Analyze(sample);
+
+        uint64_t now = GD::Now();
+        if (stop || now - published >= PublishInterval)
+        {
+            Publish();
+            published = now;
+        }
+        if (stop)
+            return;
+    }
+}
+
+void GD::BenchSession::Analyze(const Sample& sample)
+{
+    if (m_Started)
+    {
+        m_Intervals.Add((double)(sample.Timestamp - m_Last));
+        uint32_t gap = sample.PacketNumber - m_LastPacket;
+        if (gap > 1 && gap < 0x80000000u)
+            m_Missed += gap - 1;
+    }
+    else
+    {
+        m_Started = true;
+        m_First = sample.Timestamp;
+    }
+    m_Last = sample.Timestamp;
+    m_LastPacket = sample.PacketNumber;
+    m_Samples++;
+
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        int32_t value = GetAxis(sample, axis);
+        m_Resolution[axis].Add(value);
+        // A device with a deadzone of its own jumps from 0 straight to the edge of it
+        int32_t magnitude = std::abs(value);
+        if (magnitude)
+            m_Deadzone[axis] = std::min(m_Deadzone[axis], magnitude);
+    }
+    m_Buttons.Add(sample.Timestamp, sample.Buttons);
+}
+
+void GD::BenchSession::Publish()
+{
+    Record::BenchRecord result;
+    result.VendorId = m_Info.VendorId;
+    result.ProductId = m_Info.ProductId;
+    result.ProductVersion = m_Info.ProductVersion;
+    result.Slot = m_Info.Slot;
+    result.SubType = m_Info.SubType;
+    result.Time = m_StartTime;
+    result.Duration = (uint32_t)std::min<uint64_t>((m_Last - m_First) / 1000, UINT32_MAX);
+    result.Samples = (uint32_t)std::min<uint64_t>(m_Samples, UINT32_MAX);
+    result.MissedPackets = (uint32_t)std::min<uint64_t>(m_Missed, UINT32_MAX);
+    result.PeakBacklog = (uint32_t)m_PeakBacklog;
+    if (m_Intervals.Count())
+    {
+        result.IntervalP50 = (float)m_Intervals.Quantile(0.5);
+        result.IntervalP99 = (float)m_Intervals.Quantile(0.99);
+        result.IntervalMax = (float)m_Intervals.Max();
+        if (result.IntervalP50 > 0)
+            result.ReportRate = 1e6f / result.IntervalP50;
+    }
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        result.Deadzone[axis] = (int16_t)(m_Deadzone[axis] == INT32_MAX ? 0 : std::min(m_Deadzone[axis], 32767));
+        result.EffectiveBits[axis] = (float)m_Resolution[axis].Analyze().EffectiveBits;
+    }
+    for (int bit = 0; bit < ButtonEdges::Buttons; ++bit)
+    {
+        const ButtonStats& stats = m_Buttons.Stats(bit);
+        result.Presses += (uint32_t)stats.Presses;
+        result.Chatter += (uint32_t)stats.Chatter;
+    }
+
+    std::unique_lock<std::mutex> lock(m_ResultLock);
+    m_Result = result;
+}
@@ -0,0 +1,160 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Press and release events of the buttons, with hold times, chords and chatter
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_buttons.h"
+#include "gd_sample.h"
+#include <algorithm>
+#include <bitset>
+
+
+static int HoldBucket(uint64_t duration)
+{
+    int bucket = 0;
+    for (uint64_t units = duration >> 7; units; units >>= 1)
+        bucket++;
+    return std::min(bucket, GD::ButtonStats::HoldBuckets - 1);
+}
+
+GD::ButtonEdges::ButtonEdges(uint64_t chatterWindow, uint64_t chordWindow)
+    : m_ChatterWindow(chatterWindow)
+    , m_ChordWindow(chordWindow)
+{
+}
+
+void GD::ButtonEdges::Clear()
+{
+    uint64_t chatterWindow = m_ChatterWindow, chordWindow = m_ChordWindow;
+    *this = ButtonEdges(chatterWindow, chordWindow);
+}
+
+void GD::ButtonEdges::Event(uint64_t timestamp, int bit, bool press, bool chatter, uint64_t duration)
+{
+    ButtonEvent event;
+    event.Timestamp = timestamp;
+    event.Duration = duration;
+    event.Bit = (uint8_t)bit;
+    event.Press = press;
+    event.Chatter = chatter;
+    if (m_Events.size() < MaxEvents)
+        m_Events.push_back(event);
+    else
+        m_Events[m_EventCount % MaxEvents] = event;
+    m_EventCount++;
+}
+
+void GD::ButtonEdges::FinishChord()
+{
+    if (std::bitset<16>(m_Chord).count() >= 2 && m_ChordTogether)
+    {
+        auto it = std::find_if(m_Chords.begin(), m_Chords.end(), [this](const ChordStats& chord) { return chord.Buttons == m_Chord; });
+        if (it == m_Chords.end())
+        {
+            m_Chords.emplace_back();
+            it = m_Chords.end() - 1;
+            it->Buttons = m_Chord;
+        }
+        uint64_t spread = m_ChordLast - m_ChordStart;
+        it->Count++;
+        it->TotalSpread += spread;
+        it->MaxSpread = std::max(it->MaxSpread, spread);
+    }
+    m_Chord = 0;
+    m_ChordTogether = false;
+}
+
+void GD::ButtonEdges::Add(uint64_t timestamp, uint16_t buttons)
+{
+    if (!m_Started)
+    {
+        m_Started = true;
+        m_Last = buttons;
+        m_Known = (uint16_t)~buttons;
+        return;
+    }
+
+    // Every edge of all buttons at once
+    uint16_t changed = m_Last ^ buttons;
+    uint16_t pressed = changed & buttons;
+    m_Last = buttons;
+
+    if (m_Chord && timestamp - m_ChordStart > m_ChordWindow)
+        FinishChord();
+    if (pressed)
+    {
+        if (!m_Chord)
+            m_ChordStart = timestamp;
+        m_Chord |= pressed;
+        m_ChordLast = timestamp;
+    }
+    if (m_Chord && (buttons & m_Chord) == m_Chord)
+        m_ChordTogether = true;
+
+    for (uint16_t bits = changed; bits; bits &= bits - 1)
+    {
+        int bit = GD::LowestBit(bits);
+        ButtonStats& stats = m_Stats[bit];
+        bool chatter = m_LastEdge[bit] && timestamp - m_LastEdge[bit] < m_ChatterWindow;
+        m_LastEdge[bit] = timestamp;
+        stats.Chatter += chatter;
+
+        if ((buttons >> bit) & 1)
+        {
+            m_PressedAt[bit] = timestamp;
+            uint64_t* times = m_PressTimes[bit];
+            times[stats.Presses % RateHistory] = timestamp;
+            stats.Presses++;
+            stats.PeakRate = std::max(stats.PeakRate, Rate(bit, timestamp));
+            Event(timestamp, bit, true, chatter, 0);
+        }
+        else
+        {
+            uint64_t duration = 0;
+            if ((m_Known >> bit) & 1)
+            {
+                duration = timestamp - m_PressedAt[bit];
+                stats.Releases++;
+                stats.TotalHeld += duration;
+                stats.MinHold = std::min(stats.MinHold, duration);
+                stats.MaxHold = std::max(stats.MaxHold, duration);
+                stats.Holds[HoldBucket(duration)]++;
+            }
+            Event(timestamp, bit, false, chatter, duration);
+        }
+    }
+    m_Known |= changed;
+}
+
+uint32_t GD::ButtonEdges::Rate(int bit, uint64_t now) const
+{
+    const ButtonStats& stats = m_Stats[bit];
+    uint64_t available = std::min<uint64_t>(stats.Presses, RateHistory);
+    uint32_t rate = 0;
+    for (uint64_t n = 0; n < available; ++n)
+    {
+        uint64_t when = m_PressTimes[bit][(stats.Presses - 1 - n) % RateHistory];
+        if (when > now || now - when >= 1000000)
+            break;
+        rate++;
+    }
+    return rate;
+}
+
+std::vector<GD::ChordStats> GD::ButtonEdges::Chords() const
+{
+    std::vector<ChordStats> chords = m_Chords;
+    std::sort(chords.begin(), chords.end(), [](const ChordStats& a, const ChordStats& b) { return a.Count > b.Count; });
+    return chords;
+}
+
+std::vector<GD::ButtonEvent> GD::ButtonEdges::Events() const
+{
+    if (m_Events.size() < MaxEvents)
+        return m_Events;
+    std::vector<ButtonEvent> events;
+    events.reserve(MaxEvents);
+    for (size_t n = 0; n < MaxEvents; ++n)
+        events.push_back(m_Events[(m_EventCount + n) % MaxEvents]);
+    return events;
+}
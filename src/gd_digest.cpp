@@ -0,0 +1,158 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Mergeable quantile sketch for timing measurements
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_digest.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+constexpr double BufferFactor = 5.0;        // Values buffered per unit of compression before they are merged
+constexpr double Pi = 3.14159265358979323846;
+
+
+GD::Digest::Digest(double compression)
+    : m_Compression(compression)
+{
+    Clear();
+}
+
+void GD::Digest::Clear()
+{
+    m_Min = std::numeric_limits<double>::infinity();
+    m_Max = -std::numeric_limits<double>::infinity();
+    m_Total = 0.0;
+    m_BufferWeight = 0.0;
+    m_Centroids.clear();
+    m_Buffer.clear();
+    m_Buffer.reserve((size_t)(m_Compression * BufferFactor) + (size_t)m_Compression);
+}
+
+void GD::Digest::Add(double value, double weight)
+{
+    if (!(weight > 0.0) || std::isnan(value))
+        return;
+    m_Min = std::min(m_Min, value);
+    m_Max = std::max(m_Max, value);
+    m_Buffer.push_back({ value, weight });
+    m_BufferWeight += weight;
+    if (m_Buffer.size() >= (size_t)(m_Compression * BufferFactor))
+        Compress();
+}
+
+void GD::Digest::Merge(const Digest& other)
+{
+    if (&other == this)
+    {
+        Digest copy = other;
+        Merge(copy);
+        return;
+    }
+    other.Compress();
+    if (other.m_Centroids.empty())
+        return;
+    m_Min = std::min(m_Min, other.m_Min);
+    m_Max = std::max(m_Max, other.m_Max);
+    for (const auto& centroid : other.m_Centroids)
+    {
+        m_Buffer.push_back(centroid);
+        m_BufferWeight += centroid.Weight;
+        if (m_Buffer.size() >= (size_t)(m_Compression * BufferFactor))
+            Compress();
+    }
+}
+
+void GD::Digest::Compress() const
+{
+    if (m_Buffer.empty())
+        return;
+
+    m_Buffer.insert(m_Buffer.end(), m_Centroids.begin(), m_Centroids.end());
+    std::sort(m_Buffer.begin(), m_Buffer.end(), [](const Centroid& a, const Centroid& b)
+        {
+            return a.Mean < b.Mean;
+        });
+    m_Total += m_BufferWeight;
+    m_BufferWeight = 0.0;
+
+    // k(q) = compression / (2 pi) * asin(2q - 1), a centroid may span at most one unit of k
+    auto scale = [this](double q) { return m_Compression / (2 * Pi) * std::asin(2 * q - 1); };
+    auto inverse = [this](double k) { return k >= m_Compression / 4 ? 1.0 : (std::sin(k * 2 * Pi / m_Compression) + 1) / 2; };
+
+    m_Centroids.clear();
+    m_Centroids.push_back(m_Buffer[0]);
+    double before = 0.0;
+    double limit = m_Total * inverse(scale(0.0) + 1);
+    for (size_t n = 1; n < m_Buffer.size(); ++n)
+    {
+        Centroid& last = m_Centroids.back();
+        const Centroid& next = m_Buffer[n];
+        if (before + last.Weight + next.Weight <= limit)
+        {
+            last.Weight += next.Weight;
+            last.Mean += (next.Mean - last.Mean) * next.Weight / last.Weight;
+        }
+        else
+        {
+            before += last.Weight;
+            limit = m_Total * inverse(scale(before / m_Total) + 1);
+            m_Centroids.push_back(next);
+        }
+    }
+    m_Buffer.clear();
+}
+
+double GD::Digest::Quantile(double q) const
+{
+    Compress();
+    if (m_Centroids.empty())
+        return std::numeric_limits<double>::quiet_NaN();
+    if (m_Centroids.size() == 1 || q <= 0.0)
+        return q <= 0.0 ? m_Min : m_Centroids[0].Mean;
+    if (q >= 1.0)
+        return m_Max;
+
+    // Every centroid sits at the middle of its weight, between them and towards min and max the values are interpolated
+    double index = q * m_Total;
+    const Centroid& first = m_Centroids.front();
+    if (index < first.Weight / 2)
+        return m_Min + (first.Mean - m_Min) * index / (first.Weight / 2);
+
+    double position = first.Weight / 2;
+    for (size_t n = 0; n + 1 < m_Centroids.size(); ++n)
+    {
+        const Centroid& left = m_Centroids[n];
+        const Centroid& right = m_Centroids[n + 1];
+        double span = (left.Weight + right.Weight) / 2;
+        if (index < position + span)
+        {
+            // Single values are exact, do not smear them over the gap
+            if (left.Weight == 1.0 && index - position < 0.5)
+                return left.Mean;
+            if (right.Weight == 1.0 && position + span - index <= 0.5)
+                return right.Mean;
+            return left.Mean + (right.Mean - left.Mean) * (index - position) / span;
+        }
+        position += span;
+    }
+
+    const Centroid& last = m_Centroids.back();
+    double rest = m_Total - position;
+    return rest > 0 ? last.Mean + (m_Max - last.Mean) * std::min(1.0, (index - position) / rest) : m_Max;
+}
+
+double GD::Digest::Mean() const
+{
+    Compress();
+    double sum = 0.0;
+    for (const auto& centroid : m_Centroids)
+        sum += centroid.Mean * centroid.Weight;
+    return m_Total > 0 ? sum / m_Total : std::numeric_limits<double>::quiet_NaN();
+}
+
+size_t GD::Digest::Centroids() const
+{
+    Compress();
+    return m_Centroids.size();
+}
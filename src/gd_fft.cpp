@@ -0,0 +1,77 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Fast Fourier transform for signal analysis
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_fft.h"
+#include <cmath>
+#include <utility>
+
+
+GD::Fft::Fft(size_t size)
+    : m_Size(size)
+    , m_Twiddles(size / 2)
+    , m_Reverse(size)
+{
+    const double pi = 3.14159265358979323846;
+    for (size_t n = 0; n < size / 2; ++n)
+        m_Twiddles[n] = std::polar(1.0, -2.0 * pi * (double)n / (double)size);
+
+    int bits = 0;
+    while (((size_t)1 << bits) < size)
+        bits++;
+    for (size_t n = 0; n < size; ++n)
+    {
+        size_t reversed = 0;
+        for (int bit = 0; bit < bits; ++bit)
+            reversed |= ((n >> bit) & 1) << (bits - 1 - bit);
+        m_Reverse[n] = reversed;
+    }
+}
+
+size_t GD::Fft::NextSize(size_t count)
+{
+    size_t size = 1;
+    while (size < count)
+        size <<= 1;
+    return size;
+}
+
+void GD::Fft::Forward(std::complex<double>* data) const
+{
+    Transform(data, false);
+}
+
+void GD::Fft::Inverse(std::complex<double>* data) const
+{
+    Transform(data, true);
+    double scale = 1.0 / (double)m_Size;
+    for (size_t n = 0; n < m_Size; ++n)
+        data[n] *= scale;
+}
+
+void GD::Fft::Transform(std::complex<double>* data, bool inverse) const
+{
+    for (size_t n = 0; n < m_Size; ++n)
+    {
+        if (n < m_Reverse[n])
+            std::swap(data[n], data[m_Reverse[n]]);
+    }
+
+    for (size_t half = 1; half < m_Size; half <<= 1)
+    {
+        size_t stride = m_Size / (half * 2);
+        for (size_t start = 0; start < m_Size; start += half * 2)
+        {
+            for (size_t n = 0; n < half; ++n)
+            {
+                std::complex<double> twiddle = m_Twiddles[n * stride];
+                if (inverse)
+                    twiddle = std::conj(twiddle);
+                std::complex<double> odd = data[start + n + half] * twiddle;
+                data[start + n + half] = data[start + n] - odd;
+                data[start + n] += odd;
+            }
+        }
+    }
+}
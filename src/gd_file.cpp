@@ -0,0 +1,123 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Platform independent file helpers
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_file.h"
+
+#ifdef _WIN32
+#include "gd_win32.h"
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+FILE* GD::OpenFile(const char* path, const char* mode)
+{
+#ifdef _MSC_VER
+    FILE* file = nullptr;
+    if (fopen_s(&file, path, mode) != 0)
+        return nullptr;
+    return file;
+#else
+    return fopen(path, mode);
+#endif
+}
+
+bool GD::SyncFile(FILE* file)
+{
+    if (fflush(file) != 0)
+        return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool GD::TruncateFile(FILE* file, uint64_t size)
+{
+    if (fflush(file) != 0)
+        return false;
+#ifdef _WIN32
+    return _chsize_s(_fileno(file), (__int64)size) == 0;
+#else
+    return ftruncate(fileno(file), (off_t)size) == 0;
+#endif
+}
+
+bool GD::MappedFile::Open(const char* path)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    m_File = file;
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+
+    m_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_Mapping)
+    {
+        Close();
+        return false;
+    }
+    m_Data = (const uint8_t*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+    m_Size = (size_t)size.QuadPart;
+#else
+    m_Fd = open(path, O_RDONLY);
+    if (m_Fd < 0)
+        return false;
+
+    struct stat st {};
+    if (fstat(m_Fd, &st) != 0 || st.st_size == 0)
+    {
+        Close();
+        return false;
+    }
+
+    void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, m_Fd, 0);
+    m_Data = (data == MAP_FAILED) ? nullptr : (const uint8_t*)data;
+    m_Size = (size_t)st.st_size;
+#endif
+
+    if (!m_Data)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void GD::MappedFile::Close()
+{
+#ifdef _WIN32
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+        CloseHandle(m_Mapping);
+    if (m_File)
+        CloseHandle(m_File);
+    m_Mapping = nullptr;
+    m_File = nullptr;
+#else
+    if (m_Data)
+        munmap((void*)m_Data, m_Size);
+    if (m_Fd >= 0)
+        close(m_Fd);
+    m_Fd = -1;
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+}
@@ -0,0 +1,163 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Recent samples of every device, one ring per channel
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_history.h"
+#include <algorithm>
+
+
+GD::HistoryStore::HistoryStore(size_t budget)
+    : m_Budget(budget)
+{
+}
+
+void GD::HistoryStore::SetBudget(size_t budget)
+{
+    m_Budget = budget;
+    Resize();
+}
+
+GD::HistoryStore::DeviceRings* GD::HistoryStore::Find(uint16_t id)
+{
+    for (auto& device : m_Devices)
+    {
+        if (device.Info.Id == id)
+            return &device;
+    }
+    return nullptr;
+}
+
+const GD::HistoryStore::DeviceRings* GD::HistoryStore::Find(uint16_t id) const
+{
+    return const_cast<HistoryStore*>(this)->Find(id);
+}
+
+// The largest power of two that fits the budget for every device, the newest samples survive the move
+void GD::HistoryStore::Resize()
+{
+    size_t perDevice = m_Budget / (BytesPerSample * std::max<size_t>(m_Devices.size(), 1));
+    size_t capacity = MinCapacity;
+    while (capacity * 2 <= perDevice)
+        capacity *= 2;
+
+    for (auto& device : m_Devices)
+    {
+        if (device.Timestamps.size() == capacity)
+            continue;
+
+        size_t oldCapacity = device.Timestamps.size();
+        uint64_t kept = std::min<uint64_t>({ device.Head, (uint64_t)oldCapacity, (uint64_t)capacity });
+        uint64_t first = device.Head - kept;
+        auto move = [&](auto& ring)
+            {
+                std::remove_reference_t<decltype(ring)> resized(capacity);
+                for (uint64_t n = 0; n < kept; ++n)
+                    resized[(size_t)n] = ring[(size_t)((first + n) & (oldCapacity - 1))];
+                ring.swap(resized);
+            };
+        move(device.Timestamps);
+        move(device.Buttons);
+        for (auto& axis : device.Axes)
+            move(axis);
+        device.Head = kept;
+    }
+    m_Capacity = capacity;
+}
+
+void GD::HistoryStore::AddDevice(const DeviceInfo& info)
+{
+    if (DeviceRings* device = Find(info.Id))
+    {
+        device->Info = info;
+        device->Head = 0;
+        return;
+    }
+    m_Devices.emplace_back();
+    m_Devices.back().Info = info;
+    Resize();
+}
+
+void GD::HistoryStore::RemoveDevice(uint16_t id)
+{
+    auto it = std::find_if(m_Devices.begin(), m_Devices.end(), [id](const DeviceRings& device) { return device.Info.Id == id; });
+    if (it == m_Devices.end())
+        return;
+    m_Devices.erase(it);
+    Resize();
+}
+
+void GD::HistoryStore::Append(const Sample& sample)
+{
+    DeviceRings* device = Find(sample.Device);
+    if (!device)
+        return;
+    size_t index = (size_t)(device->Head++ & (m_Capacity - 1));
+    device->Timestamps[index] = sample.Timestamp;
+    device->Buttons[index] = sample.Buttons;
+    for (int axis = 0; axis < Axis_Count; ++axis)
+        device->Axes[axis][index] = (int16_t)GetAxis(sample, axis);
+}
+
+void GD::HistoryStore::Clear(uint16_t id)
+{
+    if (DeviceRings* device = Find(id))
+        device->Head = 0;
+}
+
+uint64_t GD::HistoryStore::Written(uint16_t id) const
+{
+    const DeviceRings* device = Find(id);
+    return device ? device->Head : 0;
+}
+
+bool GD::HistoryStore::Span(uint16_t id, uint64_t since, HistorySpan& span) const
+{
+    span = {};
+    const DeviceRings* device = Find(id);
+    if (!device)
+        return false;
+
+    // The timestamps only go up, so the start is found by bisecting the ring
+    uint64_t oldest = device->Head > m_Capacity ? device->Head - m_Capacity : 0;
+    uint64_t low = oldest, high = device->Head;
+    while (low < high)
+    {
+        uint64_t middle = low + (high - low) / 2;
+        if (device->Timestamps[(size_t)(middle & (m_Capacity - 1))] <= since)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    uint64_t first = low > oldest ? low - 1 : oldest;
+
+    // Split where the ring wraps
+    size_t start = (size_t)(first & (m_Capacity - 1));
+    size_t count = (size_t)(device->Head - first);
+    span.Count[0] = std::min(count, m_Capacity - start);
+    span.Count[1] = count - span.Count[0];
+    size_t offsets[2] = { start, 0 };
+    for (int part = 0; part < 2; ++part)
+    {
+        span.Timestamps[part] = device->Timestamps.data() + offsets[part];
+        span.Buttons[part] = device->Buttons.data() + offsets[part];
+        for (int axis = 0; axis < Axis_Count; ++axis)
+            span.Axes[axis][part] = device->Axes[axis].data() + offsets[part];
+    }
+    return true;
+}
+
+bool GD::HistoryStore::Latest(uint16_t id, Sample& sample) const
+{
+    const DeviceRings* device = Find(id);
+    if (!device || !device->Head)
+        return false;
+    size_t index = (size_t)((device->Head - 1) & (m_Capacity - 1));
+    sample = {};
+    sample.Device = id;
+    sample.Timestamp = device->Timestamps[index];
+    sample.Buttons = device->Buttons[index];
+    for (int axis = 0; axis < Axis_Count; ++axis)
+        SetAxis(sample, axis, device->Axes[axis][index]);
+    return true;
+}
@@ -4,7 +4,10 @@
 // COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
 
 #include "imgui.h"
+#include "gd_sample.h"
+#include "modules/gd_Recorder.h"
 #include <mutex>
+#include <string>
 
 using std::mutex;
 using std::unique_lock;
@@ -16,17 +19,21 @@ static ImVector<int> s_LineOffsets;
 
 void GD_Log(const char* fmt, ...)
 {
-    int old_size = s_Buf.size();
-
+    uint64_t timestamp = GD::Now();
     unique_lock<mutex> lock(s_Mutex);
 
+    int old_size = s_Buf.size();
     s_Buf.appendf("%7.1f | ", ImGui::GetTime());
 
+    int message = s_Buf.size();
     va_list args;
     va_start(args, fmt);
     s_Buf.appendfv(fmt, args);
     va_end(args);
 
+    // Recordings have their own timestamps, so they only get the message
+    std::string text(s_Buf.begin() + message, s_Buf.end());
+
     if (s_LineOffsets.Size == 0)
         s_LineOffsets.push_back(0);
 
@@ -37,6 +44,9 @@ void GD_Log(const char* fmt, ...)
             s_LineOffsets.push_back(old_size + 1);
         }
     }
+
+    lock.unlock();
+    GD::Recorder::Log(timestamp, text.c_str(), text.size());
 }
 
 static void Clear()
@@ -9,20 +9,45 @@
 #include "modules/Notifications.h"
 #include "modules/gd_XInput.h"
 #include "modules/gd_DInput.h"
+#include "modules/gd_AxisStats.h"
+#include "modules/gd_Bench.h"
+#include "modules/gd_Buttons.h"
+#include "modules/gd_Capture.h"
+#include "modules/gd_Crosstalk.h"
+#include "modules/gd_FlightRecorder.h"
+#include "modules/gd_Heatmap.h"
+#include "modules/gd_History.h"
+#include "modules/gd_Motions.h"
+#include "modules/gd_Processing.h"
+#include "modules/gd_Recorder.h"
+#include "modules/gd_Replay.h"
+#include "modules/gd_Resolution.h"
+#include "modules/gd_Scope.h"
+#include "modules/gd_Scripts.h"
+#include "modules/gd_Spectrum.h"
+#include "modules/gd_Timing.h"
+#include "modules/gd_Trail.h"
 #include "fonts/sourcecodepro.h"
 #include "fonts/cf_xbox_one.h"
 
 void GD_Frame()
 {
+    GD::Timing::AddFrame((uint64_t)(ImGui::GetIO().DeltaTime * 1e6));
+
     if (Notifications_DevicesChanged())
     {
+        uint64_t start = GD::Now();
         GD::XInput::EnumerateDevices();
         GD::DInput::EnumerateDevices();
+        GD::Timing::AddEnumeration(GD::Now() - start);
     }
 
     GD::XInput::Update(ImGui::GetTime());
     GD::DInput::Update();
 
+    if (ImGui::IsKeyPressed(ImGuiKey_F9, false))
+        GD::FlightRecorder::Dump("requested");
+
 #if !defined(IMGUI_DISABLE_DEMO_WINDOWS)
     static bool show_demo_window = false;
 
@@ -62,6 +87,19 @@ void GD_Frame()
     ImGui::SetNextWindowPos(pos, ImGuiCond_Always);
     ImGui::SetNextWindowSize(split_height, ImGuiCond_Always);
     GD_FrameLogger();
+
+    GD::Capture::RenderFrame();
+    GD::Spectrum::RenderFrame();
+    GD::AxisStats::RenderFrame();
+    GD::Timing::RenderFrame();
+    GD::Resolution::RenderFrame();
+    GD::Crosstalk::RenderFrame();
+    GD::Buttons::RenderFrame();
+    GD::Motions::RenderFrame();
+    GD::Scripts::RenderFrame();
+    GD::Bench::RenderFrame();
+    GD::Processing::RenderFrame();
+    GD::Replay::RenderFrame();
 }
 
 void GD_Init()
@@ -69,6 +107,8 @@ void GD_Init()
     ImGuiIO& io = ImGui::GetIO();
     SC_AddFont(io.Fonts);
 
+    // Before anything else, so it also sees the log output of the other modules
+    GD::FlightRecorder::Init();
     Notifications_Init();
     GD::XInput::Init();
     GD::DInput::Init();
@@ -77,7 +117,24 @@ void GD_Init()
 
 void GD_Shutdown()
 {
-    GD::DInput::Shutdown();
+    // Stop the sampling thread before the modules it feeds
     GD::XInput::Shutdown();
+    GD::Replay::Shutdown();
+    GD::Capture::Shutdown();
+    GD::Spectrum::Shutdown();
+    GD::AxisStats::Shutdown();
+    GD::Timing::Shutdown();
+    GD::Resolution::Shutdown();
+    GD::Crosstalk::Shutdown();
+    GD::Buttons::Shutdown();
+    GD::Motions::Shutdown();
+    GD::Scripts::Shutdown();
+    GD::Bench::Shutdown();
+    GD::Heatmap::Shutdown();
+    GD::Trail::Shutdown();
+    GD::History::Shutdown();
+    GD::Recorder::Shutdown();
+    GD::DInput::Shutdown();
     Notifications_Shutdown();
+    GD::FlightRecorder::Shutdown();
 }
@@ -0,0 +1,328 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Fighting game motion inputs in numpad notation, matched against the sample stream
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_motion.h"
+#include "gd_sample.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+#ifndef M_PI
+#define M_PI       3.14159265358979323846
+#endif
+
+
+int GD::NumpadDirection(int32_t x, int32_t y, float deadzone)
+{
+    float magnitude = sqrtf(x * (float)x + y * (float)y);
+    if (magnitude < deadzone)
+        return 5;
+
+    float direction = atan2f((float)y, (float)x);
+    if (direction < 0.0f)
+        direction += 2.0f * (float)M_PI;
+    float angle = direction * (180.0f / (float)M_PI);
+    if (angle < 22.5f || angle >= 337.5f)
+        return 6;
+    else if (angle < 67.5f)
+        return 9;
+    else if (angle < 112.5f)
+        return 8;
+    else if (angle < 157.5f)
+        return 7;
+    else if (angle < 202.5f)
+        return 4;
+    else if (angle < 247.5f)
+        return 1;
+    else if (angle < 292.5f)
+        return 2;
+    return 3;
+}
+
+int GD::DPadDirection(uint16_t buttons)
+{
+    int x = !!(buttons & Button_DPadRight) - !!(buttons & Button_DPadLeft);
+    int y = !!(buttons & Button_DPadUp) - !!(buttons & Button_DPadDown);
+    return 5 + x + 3 * y;
+}
+
+
+// Every direction that points the same way as the charge direction, so down-back also charges back
+static uint16_t ChargeDirections(int charge)
+{
+    int cx = (charge - 1) % 3 - 1, cy = (charge - 1) / 3 - 1;
+    uint16_t directions = 0;
+    for (int direction = 1; direction <= 9; ++direction)
+    {
+        int x = (direction - 1) % 3 - 1, y = (direction - 1) / 3 - 1;
+        if ((!cx || x == cx) && (!cy || y == cy))
+            directions |= (uint16_t)(1 << direction);
+    }
+    return directions;
+}
+
+bool GD::CompileMotion(const char* name, const char* notation, double frameRate, Motion& motion, std::string& error)
+{
+    motion = {};
+    motion.Name = name;
+    motion.Notation = notation;
+    motion.FrameRate = frameRate;
+    if (!(frameRate > 0))
+    {
+        error = "The frame rate has to be positive";
+        return false;
+    }
+    auto frames = [frameRate](double count) { return (uint64_t)llround(count * 1e6 / frameRate); };
+
+    bool plink = false;
+    const char* p = notation;
+    while (*p)
+    {
+        if (isspace((unsigned char)*p))
+        {
+            ++p;
+            continue;
+        }
+        if (*p == '/')
+        {
+            char* end;
+            double count = strtod(p + 1, &end);
+            if (motion.Steps.empty() || end == p + 1 || !(count > 0))
+            {
+                error = "Expected a step and then the number of frames, like '6/4'";
+                return false;
+            }
+            motion.Steps.back().Window = frames(count);
+            p = end;
+            continue;
+        }
+        if (*p == '~')
+        {
+            if (motion.Steps.empty() || !motion.Steps.back().Buttons || plink)
+            {
+                error = "'~' goes between two buttons";
+                return false;
+            }
+            plink = true;
+            ++p;
+            continue;
+        }
+
+        MotionStep step;
+        step.Window = frames(StepWindowFrames);
+        const char* start = p;
+        if (*p >= '1' && *p <= '9')
+        {
+            step.Directions = (uint16_t)(1 << (*p - '0'));
+            ++p;
+        }
+        else if (*p == '[')
+        {
+            int charge = p[1] - '0';
+            double count = ChargeFrames;
+            p += 2;
+            if (*p == ':')
+            {
+                char* end;
+                count = strtod(p + 1, &end);
+                p = end;
+            }
+            if (charge < 1 || charge > 9 || charge == 5 || *p != ']' || !(count > 0))
+            {
+                error = "Expected a charge like '[4]' or '[2:30]'";
+                return false;
+            }
+            ++p;
+            step.Directions = ChargeDirections(charge);
+            step.Charge = frames(count);
+        }
+        else if (isalpha((unsigned char)*p))
+        {
+            while (isalnum((unsigned char)*p) || *p == '_')
+                ++p;
+            std::string token(start, p);
+            step.Buttons = GD::FindButton(token);
+            if (!step.Buttons)
+            {
+                error = "Unknown button '" + token + "'";
+                return false;
+            }
+            if (plink)
+            {
+                step.Window = frames(PlinkWindowFrames);
+                step.MinGap = 1;
+            }
+        }
+        else
+        {
+            error = std::string("Unexpected '") + *p + "'";
+            return false;
+        }
+
+        if (plink && !step.Buttons)
+        {
+            error = "'~' goes between two buttons";
+            return false;
+        }
+        if (motion.Steps.size() == Motion::MaxSteps)
+        {
+            error = "A motion has at most 16 steps";
+            return false;
+        }
+        step.Label.assign(start, p);
+        if (plink)
+            step.Label = "~" + step.Label;
+        plink = false;
+        motion.Steps.push_back(step);
+    }
+    if (plink)
+    {
+        error = "'~' goes between two buttons";
+        return false;
+    }
+    if (motion.Steps.empty())
+    {
+        error = "Empty motion";
+        return false;
+    }
+
+    // The transitions of the automaton: the steps each input symbol can reach
+    for (size_t n = 0; n < motion.Steps.size(); ++n)
+    {
+        const MotionStep& step = motion.Steps[n];
+        uint16_t bit = (uint16_t)(1 << n);
+        if (step.Charge)
+        {
+            motion.ChargeSteps |= bit;
+            continue;
+        }
+        for (int direction = 1; direction <= 9; ++direction)
+        {
+            if ((step.Directions >> direction) & 1)
+                motion.Accepts[direction - 1] |= bit;
+        }
+        for (int button = 0; button < 16; ++button)
+        {
+            if ((step.Buttons >> button) & 1)
+                motion.Accepts[9 + button] |= bit;
+        }
+    }
+    return true;
+}
+
+
+void GD::MotionRecognizer::SetMotions(const std::vector<Motion>& motions)
+{
+    m_Motions = motions;
+    Clear();
+}
+
+void GD::MotionRecognizer::Clear()
+{
+    m_States.assign(m_Motions.size(), State());
+    m_Started = false;
+    m_Direction = 5;
+    m_Buttons = 0;
+}
+
+void GD::MotionRecognizer::Step(size_t index, uint16_t symbolSteps, uint64_t timestamp, std::vector<MotionMatch>& matches)
+{
+    const Motion& motion = m_Motions[index];
+    State& state = m_States[index];
+
+    // Every step whose previous step was reached, all of them in one go
+    uint16_t candidates = symbolSteps & (uint16_t)((state.Reached << 1) | 1);
+    if (!candidates)
+        return;
+
+    // From the last step down, so each step still sees the time of the step before it from before this event
+    for (int k = (int)motion.Steps.size() - 1; k >= 0; --k)
+    {
+        if (!((candidates >> k) & 1))
+            continue;
+        if (k)
+        {
+            uint64_t gap = timestamp - state.Times[k - 1][k - 1];
+            if (gap > motion.Steps[k].Window)
+            {
+                // Time only goes on, so this partial match can not continue anymore
+                state.Reached &= (uint16_t)~(1 << (k - 1));
+                continue;
+            }
+            if (gap < motion.Steps[k].MinGap)
+                continue;
+            std::copy(state.Times[k - 1], state.Times[k - 1] + k, state.Times[k]);
+        }
+        state.Times[k][k] = timestamp;
+
+        if (k + 1 == (int)motion.Steps.size())
+        {
+            MotionMatch match;
+            match.Motion = (uint16_t)index;
+            match.Steps = (uint8_t)motion.Steps.size();
+            std::copy(state.Times[k], state.Times[k] + motion.Steps.size(), match.Times);
+            matches.push_back(match);
+            // One motion, one match: a second press of the button does not complete it again
+            state.Reached = 0;
+            return;
+        }
+        state.Reached |= (uint16_t)(1 << k);
+    }
+}
+
+void GD::MotionRecognizer::Add(uint64_t timestamp, int direction, uint16_t buttons, std::vector<MotionMatch>& matches)
+{
+    if (direction < 1 || direction > 9)
+        direction = 5;
+
+    if (!m_Started)
+    {
+        // Directions that are already held start charging now
+        m_Started = true;
+        m_Direction = direction;
+        m_Buttons = buttons;
+        for (size_t n = 0; n < m_Motions.size(); ++n)
+        {
+            for (size_t k = 0; k < m_Motions[n].Steps.size(); ++k)
+                m_States[n].ChargeSince[k] = timestamp;
+        }
+        return;
+    }
+
+    if (direction != m_Direction)
+    {
+        for (size_t n = 0; n < m_Motions.size(); ++n)
+        {
+            const Motion& motion = m_Motions[n];
+            State& state = m_States[n];
+
+            // A charge is released before the new direction is handled, so the next step can use the same sample
+            uint16_t released = 0;
+            for (uint16_t bits = motion.ChargeSteps; bits; bits &= bits - 1)
+            {
+                int k = GD::LowestBit(bits);
+                uint16_t directions = motion.Steps[k].Directions;
+                bool was = (directions >> m_Direction) & 1, is = (directions >> direction) & 1;
+                if (was && !is && timestamp - state.ChargeSince[k] >= motion.Steps[k].Charge)
+                    released |= (uint16_t)(1 << k);
+                else if (!was && is)
+                    state.ChargeSince[k] = timestamp;
+            }
+            if (released)
+                Step(n, released, timestamp, matches);
+            Step(n, motion.Accepts[direction - 1], timestamp, matches);
+        }
+        m_Direction = direction;
+    }
+
+    for (uint16_t pressed = buttons & ~m_Buttons; pressed; pressed &= pressed - 1)
+    {
+        int bit = GD::LowestBit(pressed);
+        for (size_t n = 0; n < m_Motions.size(); ++n)
+            Step(n, m_Motions[n].Accepts[9 + bit], timestamp, matches);
+    }
+    m_Buttons = buttons;
+}
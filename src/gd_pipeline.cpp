@@ -0,0 +1,296 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Deadzones, response curves and filters, the way a game processes the input
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_pipeline.h"
+#include <algorithm>
+#include <cmath>
+
+// Every platform we build for is x86, the scalar loops are only used for what is left after the last group of four
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define GD_PIPELINE_SSE2
+#include <emmintrin.h>
+#endif
+
+constexpr float Pi = 3.14159265358979f;
+constexpr float Tiny = 1e-6f;                               // Below this a stick is at the center
+
+
+const char* GD::StageName(int type)
+{
+    static const char* names[Stage_Count] = { "Calibration", "Axial deadzone", "Radial deadzone", "Scaled radial deadzone", "Anti-deadzone", "Response curve", "One-Euro filter" };
+    return (type >= 0 && type < Stage_Count) ? names[type] : "?";
+}
+
+GD::Stage GD::DefaultStage(StageType type)
+{
+    Stage stage;
+    stage.Type = type;
+    switch (type)
+    {
+    case Stage_AxialDeadzone:
+    case Stage_RadialDeadzone:
+        stage.Inner = 0.24f;
+        break;
+    case Stage_ScaledRadialDeadzone:
+        stage.Inner = 0.24f;
+        stage.Outer = 0.95f;
+        break;
+    case Stage_AntiDeadzone:
+        stage.Inner = 0.2f;
+        break;
+    case Stage_Curve:
+        stage.Shape = 0.5f;
+        break;
+    default:
+        break;
+    }
+    return stage;
+}
+
+void GD::NormalizeAxis(const int16_t* values, size_t count, float scale, float* output)
+{
+    size_t n = 0;
+#ifdef GD_PIPELINE_SSE2
+    const __m128 factor = _mm_set1_ps(scale);
+    for (; n + 8 <= count; n += 8)
+    {
+        // Sign extend by putting every value in the top half of a 32 bit lane, and shifting it back down
+        __m128i words = _mm_loadu_si128((const __m128i*)(values + n));
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16);
+        _mm_storeu_ps(output + n, _mm_mul_ps(_mm_cvtepi32_ps(low), factor));
+        _mm_storeu_ps(output + n + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), factor));
+    }
+#endif
+    for (; n < count; ++n)
+        output[n] = values[n] * scale;
+}
+
+
+// The shapes map a distance from the center to a new one, for four lanes and for a single value.
+// Radial scales x and y with the ratio, so the direction is kept. Axial runs the shape on each value with its sign.
+
+template<typename Shape>
+static void Radial(float* x, float* y, size_t count, const Shape& shape)
+{
+    size_t n = 0;
+#ifdef GD_PIPELINE_SSE2
+    const __m128 tiny = _mm_set1_ps(Tiny);
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + n);
+        __m128 vy = _mm_loadu_ps(y + n);
+        __m128 m = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+        // The mask keeps the center at 0, and 0 / 0 out of the result
+        __m128 factor = _mm_and_ps(_mm_cmpgt_ps(m, tiny), _mm_div_ps(shape(m), _mm_max_ps(m, tiny)));
+        _mm_storeu_ps(x + n, _mm_mul_ps(vx, factor));
+        _mm_storeu_ps(y + n, _mm_mul_ps(vy, factor));
+    }
+#endif
+    for (; n < count; ++n)
+    {
+        float m = std::sqrt(x[n] * x[n] + y[n] * y[n]);
+        float factor = m > Tiny ? shape(m) / m : 0.f;
+        x[n] *= factor;
+        y[n] *= factor;
+    }
+}
+
+template<typename Shape>
+static void Axial(float* values, size_t count, const Shape& shape)
+{
+    size_t n = 0;
+#ifdef GD_PIPELINE_SSE2
+    const __m128 signBit = _mm_set1_ps(-0.f);
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128 v = _mm_loadu_ps(values + n);
+        __m128 magnitude = _mm_andnot_ps(signBit, v);
+        _mm_storeu_ps(values + n, _mm_or_ps(shape(magnitude), _mm_and_ps(signBit, v)));
+    }
+#endif
+    for (; n < count; ++n)
+        values[n] = std::copysign(shape(std::fabs(values[n])), values[n]);
+}
+
+// Zero inside, unchanged up to full scale
+struct DeadzoneShape
+{
+    float Inner;
+
+    float operator()(float m) const { return m < Inner ? 0.f : std::min(m, 1.f); }
+#ifdef GD_PIPELINE_SSE2
+    __m128 operator()(__m128 m) const { return _mm_and_ps(_mm_cmpge_ps(m, _mm_set1_ps(Inner)), _mm_min_ps(m, _mm_set1_ps(1.f))); }
+#endif
+};
+
+// From 0 at the inner edge to full scale at the outer one
+struct ScaledDeadzoneShape
+{
+    float Inner;
+    float Scale;
+
+    float operator()(float m) const { return std::clamp((m - Inner) * Scale, 0.f, 1.f); }
+#ifdef GD_PIPELINE_SSE2
+    __m128 operator()(__m128 m) const
+    {
+        __m128 scaled = _mm_mul_ps(_mm_sub_ps(m, _mm_set1_ps(Inner)), _mm_set1_ps(Scale));
+        return _mm_min_ps(_mm_max_ps(scaled, _mm_setzero_ps()), _mm_set1_ps(1.f));
+    }
+#endif
+};
+
+// Anything off the center starts at the inner edge, the center itself is kept by the mask
+struct AntiDeadzoneShape
+{
+    float Inner;
+
+    float operator()(float m) const { return std::min(Inner + m * (1.f - Inner), 1.f); }
+#ifdef GD_PIPELINE_SSE2
+    __m128 operator()(__m128 m) const
+    {
+        return _mm_min_ps(_mm_add_ps(_mm_set1_ps(Inner), _mm_mul_ps(m, _mm_set1_ps(1.f - Inner))), _mm_set1_ps(1.f));
+    }
+#endif
+};
+
+// A blend towards m^3 (fine near the center) or towards 1 - (1 - m)^3 (fast off the center),
+// both weights are computed up front so the kernel has no branch for the sign of the shape
+struct CurveShape
+{
+    float Fine;
+    float Fast;
+
+    float operator()(float m) const
+    {
+        float c = std::min(m, 1.f);
+        float u = 1.f - c;
+        return c + Fine * (c * c * c - c) + Fast * (1.f - u * u * u - c);
+    }
+#ifdef GD_PIPELINE_SSE2
+    __m128 operator()(__m128 m) const
+    {
+        const __m128 one = _mm_set1_ps(1.f);
+        __m128 c = _mm_min_ps(m, one);
+        __m128 u = _mm_sub_ps(one, c);
+        __m128 fine = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c, c), c), c);
+        __m128 fast = _mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(_mm_mul_ps(u, u), u)), c);
+        return _mm_add_ps(c, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(Fine), fine), _mm_mul_ps(_mm_set1_ps(Fast), fast)));
+    }
+#endif
+};
+
+static void Calibrate(float* values, size_t count, float center, float gain)
+{
+    size_t n = 0;
+#ifdef GD_PIPELINE_SSE2
+    const __m128 offset = _mm_set1_ps(center);
+    const __m128 factor = _mm_set1_ps(gain);
+    const __m128 low = _mm_set1_ps(-1.f);
+    const __m128 high = _mm_set1_ps(1.f);
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128 v = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + n), offset), factor);
+        _mm_storeu_ps(values + n, _mm_min_ps(_mm_max_ps(v, low), high));
+    }
+#endif
+    for (; n < count; ++n)
+        values[n] = std::clamp((values[n] - center) * gain, -1.f, 1.f);
+}
+
+static float Smoothing(float cutoff, float dt)
+{
+    float tau = 1.f / (2 * Pi * cutoff);
+    return 1.f / (1.f + tau / dt);
+}
+
+
+void GD::AxisPipeline::SetStages(const std::vector<Stage>& stages)
+{
+    m_Stages = stages;
+    Reset();
+}
+
+float GD::AxisPipeline::Deadzone() const
+{
+    for (const auto& stage : m_Stages)
+    {
+        if (stage.Enabled && (stage.Type == Stage_AxialDeadzone || stage.Type == Stage_RadialDeadzone || stage.Type == Stage_ScaledRadialDeadzone))
+            return stage.Inner;
+    }
+    return 0.f;
+}
+
+void GD::AxisPipeline::Reset()
+{
+    m_Filters.assign(m_Stages.size(), FilterState());
+}
+
+void GD::AxisPipeline::Process(const uint64_t* timestamps, float* x, float* y, size_t count)
+{
+    m_Filters.resize(m_Stages.size());
+    for (size_t index = 0; index < m_Stages.size(); ++index)
+    {
+        const Stage& stage = m_Stages[index];
+        if (!stage.Enabled)
+            continue;
+
+        switch (stage.Type)
+        {
+        case Stage_Calibration:
+            Calibrate(x, count, stage.Center[0], stage.Gain[0]);
+            Calibrate(y, count, stage.Center[1], stage.Gain[1]);
+            break;
+        case Stage_AxialDeadzone:
+            Axial(x, count, DeadzoneShape{ stage.Inner });
+            Axial(y, count, DeadzoneShape{ stage.Inner });
+            break;
+        case Stage_RadialDeadzone:
+            Radial(x, y, count, DeadzoneShape{ stage.Inner });
+            break;
+        case Stage_ScaledRadialDeadzone:
+            Radial(x, y, count, ScaledDeadzoneShape{ stage.Inner, 1.f / std::max(stage.Outer - stage.Inner, Tiny) });
+            break;
+        case Stage_AntiDeadzone:
+            Radial(x, y, count, AntiDeadzoneShape{ stage.Inner });
+            break;
+        case Stage_Curve:
+            Radial(x, y, count, CurveShape{ std::max(stage.Shape, 0.f), std::max(-stage.Shape, 0.f) });
+            break;
+        case Stage_OneEuro:
+        {
+            // Every sample depends on the one before it, so this one stays scalar.
+            // Samples are only the changes: over a long gap the filter catches up, like it would have while the value was held.
+            FilterState& state = m_Filters[index];
+            float* values[2] = { x, y };
+            for (size_t n = 0; n < count; ++n)
+            {
+                if (!state.Started)
+                {
+                    state.Started = true;
+                    state.Last = timestamps[n];
+                    state.Value[0] = x[n];
+                    state.Value[1] = y[n];
+                    continue;
+                }
+                float dt = std::max((timestamps[n] - state.Last) / 1e6f, Tiny);
+                state.Last = timestamps[n];
+                float derivativeSmoothing = Smoothing(stage.DerivativeCutoff, dt);
+                for (int axis = 0; axis < 2; ++axis)
+                {
+                    float value = values[axis][n];
+                    state.Derivative[axis] += derivativeSmoothing * ((value - state.Value[axis]) / dt - state.Derivative[axis]);
+                    float cutoff = stage.MinCutoff + stage.Beta * std::fabs(state.Derivative[axis]);
+                    state.Value[axis] += Smoothing(cutoff, dt) * (value - state.Value[axis]);
+                    values[axis][n] = state.Value[axis];
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Effective resolution of an analog axis from the codes it reports
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_resolution.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+
+GD::AxisResolution::AxisResolution(int axis)
+{
+    bool trigger = axis == Axis_LeftTrigger || axis == Axis_RightTrigger;
+    m_CodeCount = trigger ? 256 : 65536;
+    m_Lowest = trigger ? 0 : -32768;
+    m_Seen.resize(m_CodeCount / 64);
+}
+
+void GD::AxisResolution::Clear()
+{
+    std::fill(m_Seen.begin(), m_Seen.end(), 0);
+    std::fill(m_Steps, m_Steps + StepBuckets, 0);
+    m_Last = 0;
+    m_Started = 0;
+}
+
+uint32_t GD::AxisResolution::SeenInRange(uint32_t first, uint32_t count) const
+{
+    uint32_t seen = 0;
+    for (uint32_t code = first; code < first + count && code < m_CodeCount; ++code)
+        seen += Seen(code);
+    return seen;
+}
+
+GD::ResolutionInfo GD::AxisResolution::Analyze() const
+{
+    // The codes in order, with the gaps between them
+    std::vector<uint32_t> codes;
+    for (size_t word = 0; word < m_Seen.size(); ++word)
+    {
+        uint64_t bits = m_Seen[word];
+        while (bits)
+        {
+            uint32_t bit = (uint32_t)GD::LowestBit(bits);
+            codes.push_back((uint32_t)(word * 64) + bit);
+            bits &= bits - 1;
+        }
+    }
+
+    ResolutionInfo info;
+    info.Codes = (uint32_t)codes.size();
+    if (codes.empty())
+        return info;
+    info.Min = m_Lowest + (int32_t)codes.front();
+    info.Max = m_Lowest + (int32_t)codes.back();
+    info.UsedBits = std::log2((double)codes.size());
+    if (codes.size() < 2)
+        return info;
+
+    // The extremes are often clamped (32767 on a stick that steps by 256), so they do not take part in the step
+    size_t first = codes.size() >= 4 ? 1 : 0;
+    size_t last = codes.size() >= 4 ? codes.size() - 2 : codes.size() - 1;
+    std::vector<uint32_t> gaps;
+    uint32_t common = 0;
+    for (size_t n = 1; n < codes.size(); ++n)
+    {
+        uint32_t gap = codes[n] - codes[n - 1];
+        info.LargestGap = std::max(info.LargestGap, (int32_t)gap);
+        if (n > first && n <= last)
+        {
+            gaps.push_back(gap);
+            common = std::gcd(common, gap);
+        }
+    }
+
+    // Firmware that scales by something else than a power of two (10 bits to 16: k * 32767 / 511) has gaps of
+    // 64 and 65, so the step is the mean of the gaps around the median, the missing codes make the larger ones.
+    // When most gaps are far from the median the codes are just spread out, then the grid is what they have in common.
+    std::vector<uint32_t> sorted = gaps;
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+    uint32_t median = sorted[sorted.size() / 2];
+    uint64_t sum = 0;
+    size_t regular = 0;
+    for (uint32_t gap : gaps)
+    {
+        if (2 * gap > median && 2 * gap < 3 * median)
+        {
+            sum += gap;
+            regular++;
+        }
+    }
+    double step = 2 * regular >= gaps.size() ? (double)sum / regular : (double)std::max(common, 1u);
+
+    // Only a gap that is clearly more than one step has codes missing in it
+    for (uint32_t gap : gaps)
+    {
+        if (gap >= 1.5 * step)
+            info.MissingCodes += (uint32_t)std::lround(gap / step) - 1;
+    }
+    info.Step = step;
+    info.EffectiveBits = std::log2((double)m_CodeCount / step);
+    return info;
+}
@@ -0,0 +1,122 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Work stealing thread pool for batch jobs
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_threadpool.h"
+#include <algorithm>
+
+// Which queue belongs to the current thread, so nested submits stay local
+static thread_local const GD::ThreadPool* t_Pool = nullptr;
+static thread_local size_t t_Queue = 0;
+
+
+GD::ThreadPool::ThreadPool(unsigned threads)
+{
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned n = 0; n < threads; ++n)
+        m_Queues.push_back(std::make_unique<Queue>());
+    for (unsigned n = 0; n + 1 < threads; ++n)
+        m_Threads.emplace_back(&ThreadPool::WorkerProc, this, (size_t)n);
+}
+
+GD::ThreadPool::~ThreadPool()
+{
+    Wait();
+    {
+        std::unique_lock<std::mutex> lock(m_Lock);
+        m_Stop = true;
+    }
+    m_Wake.notify_all();
+    for (auto& thread : m_Threads)
+        thread.join();
+}
+
+void GD::ThreadPool::Submit(std::function<void()> task)
+{
+    size_t index = t_Pool == this ? t_Queue : m_Next++ % m_Queues.size();
+    m_Pending++;
+    {
+        // Counted first and under the lock, so a worker cannot miss it between checking and going to sleep
+        std::unique_lock<std::mutex> lock(m_Lock);
+        m_Queued++;
+    }
+    {
+        std::unique_lock<std::mutex> lock(m_Queues[index]->Lock);
+        m_Queues[index]->Tasks.push_back(std::move(task));
+    }
+    m_Wake.notify_one();
+}
+
+bool GD::ThreadPool::RunOne(size_t self)
+{
+    std::function<void()> task;
+    {
+        auto& own = *m_Queues[self];
+        std::unique_lock<std::mutex> lock(own.Lock);
+        if (!own.Tasks.empty())
+        {
+            task = std::move(own.Tasks.back());
+            own.Tasks.pop_back();
+        }
+    }
+    for (size_t n = 1; !task && n < m_Queues.size(); ++n)
+    {
+        auto& other = *m_Queues[(self + n) % m_Queues.size()];
+        std::unique_lock<std::mutex> lock(other.Lock);
+        if (!other.Tasks.empty())
+        {
+            task = std::move(other.Tasks.front());
+            other.Tasks.pop_front();
+        }
+    }
+    if (!task)
+        return false;
+
+    m_Queued--;
+    task();
+    if (--m_Pending == 0)
+    {
+        std::unique_lock<std::mutex> lock(m_Lock);
+        m_Wake.notify_all();
+    }
+    return true;
+}
+
+void GD::ThreadPool::WorkerProc(size_t index)
+{
+    t_Pool = this;
+    t_Queue = index;
+    for (;;)
+    {
+        if (RunOne(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_Lock);
+        m_Wake.wait(lock, [this]() { return m_Stop || m_Queued > 0; });
+        if (m_Stop)
+            return;
+    }
+}
+
+void GD::ThreadPool::Wait()
+{
+    const ThreadPool* pool = t_Pool;
+    size_t queue = t_Queue;
+    t_Pool = this;
+    t_Queue = m_Queues.size() - 1;
+
+    while (m_Pending > 0)
+    {
+        if (RunOne(t_Queue))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_Lock);
+        m_Wake.wait(lock, [this]() { return m_Pending == 0 || m_Queued > 0; });
+    }
+
+    t_Pool = pool;
+    t_Queue = queue;
+}
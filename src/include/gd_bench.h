@@ -0,0 +1,72 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Test session of one device on the bench, analyzed on a thread of its own
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "record/gd_RecordBench.h"
+#include "gd_buttons.h"
+#include "gd_digest.h"
+#include "gd_resolution.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GD
+{
+    // The sampling thread only appends to the queue of the session, the worker takes the whole queue at once
+    // and runs the analysis on it. Every session has its own worker, so a device never waits for another one,
+    // and nothing is dropped: a worker that falls behind shows up as a growing backlog.
+    class BenchSession
+    {
+    public:
+        explicit BenchSession(const DeviceInfo& info);
+        ~BenchSession();
+        BenchSession(const BenchSession&) = delete;
+        BenchSession& operator=(const BenchSession&) = delete;
+
+        const DeviceInfo& Info() const { return m_Info; }
+
+        // From the sampling thread
+        void Push(const Sample& sample);
+        // Analyzes what is still queued and ends the worker
+        void Stop();
+        // The result so far, updated a few times per second while running
+        Record::BenchRecord Result() const;
+
+    private:
+        void WorkerProc();
+        void Analyze(const Sample& sample);
+        void Publish();
+
+        DeviceInfo m_Info;
+        uint64_t m_StartTime;
+
+        // Shared with the sampling thread
+        std::mutex m_QueueLock;
+        std::condition_variable m_Wake;
+        std::vector<Sample> m_Queue;
+        bool m_Stop = false;
+
+        // Owned by the worker
+        std::thread m_Thread;
+        std::vector<Sample> m_Batch;
+        bool m_Started = false;
+        uint64_t m_First = 0;
+        uint64_t m_Last = 0;
+        uint32_t m_LastPacket = 0;
+        uint64_t m_Samples = 0;
+        uint64_t m_Missed = 0;
+        size_t m_PeakBacklog = 0;
+        Digest m_Intervals;
+        int32_t m_Deadzone[Axis_Count];
+        std::vector<AxisResolution> m_Resolution;
+        ButtonEdges m_Buttons;
+
+        mutable std::mutex m_ResultLock;
+        Record::BenchRecord m_Result;
+    };
+}
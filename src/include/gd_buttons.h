@@ -0,0 +1,102 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Press and release events of the buttons, with hold times, chords and chatter
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GD
+{
+    struct ButtonEvent
+    {
+        uint64_t Timestamp = 0;
+        uint64_t Duration = 0;          // Of the press that ended, 0 for a press or when the start was not seen
+        uint8_t Bit = 0;
+        bool Press = false;
+        bool Chatter = false;           // Came within the chatter window of the previous edge of the same button
+    };
+
+    struct ButtonStats
+    {
+        static constexpr int HoldBuckets = 20;      // Bucket n holds 2^(n-1) .. 2^n - 1 times 128 us, bucket 0 the shorter ones
+
+        uint64_t Presses = 0;
+        uint64_t Releases = 0;          // With a known duration
+        uint64_t Chatter = 0;
+        uint64_t TotalHeld = 0;
+        uint64_t MinHold = UINT64_MAX;
+        uint64_t MaxHold = 0;
+        uint32_t PeakRate = 0;          // Most presses within one second
+        uint64_t Holds[HoldBuckets]{};
+
+        static uint64_t BucketStart(int bucket) { return bucket ? 128ull << (bucket - 1) : 0; }
+    };
+
+    struct ChordStats
+    {
+        uint16_t Buttons = 0;
+        uint64_t Count = 0;
+        uint64_t MaxSpread = 0;         // Time between the first and the last press of the chord
+        uint64_t TotalSpread = 0;
+    };
+
+    // All 16 buttons are handled at once: the XOR with the previous state gives every edge, and only the
+    // buttons that changed are visited. Timestamps and durations are in microseconds.
+    class ButtonEdges
+    {
+    public:
+        static constexpr int Buttons = 16;
+        static constexpr int RateHistory = 64;      // Presses per button kept for the rate, so at most this many per second
+        static constexpr size_t MaxEvents = 256;
+
+        ButtonEdges() : ButtonEdges(3000, 50000) {}
+        ButtonEdges(uint64_t chatterWindow, uint64_t chordWindow);
+
+        // A release and a new press within this time count as chatter, as does a press that is this short
+        void SetChatterWindow(uint64_t window) { m_ChatterWindow = window; }
+        uint64_t ChatterWindow() const { return m_ChatterWindow; }
+        // Buttons that go down within this time of each other, and are all down at the same time, form a chord
+        void SetChordWindow(uint64_t window) { m_ChordWindow = window; }
+
+        void Add(uint64_t timestamp, uint16_t buttons);
+        void Clear();
+
+        uint16_t Down() const { return m_Last; }
+        const ButtonStats& Stats(int bit) const { return m_Stats[bit]; }
+        // Presses in the second up to now
+        uint32_t Rate(int bit, uint64_t now) const;
+        // Sorted by count, most frequent first
+        std::vector<ChordStats> Chords() const;
+        // Oldest first
+        std::vector<ButtonEvent> Events() const;
+
+    private:
+        void Event(uint64_t timestamp, int bit, bool press, bool chatter, uint64_t duration);
+        void FinishChord();
+
+        uint64_t m_ChatterWindow;
+        uint64_t m_ChordWindow;
+
+        bool m_Started = false;
+        uint16_t m_Last = 0;
+        uint16_t m_Known = 0;           // Buttons whose press was seen, the others were already down at the start
+        uint64_t m_LastEdge[Buttons]{};
+        uint64_t m_PressedAt[Buttons]{};
+        uint64_t m_PressTimes[Buttons][RateHistory]{};
+        ButtonStats m_Stats[Buttons];
+
+        uint16_t m_Chord = 0;
+        bool m_ChordTogether = false;
+        uint64_t m_ChordStart = 0;
+        uint64_t m_ChordLast = 0;
+        std::vector<ChordStats> m_Chords;
+
+        std::vector<ButtonEvent> m_Events;
+        uint64_t m_EventCount = 0;
+    };
+}
@@ -0,0 +1,53 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Mergeable quantile sketch for timing measurements
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace GD
+{
+    // Merging t-digest (Dunning): values are buffered, and the buffer is sorted and merged into the centroids once it is full.
+    // The arcsine scale keeps the centroids near both tails small, so p99.9 stays accurate while the memory
+    // depends only on the compression and not on how many values were added.
+    class Digest
+    {
+    public:
+        Digest() : Digest(200.0) {}
+        explicit Digest(double compression);
+
+        void Add(double value, double weight = 1.0);
+        void Merge(const Digest& other);
+        void Clear();
+
+        // q in 0 .. 1, NaN when nothing was added
+        double Quantile(double q) const;
+        double Count() const { return m_Total + m_BufferWeight; }
+        double Min() const { return m_Min; }
+        double Max() const { return m_Max; }
+        double Mean() const;
+        size_t Centroids() const;
+
+    private:
+        struct Centroid
+        {
+            double Mean;
+            double Weight;
+        };
+
+        // The buffer is folded in before a query, so the queries can stay const
+        void Compress() const;
+
+        double m_Compression;
+        double m_Min;
+        double m_Max;
+        mutable double m_Total = 0.0;
+        mutable double m_BufferWeight = 0.0;
+        mutable std::vector<Centroid> m_Centroids;
+        mutable std::vector<Centroid> m_Buffer;
+    };
+}
@@ -0,0 +1,35 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Fast Fourier transform for signal analysis
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace GD
+{
+    // Iterative radix-2 transform, the bit reversal and twiddle tables are built once per size
+    class Fft
+    {
+    public:
+        explicit Fft(size_t size);      // size has to be a power of two
+
+        size_t Size() const { return m_Size; }
+        void Forward(std::complex<double>* data) const;
+        // Includes the 1 / size scaling, so Inverse(Forward(x)) == x
+        void Inverse(std::complex<double>* data) const;
+
+        static size_t NextSize(size_t count);
+
+    private:
+        void Transform(std::complex<double>* data, bool inverse) const;
+
+        size_t m_Size;
+        std::vector<std::complex<double>> m_Twiddles;
+        std::vector<size_t> m_Reverse;
+    };
+}
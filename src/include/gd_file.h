@@ -0,0 +1,45 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Platform independent file helpers
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+namespace GD
+{
+    FILE* OpenFile(const char* path, const char* mode);
+    // Flush the stdio buffers and ask the OS to put the data on disk
+    bool SyncFile(FILE* file);
+    bool TruncateFile(FILE* file, uint64_t size);
+
+    // Read-only view of a complete file
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { Close(); }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const char* path);
+        void Close();
+
+        const uint8_t* Data() const { return m_Data; }
+        size_t Size() const { return m_Size; }
+
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+#ifdef _WIN32
+        void* m_File = nullptr;
+        void* m_Mapping = nullptr;
+#else
+        int m_Fd = -1;
+#endif
+    };
+}
@@ -0,0 +1,76 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Recent samples of every device, one ring per channel
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "gd_sample.h"
+#include <vector>
+
+namespace GD
+{
+    // The samples from one point in time up to the newest one. The rings wrap, so every channel
+    // comes in at most two contiguous parts: [0] is the older one, Count[1] is 0 when it did not wrap.
+    struct HistorySpan
+    {
+        size_t Count[2]{};
+        const uint64_t* Timestamps[2]{};
+        const uint16_t* Buttons[2]{};
+        const int16_t* Axes[Axis_Count][2]{};
+
+        size_t Size() const { return Count[0] + Count[1]; }
+    };
+
+    // Each device has a power-of-two ring per channel (timestamps, buttons and every axis), so a scan over
+    // one channel reads a single typed array. The memory budget is shared by all devices: when devices come
+    // and go the rings are resized, keeping the newest samples. Not thread safe, see GD::History.
+    class HistoryStore
+    {
+    public:
+        static constexpr size_t BytesPerSample = sizeof(uint64_t) + sizeof(uint16_t) + Axis_Count * sizeof(int16_t);
+        static constexpr size_t MinCapacity = 1024;
+
+        explicit HistoryStore(size_t budget = 32u << 20);
+
+        void SetBudget(size_t budget);
+        size_t Budget() const { return m_Budget; }
+        // Samples per device
+        size_t Capacity() const { return m_Capacity; }
+
+        // A device that connects again starts with an empty history
+        void AddDevice(const DeviceInfo& info);
+        void RemoveDevice(uint16_t id);
+        // Samples of unknown devices are dropped
+        void Append(const Sample& sample);
+        void Clear(uint16_t id);
+
+        size_t DeviceCount() const { return m_Devices.size(); }
+        const DeviceInfo& Device(size_t index) const { return m_Devices[index].Info; }
+        // Samples written to the device since it was added, the ring holds the last Capacity() of them
+        uint64_t Written(uint16_t id) const;
+
+        // The state that was held at since and everything after it, false for an unknown device
+        bool Span(uint16_t id, uint64_t since, HistorySpan& span) const;
+        bool Latest(uint16_t id, Sample& sample) const;
+
+    private:
+        struct DeviceRings
+        {
+            DeviceInfo Info;
+            uint64_t Head = 0;
+            std::vector<uint64_t> Timestamps;
+            std::vector<uint16_t> Buttons;
+            std::vector<int16_t> Axes[Axis_Count];
+        };
+
+        DeviceRings* Find(uint16_t id);
+        const DeviceRings* Find(uint16_t id) const;
+        void Resize();
+
+        size_t m_Budget;
+        size_t m_Capacity = MinCapacity;
+        std::vector<DeviceRings> m_Devices;
+    };
+}
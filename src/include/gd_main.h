@@ -5,7 +5,16 @@
 
 
 
+#include "imgui.h"
+#include <cstdint>
+
 void GD_Frame();
 void GD_Init();
 void GD_Shutdown();
 
+// Textures the modules can draw into from the UI thread, they survive a device reset.
+// Pixels are 0xAARRGGBB, width * height of them.
+ImTextureID GD_CreateTexture(int width, int height);
+bool GD_UpdateTexture(ImTextureID texture, const uint32_t* pixels, int width, int height);
+void GD_DestroyTexture(ImTextureID texture);
+
@@ -0,0 +1,98 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Fighting game motion inputs in numpad notation, matched against the sample stream
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace GD
+{
+    // Numpad notation: 5 is neutral, 6 is right, 8 is up, the diagonals are in between (9 is up-right)
+    int NumpadDirection(int32_t x, int32_t y, float deadzone);
+    // Left and right together cancel out, as do up and down
+    int DPadDirection(uint16_t buttons);
+
+    // A step is reached by entering one of its directions, by pressing one of its buttons,
+    // or for a charge by leaving its directions after holding them for the charge time.
+    struct MotionStep
+    {
+        std::string Label;
+        uint16_t Directions = 0;        // Bit n for numpad direction n
+        uint16_t Buttons = 0;
+        uint64_t Charge = 0;
+        uint64_t Window = 0;            // Latest time after the previous step
+        uint64_t MinGap = 0;            // Earliest time after the previous step, a plink has to come in a later sample
+    };
+
+    // A motion compiled to an automaton: every input symbol has a mask of the steps it can reach,
+    // so one event advances all partial matches of the motion at once. Times are in microseconds.
+    struct Motion
+    {
+        static constexpr int MaxSteps = 16;
+        static constexpr int Symbols = 9 + 16;          // Directions 1..9, then the button bits
+
+        std::string Name;
+        std::string Notation;
+        double FrameRate = 60.0;
+        std::vector<MotionStep> Steps;
+        uint16_t Accepts[Symbols]{};
+        uint16_t ChargeSteps = 0;
+
+        double Frames(uint64_t time) const { return time * FrameRate / 1e6; }
+    };
+
+    // Defaults in frames: a direction or button after the previous step, a plink after the first button, and a charge
+    constexpr int StepWindowFrames = 10;
+    constexpr int PlinkWindowFrames = 2;
+    constexpr int ChargeFrames = 45;
+
+    // Notation like "236X", "41236 A", "[4]6X", "X~A" and "2/6 3/4 6/4 X/8". Digits are directions, button
+    // names (A, B, X, Y, LB, RB or any of GD::ButtonName) are presses, "[4]" charges back for 45 frames
+    // ("[4:30]" for 30 frames, down-back counts as back), "~" plinks the next button and "/n" sets the
+    // window of the step before it in frames.
+    bool CompileMotion(const char* name, const char* notation, double frameRate, Motion& motion, std::string& error);
+
+    struct MotionMatch
+    {
+        uint16_t Motion = 0;
+        uint8_t Steps = 0;
+        uint64_t Times[Motion::MaxSteps]{};
+    };
+
+    // Events only come from changes: a new direction, then the buttons that went down in bit order.
+    // A partial match keeps the latest time each step was reached, and is dropped when the next step
+    // can no longer come within its window.
+    class MotionRecognizer
+    {
+    public:
+        void SetMotions(const std::vector<Motion>& motions);
+        const std::vector<Motion>& Motions() const { return m_Motions; }
+
+        // Completed motions are appended to matches
+        void Add(uint64_t timestamp, int direction, uint16_t buttons, std::vector<MotionMatch>& matches);
+        void Clear();
+
+        int Direction() const { return m_Direction; }
+
+    private:
+        struct State
+        {
+            uint16_t Reached = 0;
+            uint64_t Times[Motion::MaxSteps][Motion::MaxSteps]{};
+            uint64_t ChargeSince[Motion::MaxSteps]{};
+        };
+
+        void Step(size_t index, uint16_t symbolSteps, uint64_t timestamp, std::vector<MotionMatch>& matches);
+
+        std::vector<Motion> m_Motions;
+        std::vector<State> m_States;
+        bool m_Started = false;
+        int m_Direction = 5;
+        uint16_t m_Buttons = 0;
+    };
+}
@@ -0,0 +1,77 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Deadzones, response curves and filters, the way a game processes the input
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GD
+{
+    enum StageType : uint8_t
+    {
+        Stage_Calibration,              // Center offset and gain per axis
+        Stage_AxialDeadzone,            // Each axis on its own, like the XInput documentation does it
+        Stage_RadialDeadzone,           // On the distance from the center, the direction is kept
+        Stage_ScaledRadialDeadzone,     // Radial, and rescaled so the output starts at 0 at the edge of it
+        Stage_AntiDeadzone,             // Jumps over a deadzone the game applies on its own
+        Stage_Curve,                    // Response curve on the distance from the center
+        Stage_OneEuro,                  // Adaptive low-pass: smooth when the stick is slow, little lag when it is fast
+        Stage_Count
+    };
+
+    const char* StageName(int type);
+
+    // Values are normalized: sticks go from -1 to 1, triggers from 0 to 1.
+    // Not every field is used by every type, see DefaultStage for the ones that are.
+    struct Stage
+    {
+        StageType Type = Stage_RadialDeadzone;
+        bool Enabled = true;
+        float Inner = 0.f;              // Size of the (anti-)deadzone
+        float Outer = 1.f;              // Where the scaled radial deadzone reaches full scale
+        float Shape = 0.f;              // Curve, -1 is fast off the center, 1 is fine near it
+        float Center[2]{};
+        float Gain[2]{ 1.f, 1.f };
+        float MinCutoff = 1.f;          // One-Euro, Hz
+        float Beta = 1.f;               // One-Euro, how much the cutoff rises with the speed
+        float DerivativeCutoff = 1.f;   // One-Euro, Hz
+    };
+
+    Stage DefaultStage(StageType type);
+
+    // Int16 axis values to normalized floats, scale is 1 / full scale
+    void NormalizeAxis(const int16_t* values, size_t count, float scale, float* output);
+
+    // Runs the stages in order over a batch of one stick, in place. Every stage is one pass over the whole batch,
+    // the ones without state use SSE2 for four samples at a time. A trigger is a stick with all y values 0.
+    class AxisPipeline
+    {
+    public:
+        void SetStages(const std::vector<Stage>& stages);
+        const std::vector<Stage>& Stages() const { return m_Stages; }
+
+        // The inner size of the first deadzone, 0 without one
+        float Deadzone() const;
+
+        // The filters continue where the last batch ended, until Reset
+        void Process(const uint64_t* timestamps, float* x, float* y, size_t count);
+        void Reset();
+
+    private:
+        struct FilterState
+        {
+            bool Started = false;
+            uint64_t Last = 0;
+            float Value[2]{};
+            float Derivative[2]{};
+        };
+
+        std::vector<Stage> m_Stages;
+        std::vector<FilterState> m_Filters;
+    };
+}
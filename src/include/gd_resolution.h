@@ -0,0 +1,73 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Effective resolution of an analog axis from the codes it reports
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "gd_sample.h"
+#include <cstring>
+#include <vector>
+
+namespace GD
+{
+    struct ResolutionInfo
+    {
+        uint32_t Codes = 0;             // Distinct values seen
+        int32_t Min = 0;
+        int32_t Max = 0;
+        double Step = 0.0;              // Typical gap between neighbouring codes, without the two outermost
+        uint32_t MissingCodes = 0;      // Codes on the Step grid between Min and Max that never showed up
+        int32_t LargestGap = 0;
+        double EffectiveBits = 0.0;     // log2 of the full range divided by Step
+        double UsedBits = 0.0;          // log2 of Codes
+    };
+
+    // One bit per possible value: 256 bits for a trigger and 8 KB for a thumb axis, small enough to stay in the cache.
+    // Add does not branch, the analysis walks the bits when it is asked for.
+    class AxisResolution
+    {
+    public:
+        static constexpr int StepBuckets = 17;      // Bucket n holds the moves of 2^(n-1) .. 2^n - 1, bucket 0 the repeats
+
+        explicit AxisResolution(int axis = Axis_ThumbLX);
+
+        void Add(int32_t value)
+        {
+            uint32_t code = (uint32_t)(value - m_Lowest) & (m_CodeCount - 1);
+            m_Seen[code >> 6] |= 1ull << (code & 63);
+            int32_t delta = value - m_Last;
+            m_Steps[StepBucket((uint32_t)(delta < 0 ? -delta : delta))] += m_Started;
+            m_Last = value;
+            m_Started = 1;
+        }
+
+        void Clear();
+        ResolutionInfo Analyze() const;
+
+        uint32_t CodeCount() const { return m_CodeCount; }
+        int32_t Lowest() const { return m_Lowest; }
+        bool Seen(uint32_t code) const { return (m_Seen[code >> 6] >> (code & 63)) & 1; }
+        // Distinct codes in [first, first + count)
+        uint32_t SeenInRange(uint32_t first, uint32_t count) const;
+        const uint64_t* Steps() const { return m_Steps; }
+
+        // Bit width of a move, read from the exponent of a float so it does not branch
+        static int StepBucket(uint32_t delta)
+        {
+            float value = (float)delta + 0.5f;
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return (int)((bits >> 23) & 255) - 126;
+        }
+
+    private:
+        uint32_t m_CodeCount;
+        int32_t m_Lowest;
+        int32_t m_Last = 0;
+        uint64_t m_Started = 0;         // The first value has nothing to move from
+        std::vector<uint64_t> m_Seen;
+        uint64_t m_Steps[StepBuckets]{};
+    };
+}
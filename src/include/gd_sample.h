@@ -0,0 +1,179 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Platform independent controller samples
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include <bitset>
+#include <cctype>
+#include <cstdint>
+#include <chrono>
+#include <string>
+
+namespace GD
+{
+    enum DeviceApi : uint8_t
+    {
+        DeviceApi_Unknown = 0,
+        DeviceApi_XInput = 1,
+        DeviceApi_DInput = 2,
+    };
+
+    // Describes a device for as long as it stays connected
+    struct DeviceInfo
+    {
+        uint16_t Id = 0;
+        uint8_t Api = DeviceApi_Unknown;
+        uint8_t Slot = 0;
+        uint16_t VendorId = 0;
+        uint16_t ProductId = 0;
+        uint16_t ProductVersion = 0;
+        uint8_t SubType = 0;
+        uint8_t Reserved = 0;
+    };
+    static_assert(sizeof(DeviceInfo) == 12, "DeviceInfo is stored in recordings");
+
+    // Button bits, these match the XINPUT_GAMEPAD_* values
+    enum Button : uint16_t
+    {
+        Button_DPadUp = 0x0001,
+        Button_DPadDown = 0x0002,
+        Button_DPadLeft = 0x0004,
+        Button_DPadRight = 0x0008,
+        Button_Start = 0x0010,
+        Button_Back = 0x0020,
+        Button_LeftThumb = 0x0040,
+        Button_RightThumb = 0x0080,
+        Button_LeftShoulder = 0x0100,
+        Button_RightShoulder = 0x0200,
+        Button_Guide = 0x0400,
+        Button_A = 0x1000,
+        Button_B = 0x2000,
+        Button_X = 0x4000,
+        Button_Y = 0x8000,
+    };
+
+    // Short name of a single button bit, nullptr for bits without a button
+    inline const char* ButtonName(int bit)
+    {
+        static const char* names[16] = {
+            "DPAD_UP", "DPAD_DOWN", "DPAD_LEFT", "DPAD_RIGHT", "START", "BACK", "LEFT_THUMB", "RIGHT_THUMB",
+            "LEFT_SHOULDER", "RIGHT_SHOULDER", "GUIDE", nullptr, "A", "B", "X", "Y",
+        };
+        return (bit >= 0 && bit < 16) ? names[bit] : nullptr;
+    }
+
+    // Index of the lowest set bit
+    inline int LowestBit(uint64_t bits)
+    {
+        return (int)std::bitset<64>((bits & (~bits + 1)) - 1).count();
+    }
+
+    inline bool EqualsNoCase(const std::string& a, const char* b)
+    {
+        size_t n = 0;
+        for (; n < a.size() && b[n]; ++n)
+        {
+            if (tolower((unsigned char)a[n]) != tolower((unsigned char)b[n]))
+                return false;
+        }
+        return n == a.size() && !b[n];
+    }
+
+    // The bit of a button by its ButtonName or a short alias, in any case. 0 when there is no such button.
+    inline uint16_t FindButton(const std::string& name)
+    {
+        static const struct { const char* Name; uint16_t Button; } aliases[] = {
+            { "LB", Button_LeftShoulder }, { "RB", Button_RightShoulder },
+            { "LS", Button_LeftThumb }, { "RS", Button_RightThumb },
+        };
+        for (const auto& alias : aliases)
+        {
+            if (EqualsNoCase(name, alias.Name))
+                return alias.Button;
+        }
+        for (int bit = 0; bit < 16; ++bit)
+        {
+            const char* button = ButtonName(bit);
+            if (button && EqualsNoCase(name, button))
+                return (uint16_t)(1 << bit);
+        }
+        return 0;
+    }
+
+    // The analog channels of a sample, in storage order
+    enum Axis
+    {
+        Axis_LeftTrigger,
+        Axis_RightTrigger,
+        Axis_ThumbLX,
+        Axis_ThumbLY,
+        Axis_ThumbRX,
+        Axis_ThumbRY,
+        Axis_Count
+    };
+
+    // One state report of a device, timestamps are in microseconds (see GD::Now)
+    struct Sample
+    {
+        uint64_t Timestamp = 0;
+        uint32_t PacketNumber = 0;
+        uint16_t Device = 0;
+        uint16_t Buttons = 0;
+        uint8_t LeftTrigger = 0;
+        uint8_t RightTrigger = 0;
+        int16_t ThumbLX = 0;
+        int16_t ThumbLY = 0;
+        int16_t ThumbRX = 0;
+        int16_t ThumbRY = 0;
+        uint8_t Reserved[6]{};
+    };
+    static_assert(sizeof(Sample) == 32, "Sample is stored in recordings");
+
+    // Same values as XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE, XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE and XINPUT_GAMEPAD_TRIGGER_THRESHOLD
+    constexpr int32_t LeftThumbDeadzone = 7849;
+    constexpr int32_t RightThumbDeadzone = 8689;
+    constexpr int32_t TriggerThreshold = 30;
+
+    inline int32_t GetAxis(const Sample& sample, int axis)
+    {
+        switch (axis)
+        {
+        case Axis_LeftTrigger: return sample.LeftTrigger;
+        case Axis_RightTrigger: return sample.RightTrigger;
+        case Axis_ThumbLX: return sample.ThumbLX;
+        case Axis_ThumbLY: return sample.ThumbLY;
+        case Axis_ThumbRX: return sample.ThumbRX;
+        case Axis_ThumbRY: return sample.ThumbRY;
+        default: return 0;
+        }
+    }
+
+    inline void SetAxis(Sample& sample, int axis, int32_t value)
+    {
+        switch (axis)
+        {
+        case Axis_LeftTrigger: sample.LeftTrigger = (uint8_t)value; break;
+        case Axis_RightTrigger: sample.RightTrigger = (uint8_t)value; break;
+        case Axis_ThumbLX: sample.ThumbLX = (int16_t)value; break;
+        case Axis_ThumbLY: sample.ThumbLY = (int16_t)value; break;
+        case Axis_ThumbRX: sample.ThumbRX = (int16_t)value; break;
+        case Axis_ThumbRY: sample.ThumbRY = (int16_t)value; break;
+        }
+    }
+
+    inline const char* AxisName(int axis)
+    {
+        static const char* names[Axis_Count] = { "bLeftTrigger", "bRightTrigger", "sThumbLX", "sThumbLY", "sThumbRX", "sThumbRY" };
+        return (axis >= 0 && axis < Axis_Count) ? names[axis] : "?";
+    }
+
+    // Monotonic time in microseconds, shared by everything that produces samples
+    inline uint64_t Now()
+    {
+        using namespace std::chrono;
+        return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+}
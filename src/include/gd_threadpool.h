@@ -0,0 +1,67 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Work stealing thread pool for batch jobs
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GD
+{
+    // Every worker has its own queue. Tasks submitted from a worker go to the back of its own queue and
+    // are taken from there again (depth first), idle workers steal from the front of the other queues.
+    class ThreadPool
+    {
+    public:
+        // 0 uses one thread per core, the thread calling Wait also runs tasks
+        explicit ThreadPool(unsigned threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Can also be called from inside a task
+        void Submit(std::function<void()> task);
+        // Runs tasks until all submitted tasks (and the tasks they submitted) are done, not for use inside a task
+        void Wait();
+
+        unsigned Size() const { return (unsigned)m_Queues.size(); }
+
+    private:
+        struct Queue
+        {
+            std::mutex Lock;
+            std::deque<std::function<void()>> Tasks;
+        };
+
+        bool RunOne(size_t self);
+        void WorkerProc(size_t index);
+
+        std::vector<std::unique_ptr<Queue>> m_Queues;   // The last one belongs to the thread calling Wait
+        std::vector<std::thread> m_Threads;
+        std::atomic<size_t> m_Queued{ 0 };
+        std::atomic<size_t> m_Pending{ 0 };
+        std::atomic<size_t> m_Next{ 0 };
+        std::mutex m_Lock;
+        std::condition_variable m_Wake;
+        bool m_Stop = false;
+    };
+
+    // Calls fn(index) for every index in [0, count) on the pool, and waits for all of them
+    template<typename Fn>
+    void ParallelFor(ThreadPool& pool, size_t count, Fn fn)
+    {
+        for (size_t n = 0; n < count; ++n)
+            pool.Submit([&fn, n]() { fn(n); });
+        pool.Wait();
+    }
+}
@@ -0,0 +1,20 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Running statistics and rest drift of the XInput axes
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#include "gd_sample.h"
+
+namespace GD::AxisStats
+{
+    constexpr int Slots = 4;
+
+    // Called from the XInput sampling thread on every poll, with the held state of all four slots.
+    // A slot that becomes active starts over.
+    void Update(const Sample (&samples)[Slots], const bool (&active)[Slots]);
+
+    void RenderFrame();
+    void Show();
+    void Shutdown();
+}
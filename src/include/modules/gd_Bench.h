@@ -0,0 +1,19 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Test all connected devices at once, and keep the results per product
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#include "gd_sample.h"
+
+namespace GD::Bench
+{
+    // Called by the input modules, Submit comes from their sampling thread
+    void DeviceConnected(const DeviceInfo& info);
+    void DeviceDisconnected(uint16_t id);
+    void Submit(const Sample& sample);
+
+    void RenderFrame();
+    void Show();
+    void Shutdown();
+}
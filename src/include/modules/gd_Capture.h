@@ -0,0 +1,44 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Oscilloscope style triggered capture of device samples
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#include "gd_sample.h"
+
+namespace GD::Capture
+{
+    enum TriggerType
+    {
+        Trigger_ButtonPress,
+        Trigger_ButtonRelease,
+        Trigger_AxisRising,     // The axis goes from below Threshold to Threshold or above
+        Trigger_AxisFalling,    // The axis goes from above Threshold to Threshold or below
+        Trigger_PacketGap,      // The packet number jumps by more than PacketGap
+        Trigger_Count
+    };
+
+    struct Trigger
+    {
+        TriggerType Type = Trigger_ButtonPress;
+        int Device = -1;                // -1 for any device
+        uint16_t Buttons = Button_A;    // Any of these buttons
+        int Axis = Axis_ThumbLX;
+        int32_t Threshold = 16384;
+        uint32_t PacketGap = 1;
+        uint32_t PreTrigger = 250000;   // Microseconds kept before the trigger
+        uint32_t PostTrigger = 250000;  // Microseconds captured after the trigger
+    };
+
+    void Arm(const Trigger& trigger);
+    void Disarm();
+
+    // Called by the input modules, Submit comes from their sampling thread
+    void DeviceConnected(const DeviceInfo& info);
+    void DeviceDisconnected(uint16_t id);
+    void Submit(const Sample& sample);
+
+    void RenderFrame();
+    void Show();
+    void Shutdown();
+}
@@ -0,0 +1,41 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Keep the last seconds of samples and log output in memory, to dump on request or crash
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#include "gd_sample.h"
+#include <cassert>
+
+namespace GD::FlightRecorder
+{
+    // All memory is allocated here, the recorder does not allocate afterwards
+    void Init(uint32_t seconds = 30, uint32_t samplesPerSecond = 4000);
+    void Shutdown();
+
+    void DeviceConnected(const DeviceInfo& info);
+    void DeviceDisconnected(uint16_t id);
+    void Submit(const Sample& sample);
+    void Log(uint64_t timestamp, const char* text, size_t length);
+
+    // Writes the buffered seconds to a new recording
+    bool Dump(const char* reason);
+    void Assert(const char* expression, const char* file, int line);
+}
+
+// Like assert, but dumps the flight recorder (once per call site) before asserting.
+// The dump also happens in release builds.
+#define GD_ASSERT(expr) \
+    do \
+    { \
+        if (!(expr)) \
+        { \
+            static bool dumped = false; \
+            if (!dumped) \
+            { \
+                dumped = true; \
+                GD::FlightRecorder::Assert(#expr, __FILE__, __LINE__); \
+            } \
+            assert(expr); \
+        } \
+    } while (0)
@@ -0,0 +1,22 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Where the sticks have been, and the shape of their outer range
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#include "gd_sample.h"
+
+namespace GD::Heatmap
+{
+    constexpr int Slots = 4;
+
+    // Called from the XInput sampling thread on every poll, with the held state of all four slots.
+    // A slot that becomes active starts over.
+    void Update(const Sample (&samples)[Slots], const bool (&active)[Slots]);
+
+    // The occupancy of one stick (0 = left, 1 = right) as a square image, with the outer range on top.
+    // Right click for the options.
+    void Draw(int slot, int stick, float size);
+
+    void Shutdown();
+}
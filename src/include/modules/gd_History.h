@@ -0,0 +1,22 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Recent samples of all connected devices, shared by the views
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#include "gd_history.h"
+#include <functional>
+
+namespace GD::History
+{
+    // Called by the input modules, Submit comes from their sampling thread
+    void DeviceConnected(const DeviceInfo& info);
+    void DeviceDisconnected(uint16_t id);
+    void Submit(const Sample& sample);
+
+    // Runs reader with the store locked, the sampling threads wait for it so keep it short
+    void Read(const std::function<void(const HistoryStore& store)>& reader);
+
+    void RenderOptions();
+    void Shutdown();
+}
@@ -0,0 +1,25 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Preview how a game sees the input after its deadzones, curves and filters
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#include <cstdint>
+
+namespace GD::Processing
+{
+    enum Control
+    {
+        Control_LeftStick,
+        Control_RightStick,
+        Control_LeftTrigger,
+        Control_RightTrigger,
+        Control_Count
+    };
+
+    // The deadzone of the configured pipeline in raw units, 0 when it has none
+    float Deadzone(int control);
+
+    void RenderFrame();
+    void Show();
+}
@@ -0,0 +1,24 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Record the samples of all connected devices
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#include "gd_sample.h"
+
+namespace GD::Recorder
+{
+    bool Start();
+    void Stop();
+    bool IsRecording();
+    const char* LastPath();
+
+    // Called by the input modules, also when we are not recording. Submit can come from any thread.
+    void DeviceConnected(const DeviceInfo& info);
+    void DeviceDisconnected(uint16_t id);
+    void Submit(const Sample& sample);
+    // Called for every line of log output
+    void Log(uint64_t timestamp, const char* text, size_t length);
+
+    void Shutdown();
+}
@@ -0,0 +1,13 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Replay recorded sessions
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+namespace GD::Replay
+{
+    void RenderFrame();
+
+    void Show(const char* path);
+    void Shutdown();
+}
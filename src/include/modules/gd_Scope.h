@@ -0,0 +1,24 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Recent history of the axes, for the scope plots
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#include "gd_sample.h"
+#include <vector>
+
+namespace GD::Scope
+{
+    // Lowest and highest value of every axis in each pixel column, an empty column has Min > Max
+    struct Envelope
+    {
+        int Columns = 0;
+        std::vector<int16_t> Min[Axis_Count];
+        std::vector<int16_t> Max[Axis_Count];
+    };
+
+    // The last seconds of a device from the shared history, decimated to the given number of columns.
+    // False when the scope is off.
+    bool Decimate(uint16_t device, int columns, Envelope& envelope);
+    void RenderOptions();
+}
@@ -0,0 +1,26 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Quantiles of sample intervals, enumeration and frame times
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#include "gd_sample.h"
+
+namespace GD::Timing
+{
+    // Called by the input modules, Submit comes from their sampling thread
+    void DeviceConnected(const DeviceInfo& info);
+    void DeviceDisconnected(uint16_t id);
+    void Submit(const Sample& sample);
+
+    // Durations in microseconds
+    void AddEnumeration(uint64_t duration);
+    void AddFrame(uint64_t duration);
+
+    // Microseconds between two samples of a device at quantile q, NaN when nothing is known yet
+    double IntervalQuantile(uint16_t id, double q);
+
+    void RenderFrame();
+    void Show();
+    void Shutdown();
+}
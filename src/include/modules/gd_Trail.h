@@ -0,0 +1,22 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     The recent path of the sticks
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#include "gd_sample.h"
+#include "imgui.h"
+
+namespace GD::Trail
+{
+    constexpr int Slots = 4;
+
+    // Called from the XInput sampling thread on every poll, with the held state of all four slots
+    void Update(const Sample (&samples)[Slots], const bool (&active)[Slots]);
+
+    // Draws the path of one stick (0 = left, 1 = right) over a square at min, full scale fills the square
+    void Draw(int slot, int stick, const ImVec2& min, float size);
+    void RenderOptions();
+
+    void Shutdown();
+}
@@ -0,0 +1,52 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Find the clock offset between two recordings of the same input
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "gd_sample.h"
+#include <string>
+#include <vector>
+
+namespace GD::Record
+{
+    class Reader;
+
+    // Signals to correlate: the axes, and the button presses and releases as impulses
+    constexpr int AlignChannel_Buttons = Axis_Count;
+
+    enum AlignStart
+    {
+        AlignStart_Clock,       // Both recordings were made at the same time, start from their wall clock times
+        AlignStart_Given,       // Start from AlignOptions::Guess
+    };
+
+    struct AlignOptions
+    {
+        int DeviceA = -1;
+        int DeviceB = -1;
+        std::vector<int> Channels = { Axis_ThumbLX, Axis_ThumbLY, Axis_ThumbRX, Axis_ThumbRY, AlignChannel_Buttons };
+        AlignStart Start = AlignStart_Clock;
+        int64_t Guess = 0;              // Microseconds added to the timestamps of B
+        uint64_t MaxLag = 2000000;      // How far from the guess the offset is searched
+        uint64_t Resolution = 1000;     // Both recordings are resampled to this interval
+    };
+
+    struct AlignResult
+    {
+        int64_t Offset = 0;             // Microseconds to add to the timestamps of B, the same as DiffOptions::Offset
+        double Correlation = 0.0;       // Normalized peak, close to 1 for a clean match
+        uint64_t Blocks = 0;
+    };
+
+    // Cross-correlates the resampled signals with an FFT, one block of A against a window of B at a time,
+    // so memory depends on MaxLag / Resolution and not on the length of the recordings.
+    // Every lag is normalized by the energy of B under it. The peak is interpolated with a parabola: with smooth axis
+    // motion that gives an offset finer than Resolution, button edges are on the grid so with those it is within one step.
+    bool Align(const char* a, const char* b, const AlignOptions& options, AlignResult& result, std::string& error);
+
+    // Typical time between two reports of a device, the median gap over the first samples
+    uint64_t ReportInterval(const Reader& reader, uint16_t device);
+}
@@ -0,0 +1,99 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Batch statistics over many recordings
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "gd_digest.h"
+#include "gd_sample.h"
+#include <string>
+#include <vector>
+
+namespace GD::Record
+{
+    // Count, mean and sum of squared differences, merged with the parallel variant of Welford's algorithm
+    struct Moments
+    {
+        uint64_t Count = 0;
+        double Mean = 0.0;
+        double M2 = 0.0;
+
+        void Merge(const Moments& other);
+        // Merges a block that was reduced to a count, sum and sum of squares
+        void MergeSums(uint64_t count, double sum, double sumSquares);
+        double Variance() const { return Count > 1 ? M2 / (Count - 1) : 0.0; }
+    };
+
+    struct AxisStats
+    {
+        Moments Values;
+        int32_t Min = INT32_MAX;
+        int32_t Max = INT32_MIN;
+
+        void Merge(const AxisStats& other);
+    };
+
+    // The stick positions while a stick is inside the default XInput deadzone, its mean is where the stick rests
+    struct RestStats
+    {
+        Moments X;
+        Moments Y;
+
+        void Merge(const RestStats& other);
+    };
+
+    // Everything that is known about one device in one recording, all fields can be merged in any order
+    struct SessionStats
+    {
+        DeviceInfo Info;
+        uint64_t Samples = 0;
+        uint64_t FirstTimestamp = UINT64_MAX;
+        uint64_t LastTimestamp = 0;
+        uint64_t MissedPackets = 0;     // Packet numbers that were skipped between two samples
+        uint64_t ButtonPresses = 0;
+        GD::Digest Intervals;           // Microseconds between two samples
+        AxisStats Axes[Axis_Count];
+        RestStats LeftRest;
+        RestStats RightRest;
+
+        void Merge(const SessionStats& other);
+    };
+
+    constexpr int DriftBins = 32;
+    constexpr int DriftBinWidth = 256;   // The last bin also holds everything above
+
+    // Sessions of one product (VendorId, ProductId, ProductVersion)
+    struct ProductStats
+    {
+        DeviceInfo Info;                // Only the product fields are meaningful
+        uint64_t Sessions = 0;
+        uint64_t Samples = 0;
+        uint64_t Duration = 0;          // Microseconds
+        uint64_t MissedPackets = 0;
+        uint64_t ButtonPresses = 0;
+        GD::Digest Intervals;
+        AxisStats Axes[Axis_Count];
+        // Distance of the rest position from the center, one entry per session
+        uint64_t LeftDrift[DriftBins]{};
+        uint64_t RightDrift[DriftBins]{};
+
+        void Add(const SessionStats& session);
+        void Merge(const ProductStats& other);
+    };
+
+    struct AnalyticsResult
+    {
+        std::vector<ProductStats> Products;     // Sorted by vendor, product and version
+        uint64_t Files = 0;
+        uint64_t FailedFiles = 0;
+        uint64_t Chunks = 0;
+    };
+
+    // Distance of the rest position from the center, or -1 when the stick never rested
+    double Drift(const RestStats& rest);
+
+    // Every file is split into tasks of a few chunks, which run on a work stealing pool
+    AnalyticsResult Analyze(const std::vector<std::string>& files, unsigned threads = 0);
+}
@@ -0,0 +1,91 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Append-only store of bench test results, indexed by product and instance
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "gd_sample.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// A results file is a BenchHeader followed by BenchRecords. Records are only ever appended and each one
+// carries its own CRC-32, so a record that was cut short by a crash is dropped the next time the file is opened.
+
+namespace GD::Record
+{
+    constexpr uint32_t BenchMagic = 0x4e424447;     // 'GDBN'
+    constexpr uint32_t BenchVersion = 1;
+
+    struct BenchHeader
+    {
+        uint32_t Magic = BenchMagic;
+        uint32_t Version = BenchVersion;
+        uint32_t RecordSize = 0;
+        uint32_t Reserved = 0;
+    };
+    static_assert(sizeof(BenchHeader) == 16, "BenchHeader layout changed");
+
+    // The result of one test session of one device
+    struct BenchRecord
+    {
+        uint16_t VendorId = 0;
+        uint16_t ProductId = 0;
+        uint16_t ProductVersion = 0;
+        uint8_t Slot = 0;               // The instance: which station the device was tested on
+        uint8_t SubType = 0;
+        uint64_t Time = 0;              // Seconds since 1970, UTC
+        uint32_t Duration = 0;          // Milliseconds
+        uint32_t Samples = 0;
+        uint32_t MissedPackets = 0;
+        uint32_t PeakBacklog = 0;       // Most samples that waited for the analysis at once
+        float ReportRate = 0;           // Hz, from the median interval
+        float IntervalP50 = 0;          // Microseconds
+        float IntervalP99 = 0;
+        float IntervalMax = 0;
+        int16_t Deadzone[Axis_Count]{}; // Smallest non-zero magnitude, 0 when the axis never moved
+        float EffectiveBits[Axis_Count]{};
+        uint32_t Presses = 0;
+        uint32_t Chatter = 0;
+        uint32_t Checksum = 0;          // CRC-32 of the record with Checksum = 0
+    };
+    static_assert(sizeof(BenchRecord) == 96, "BenchRecord layout changed");
+
+    class BenchStore
+    {
+    public:
+        BenchStore() = default;
+        ~BenchStore() { Close(); }
+        BenchStore(const BenchStore&) = delete;
+        BenchStore& operator=(const BenchStore&) = delete;
+
+        // Creates the file when it does not exist yet
+        bool Open(const char* path);
+        void Close();
+        bool IsOpen() const { return m_File != nullptr; }
+        const std::string& Error() const { return m_Error; }
+
+        bool Append(const BenchRecord& record);
+
+        size_t Count() const { return m_Records.size(); }
+        const BenchRecord& Record(size_t index) const { return m_Records[index]; }
+        // Indices of the records of a product in the order they were added, slot -1 takes all instances
+        std::vector<size_t> Find(uint16_t vendorId, uint16_t productId, int slot = -1) const;
+        // Every product and instance that has records, sorted
+        std::vector<uint64_t> Keys() const;
+
+        static uint64_t Key(uint16_t vendorId, uint16_t productId, uint8_t slot) { return ((uint64_t)vendorId << 24) | ((uint64_t)productId << 8) | slot; }
+
+    private:
+        bool Fail(const std::string& error);
+        void Index(size_t index);
+
+        FILE* m_File = nullptr;
+        std::vector<BenchRecord> m_Records;
+        // Sorted by key and then by index, so a product is a contiguous range
+        std::vector<std::pair<uint64_t, size_t>> m_Index;
+        std::string m_Error;
+    };
+}
@@ -0,0 +1,62 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Compare the behavior of a device in two recordings
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "gd_sample.h"
+#include <string>
+#include <vector>
+
+namespace GD::Record
+{
+    struct DiffOptions
+    {
+        int DeviceA = -1;               // Device id, -1 picks the first device of the recording
+        int DeviceB = -1;
+        bool Align = true;              // Find Offset from the first press or stick movement, refined with GD::Record::Align
+        int64_t Offset = 0;             // Microseconds added to the timestamps of B to line them up with A
+        uint64_t MatchWindow = 100000;  // Edges further apart than this are not the same event
+        double Alpha = 0.01;            // Significance level over all tests together
+        double Tolerance = 0.01;        // Fraction of the axis range that the smallest value and the number of values may differ by
+    };
+
+    struct DiffMetric
+    {
+        std::string Name;
+        double A = 0.0;
+        double B = 0.0;
+        double PValue = -1.0;           // -1 for exact properties, which are compared with DiffOptions::Tolerance
+        bool Significant = false;
+    };
+
+    // How much later B shows the same input than A, a single measurement over the matched edges
+    struct DiffDelay
+    {
+        std::string Name;
+        double Delay = 0.0;             // Milliseconds
+        double PValue = 1.0;            // Against no delay at all
+        bool Significant = false;
+    };
+
+    struct DiffResult
+    {
+        DeviceInfo InfoA;
+        DeviceInfo InfoB;
+        int64_t Offset = 0;
+        double Correlation = 0.0;       // From the alignment, 0 when Offset was given or the alignment was not used
+        uint64_t Overlap = 0;           // Microseconds that both recordings cover
+        uint64_t SamplesA = 0;
+        uint64_t SamplesB = 0;
+        uint64_t MatchedEdges = 0;
+        std::vector<DiffDelay> Delays;
+        std::vector<DiffMetric> Metrics;
+    };
+
+    // Streams both recordings side by side, only the part where they overlap is compared.
+    // Report rate, noise and latency are tested for significance, the smallest value off 0 and resolution are compared exactly.
+    // The edge delay is only meaningful when Offset comes from a clock that both recordings share.
+    bool Diff(const char* a, const char* b, const DiffOptions& options, DiffResult& result, std::string& error);
+}
@@ -0,0 +1,26 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Convert recordings to formats that other tools understand
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace GD::Record
+{
+    // Apache Parquet with one column per field (timestamp, dwPacketNumber, device, wButtons and the axes).
+    // Columns are stored in row groups of ParquetRowGroupRows rows, as delta / bit packed pages with min / max statistics.
+    // Only one page per column is kept in memory, besides the encoded data of the current row group.
+    constexpr uint32_t ParquetRowGroupRows = 1 << 20;
+    bool ExportParquet(const char* recording, const char* output, std::string& error);
+
+    // Value Change Dump for waveform viewers, with a scope per device holding a wire per button and a real per axis.
+    // Only changes are written, so long sessions where the controller is mostly idle stay small.
+    bool ExportVcd(const char* recording, const char* output, std::string& error);
+
+    // Picks the format from the extension of output
+    bool Export(const char* recording, const char* output, std::string& error);
+}
@@ -0,0 +1,221 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     On-disk layout and sample codec of recordings
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "gd_sample.h"
+#include <string>
+#include <vector>
+
+// A recording is laid out as:
+//
+//  FileHeader
+//  Block[]         either a chunk or a log block
+//    Chunk         ChunkHeader, ChunkSummary, keyframe (KeyframeEntry[DeviceCount]), delta coded records
+//    Log block     LogBlockHeader, log records
+//  IndexEntry[]    one per chunk, sorted by timestamp
+//  Footer
+//
+// Every chunk starts with the full state of all devices, so decoding can start at any chunk.
+// The summary describes all states that were active during the chunk, queries use it to skip chunks.
+// The index and footer are plain structs, so a reader can use them directly from a file mapping.
+//
+// The file is only ever appended to. Chunks and the index carry a CRC-32, so after a crash the file
+// can be cut back to the last complete chunk and get a new index (see Recover).
+
+namespace GD::Record
+{
+    constexpr uint32_t FileMagic = 0x43524447;      // 'GDRC'
+    constexpr uint32_t ChunkMagic = 0x4b434447;     // 'GDCK'
+    constexpr uint32_t FooterMagic = 0x58494447;    // 'GDIX'
+    constexpr uint32_t LogMagic = 0x474c4447;       // 'GDLG'
+    constexpr uint32_t FormatVersion = 4;
+
+    struct FileHeader
+    {
+        uint32_t Magic = FileMagic;
+        uint32_t Version = FormatVersion;
+        uint64_t StartTimestamp = 0;    // GD::Now() when the recording was started
+        uint64_t StartUnixTime = 0;     // Wall clock (microseconds since 1970) at StartTimestamp
+        uint32_t KeyframeInterval = 0;  // Microseconds between two keyframes
+        uint32_t Reserved = 0;
+    };
+    static_assert(sizeof(FileHeader) == 32, "FileHeader layout changed");
+
+    struct ChunkHeader
+    {
+        uint32_t Magic = ChunkMagic;
+        uint32_t PayloadSize = 0;       // Bytes following this header
+        uint64_t FirstTimestamp = 0;
+        uint64_t LastTimestamp = 0;
+        uint32_t RecordCount = 0;
+        uint16_t DeviceCount = 0;
+        uint16_t Reserved = 0;
+        uint32_t Checksum = 0;          // CRC-32 of this header (with Checksum = 0) and the payload
+        uint32_t Padding = 0;
+    };
+    static_assert(sizeof(ChunkHeader) == 40, "ChunkHeader layout changed");
+
+    struct ChunkSummary
+    {
+        uint16_t ButtonsOr = 0;
+        uint16_t ButtonsAnd = 0xffff;
+        uint32_t ChangeCount = 0;       // Records that changed a button or axis
+        int16_t Min[Axis_Count]{};
+        int16_t Max[Axis_Count]{};
+
+        void Add(const Sample& sample, bool first);
+    };
+    static_assert(sizeof(ChunkSummary) == 32, "ChunkSummary layout changed");
+
+    struct KeyframeEntry
+    {
+        DeviceInfo Info;
+        uint32_t Reserved = 0;
+        Sample State;
+    };
+    static_assert(sizeof(KeyframeEntry) == 48, "KeyframeEntry layout changed");
+
+    struct LogBlockHeader
+    {
+        uint32_t Magic = LogMagic;
+        uint32_t PayloadSize = 0;
+        uint32_t Count = 0;
+        uint32_t Checksum = 0;          // CRC-32 of this header (with Checksum = 0) and the payload
+    };
+    static_assert(sizeof(LogBlockHeader) == 16, "LogBlockHeader layout changed");
+
+    // Stored as: uint64_t Timestamp, uint16_t Length, char Text[Length]
+    struct LogRecord
+    {
+        uint64_t Timestamp = 0;
+        std::string Text;
+    };
+
+    struct IndexEntry
+    {
+        uint64_t Timestamp = 0;
+        uint64_t Offset = 0;
+    };
+
+    struct Footer
+    {
+        uint32_t Magic = FooterMagic;
+        uint32_t IndexCount = 0;
+        uint64_t IndexOffset = 0;
+        uint32_t Checksum = 0;          // CRC-32 of the index entries
+        uint32_t Padding = 0;
+    };
+    static_assert(sizeof(Footer) == 24, "Footer layout changed");
+
+    uint32_t Crc32(const void* data, size_t size, uint32_t crc = 0);
+
+    // Appends a complete log block to out
+    void EncodeLogBlock(const std::vector<LogRecord>& records, std::vector<uint8_t>& out);
+    // Appends the records of the log block at data to records
+    bool DecodeLogBlock(const uint8_t* data, size_t available, std::vector<LogRecord>& records);
+    // Size of the intact chunk or log block at data, 0 when there is none
+    size_t ValidBlockSize(const uint8_t* data, size_t available);
+
+    // Fields that changed since the previous record of the same device
+    enum RecordField : uint8_t
+    {
+        RecordField_Buttons = 1 << 0,
+        RecordField_LeftTrigger = 1 << 1,
+        RecordField_RightTrigger = 1 << 2,
+        RecordField_ThumbLX = 1 << 3,
+        RecordField_ThumbLY = 1 << 4,
+        RecordField_ThumbRX = 1 << 5,
+        RecordField_ThumbRY = 1 << 6,
+        RecordField_PacketJump = 1 << 7,    // PacketNumber did not simply increment
+    };
+
+    // Largest delta coded record: timestamp, device index, mask, buttons, triggers, thumbs and packet jump
+    constexpr size_t MaxRecordSize = 10 + 3 + 1 + 2 + 2 + 4 * 3 + 5;
+
+    inline void PutVarint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    inline bool GetVarint(const uint8_t*& cur, const uint8_t* end, uint64_t& value)
+    {
+        // Most deltas fit in a single byte
+        if (cur < end && *cur < 0x80)
+        {
+            value = *cur++;
+            return true;
+        }
+        value = 0;
+        for (int shift = 0; cur < end && shift < 64; shift += 7)
+        {
+            uint8_t b = *cur++;
+            value |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    inline uint64_t ZigZag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+    inline int64_t UnZigZag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+    // Builds the payload of a single chunk
+    class ChunkEncoder
+    {
+    public:
+        // Begin and Add do not allocate as long as a chunk stays within these
+        void Reserve(size_t devices, size_t records);
+        void Begin(const std::vector<KeyframeEntry>& keyframe, uint64_t timestamp);
+        // Returns false when the sample does not belong to a device of this chunk
+        bool Add(const Sample& sample);
+        // The header with its checksum, written before the summary and the payload
+        ChunkHeader Seal() const;
+
+        const ChunkHeader& Header() const { return m_Header; }
+        const ChunkSummary& Summary() const { return m_Summary; }
+        // Everything after the summary
+        const std::vector<uint8_t>& Payload() const { return m_Payload; }
+        bool Empty() const { return m_Header.RecordCount == 0; }
+
+    private:
+        ChunkHeader m_Header;
+        ChunkSummary m_Summary;
+        std::vector<uint8_t> m_Payload;
+        std::vector<Sample> m_Last;
+        uint64_t m_LastTimestamp = 0;
+    };
+
+    // Walks the records of a single chunk, starting from its keyframe
+    class ChunkDecoder
+    {
+    public:
+        // The checksum covers the whole chunk. Reader checks it once when the recording is opened,
+        // so seeking and streaming through it afterwards do not read every payload twice.
+        bool Begin(const uint8_t* chunk, size_t available, bool verify = true);
+        bool Next(Sample& sample);
+
+        const ChunkHeader& Header() const { return m_Header; }
+        const ChunkSummary& Summary() const { return m_Summary; }
+        const std::vector<KeyframeEntry>& Devices() const { return m_Devices; }
+        // Device state after the last record returned by Next
+        const Sample& State(size_t index) const { return m_Devices[index].State; }
+
+    private:
+        ChunkHeader m_Header;
+        ChunkSummary m_Summary;
+        std::vector<KeyframeEntry> m_Devices;
+        const uint8_t* m_Cur = nullptr;
+        const uint8_t* m_End = nullptr;
+        uint32_t m_Remaining = 0;
+        uint64_t m_LastTimestamp = 0;
+    };
+}
@@ -0,0 +1,135 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Min/max overview of recordings at every zoom level
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "record/gd_RecordReader.h"
+#include <string>
+#include <vector>
+
+// The overview of a recording is kept next to it, in <recording>.gdmm:
+//
+//  PyramidHeader
+//  PyramidBlock, Bucket[PyramidBlock::Count], ...
+//
+// Level 0 has one bucket per 2^PyramidBaseShift microseconds since FileHeader::StartTimestamp,
+// every next level merges two buckets of the level below. A view that is zoomed in further
+// than level 0 decodes the chunks it covers instead, which is cheap through the index.
+//
+// While recording, the level-0 buckets that are complete are appended after every chunk, so the overview never
+// has to be held in memory. Only level 0 is stored, the upper levels are built when the overview is loaded.
+// After a crash the blocks up to the last intact chunk are kept, and the chunks after them are decoded again.
+
+namespace GD::Record
+{
+    constexpr uint32_t PyramidMagic = 0x4d4d4447;   // 'GDMM'
+    constexpr uint32_t PyramidVersion = 2;
+    constexpr uint32_t PyramidBaseShift = 15;       // About 33 ms per bucket on level 0
+    constexpr const char* PyramidExtension = ".gdmm";
+
+    // The range of every axis and the buttons that were down during a span of time, empty when nothing was held
+    struct Bucket
+    {
+        int16_t Min[Axis_Count];
+        int16_t Max[Axis_Count];
+        uint16_t ButtonsOr;
+        uint16_t ButtonsAnd;
+
+        Bucket() { Clear(); }
+        void Clear();
+        bool Empty() const { return Min[0] > Max[0]; }
+        void Add(const Sample& sample);
+        void Merge(const Bucket& other);
+    };
+    static_assert(sizeof(Bucket) == 28, "Bucket layout changed");
+
+    struct PyramidHeader
+    {
+        uint32_t Magic = PyramidMagic;
+        uint32_t Version = PyramidVersion;
+        uint32_t BaseShift = PyramidBaseShift;
+        uint32_t Reserved = 0;
+        // The recording this was built from, a different recording at the same path no longer matches
+        uint64_t StartTimestamp = 0;
+        // Both 0 until the recording is closed
+        uint64_t LastTimestamp = 0;
+        uint32_t ChunkCount = 0;
+        uint32_t Reserved2 = 0;
+    };
+    static_assert(sizeof(PyramidHeader) == 40, "PyramidHeader layout changed");
+
+    // The next level-0 buckets of one device, written once the chunk before it is in the recording
+    struct PyramidBlock
+    {
+        DeviceInfo Info;
+        uint32_t Count = 0;
+        uint64_t First = 0;             // Level-0 index of the first bucket, the blocks of a device follow each other
+        uint64_t ChunkTimestamp = 0;    // Of that chunk, a recovered or rewritten recording no longer matches
+        uint32_t Chunk = 0;
+        uint32_t Holding = 0;           // The device was connected, so its next bucket was not complete yet
+        uint32_t Reserved = 0;
+        uint32_t Checksum = 0;          // CRC-32 of the block with this field 0, and of its buckets
+    };
+    static_assert(sizeof(PyramidBlock) == 48, "PyramidBlock layout changed");
+
+    // Built one sample at a time, while recording or by walking an existing recording.
+    // Adding only fills level 0, BuildLevels merges it upwards once it is complete.
+    class Pyramid
+    {
+    public:
+        void Begin(uint64_t startTimestamp);
+        void Add(const DeviceInfo& info, const Sample& sample);
+        // The device is gone, its last state is not held any longer
+        void RemoveDevice(uint16_t id);
+        // Holds the last states up to lastTimestamp
+        void Finish(uint64_t lastTimestamp);
+        void BuildLevels();
+
+        // For writing level 0 while recording: the header goes first and is written again on close with the chunk count.
+        // AppendFinished writes the buckets that are complete after the given chunk, and drops them from memory.
+        bool WriteHeader(FILE* file, uint32_t chunkCount) const;
+        bool AppendFinished(FILE* file, uint32_t chunk, uint64_t chunkTimestamp);
+
+        bool Save(const char* path, const Reader& reader) const;
+        // Fails when the file is missing, damaged beyond its first block or was built from a different recording
+        bool Load(const char* path, const Reader& reader);
+
+        size_t DeviceCount() const { return m_Devices.size(); }
+        const DeviceInfo& Device(size_t index) const { return m_Devices[index].Info; }
+        int FindDevice(uint16_t id) const;
+
+        // One bucket per column for [start, end), from the coarsest level with at least two buckets per column.
+        // Returns false when the view is zoomed in further than level 0 allows.
+        bool Query(size_t device, uint64_t start, uint64_t end, int columns, std::vector<Bucket>& out, int* level = nullptr) const;
+
+    private:
+        struct DeviceLevels
+        {
+            DeviceInfo Info;
+            std::vector<std::vector<Bucket>> Levels;
+            uint64_t Written = 0;       // Level-0 buckets that were appended to the file and dropped
+            Sample Held;
+            bool Holding = false;
+            uint64_t Current = 0;       // Level-0 bucket that Pending belongs to
+            Bucket Pending;
+        };
+
+        DeviceLevels& Find(const DeviceInfo& info);
+        void HoldUntil(DeviceLevels& device, uint64_t bucket);
+        bool WriteBlock(FILE* file, const DeviceLevels& device, uint32_t chunk, uint64_t chunkTimestamp) const;
+
+        uint64_t m_StartTimestamp = 0;
+        uint64_t m_LastTimestamp = 0;
+        std::vector<DeviceLevels> m_Devices;
+    };
+
+    // One bucket per column for [start, end) of a single device, from the pyramid when it has a fitting level
+    // and from the chunks otherwise (level -1). pyramid may be nullptr.
+    void Decimate(const Reader& reader, const Pyramid* pyramid, uint16_t device, uint64_t start, uint64_t end, int columns, std::vector<Bucket>& out, int* level = nullptr);
+
+    // Walks the whole recording, for recordings that have no (or an outdated) overview
+    bool BuildPyramid(const Reader& reader, Pyramid& pyramid);
+}
@@ -0,0 +1,53 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Search recordings for device states, using the chunk summaries
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "record/gd_RecordFormat.h"
+#include <string>
+
+namespace GD::Record
+{
+    // A condition on the state of a single device, all terms have to hold at the same time
+    struct Condition
+    {
+        uint16_t ButtonsDown = 0;
+        uint16_t ButtonsUp = 0;
+        int32_t Min[Axis_Count];
+        int32_t Max[Axis_Count];
+        int Device = -1;
+        uint64_t MinDuration = 0;       // Microseconds the condition has to hold
+
+        Condition();
+
+        bool Matches(const Sample& sample) const;
+        // False when no state described by the summary can match
+        bool MayMatch(const ChunkSummary& summary) const;
+    };
+
+    // Parses terms like "GUIDE", "!LEFT_THUMB", "sThumbLX>30000", "device=1" and "for>=2s"
+    bool ParseCondition(const char* text, Condition& condition, std::string& error);
+    // "500us", "200ms", "2s", a plain number is in milliseconds
+    bool ParseDuration(const char* text, uint64_t& duration);
+
+    struct QueryMatch
+    {
+        uint32_t File = 0;
+        uint16_t Device = 0;
+        uint64_t Start = 0;
+        uint64_t End = 0;
+    };
+
+    struct QueryStats
+    {
+        uint64_t Chunks = 0;
+        uint64_t DecodedChunks = 0;
+        uint32_t FailedFiles = 0;
+    };
+
+    // Matches are sorted by file and start time. threads == 0 uses all cores.
+    std::vector<QueryMatch> RunQuery(const Condition& condition, const std::vector<std::string>& files, unsigned threads = 0, QueryStats* stats = nullptr);
+}
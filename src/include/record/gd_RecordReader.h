@@ -0,0 +1,90 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Random access to recordings through the chunk index
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "record/gd_RecordFormat.h"
+#include "gd_file.h"
+#include <string>
+#include <vector>
+
+namespace GD::Record
+{
+    class Reader
+    {
+    public:
+        bool Open(const char* path);
+        void Close();
+        bool IsOpen() const { return m_Index != nullptr; }
+        const std::string& Error() const { return m_Error; }
+
+        const FileHeader& Header() const { return m_Header; }
+        uint64_t FirstTimestamp() const { return m_IndexCount ? m_Index[0].Timestamp : 0; }
+        uint64_t LastTimestamp() const { return m_LastTimestamp; }
+
+        size_t ChunkCount() const { return m_IndexCount; }
+        const IndexEntry& Chunk(size_t index) const { return m_Index[index]; }
+        // Last chunk starting at or before timestamp (the first chunk when timestamp is before the recording)
+        size_t FindChunk(uint64_t timestamp) const;
+        // Fails for a chunk that did not match its checksum when the recording was opened
+        bool BeginChunk(size_t index, ChunkDecoder& decoder) const;
+        // Reads the fixed part of a chunk without decoding it
+        void ReadChunkHeader(size_t index, ChunkHeader& header, ChunkSummary& summary) const;
+
+        // Device states at timestamp, this decodes at most a single chunk
+        bool Seek(uint64_t timestamp, std::vector<KeyframeEntry>& devices) const;
+
+        // Collects the log records of all log blocks
+        void ReadLog(std::vector<LogRecord>& records) const;
+
+        // The first device with this id in the keyframes, id -1 takes the first device of the recording
+        bool FindDevice(int id, DeviceInfo& info) const;
+
+    private:
+        bool Fail(const char* error);
+
+        MappedFile m_File;
+        FileHeader m_Header;
+        const IndexEntry* m_Index = nullptr;
+        size_t m_IndexCount = 0;
+        uint64_t m_IndexOffset = 0;
+        uint64_t m_LastTimestamp = 0;
+        std::vector<bool> m_Damaged;
+        std::string m_Error;
+    };
+
+    // Walks all records of a recording in order, with only a single chunk decoded at a time
+    class SampleStream
+    {
+    public:
+        explicit SampleStream(const Reader& reader) : m_Reader(reader) {}
+
+        bool Next(Sample& sample);
+        // The chunk of the last sample returned by Next, and its devices
+        size_t Chunk() const { return m_Chunk; }
+        const std::vector<KeyframeEntry>& Devices() const { return m_Decoder.Devices(); }
+
+    private:
+        const Reader& m_Reader;
+        ChunkDecoder m_Decoder;
+        size_t m_Chunk = 0;
+        bool m_Started = false;
+    };
+
+    // The samples of a single device, with an offset added to the timestamps
+    class DeviceStream
+    {
+    public:
+        DeviceStream(const Reader& reader, uint16_t device, int64_t offset = 0) : m_Stream(reader), m_Device(device), m_Offset(offset) {}
+
+        bool Next(Sample& sample);
+
+    private:
+        SampleStream m_Stream;
+        uint16_t m_Device;
+        int64_t m_Offset;
+    };
+}
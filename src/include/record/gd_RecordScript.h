@@ -0,0 +1,117 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Scripted input tests, run against live devices or recordings
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "record/gd_RecordQuery.h"
+#include <string>
+#include <vector>
+
+namespace GD::Record
+{
+    struct ScriptStep
+    {
+        std::string Text;
+        int Line = 0;
+        Condition When;                 // Its "for>=" is how long the condition has to hold
+        uint64_t Within = 0;            // Microseconds after the previous step, 0 waits forever
+    };
+
+    struct ScriptTest
+    {
+        std::string Name;
+        std::vector<ScriptStep> Steps;
+    };
+
+    struct Script
+    {
+        std::vector<ScriptTest> Tests;
+    };
+
+    // "test <name>" starts a test, every line after it is a step: a condition as ParseCondition takes it,
+    // optionally followed by "within <duration>". "#" starts a comment. For example:
+    //
+    //   test A then RT
+    //       A
+    //       RT>200 within 200ms
+    //       !A RT<30 within 1s
+    bool ParseScript(const char* text, Script& script, std::string& error);
+    bool LoadScript(const char* path, Script& script, std::string& error);
+
+    struct StepResult
+    {
+        uint64_t Start = 0;             // When the condition started to hold
+        uint64_t End = 0;               // When it had held long enough
+        int64_t Margin = 0;             // Time that was left of the window, 0 without one
+    };
+
+    enum TestState
+    {
+        Test_Pending,
+        Test_Running,
+        Test_Passed,
+        Test_Failed,
+    };
+
+    struct TestResult
+    {
+        TestState State = Test_Pending;
+        uint64_t Start = 0;
+        uint64_t End = 0;
+        std::string Message;            // Why it failed
+        std::vector<StepResult> Steps;  // The steps that passed
+
+        // The smallest margin of the steps with a window, false when none of them had one
+        bool TightestMargin(const ScriptTest& test, int64_t& margin) const;
+    };
+
+    // Runs the tests one after the other against the samples of a single device, the next test starts
+    // when the previous one passes or fails. Samples are state changes: a state holds until the next one,
+    // so holds and windows also end between samples.
+    class ScriptMatcher
+    {
+    public:
+        explicit ScriptMatcher(const Script& script);
+
+        void Add(const Sample& sample);
+        // Lets time pass without a new sample, live devices only report changes
+        void Advance(uint64_t now);
+        // No more samples, fails the test that is still running
+        void Finish(uint64_t timestamp);
+
+        const Script& GetScript() const { return m_Script; }
+        bool Done() const { return m_Test >= m_Script.Tests.size(); }
+        size_t Test() const { return m_Test; }
+        size_t Step() const { return m_Step; }
+        const std::vector<TestResult>& Results() const { return m_Results; }
+        size_t Failed() const;
+
+    private:
+        void Begin(uint64_t timestamp);
+        void Fail(uint64_t timestamp, const std::string& message);
+        void Settle(uint64_t now);
+
+        Script m_Script;
+        std::vector<TestResult> m_Results;
+        size_t m_Test = 0;
+        size_t m_Step = 0;
+        bool m_Started = false;
+        Sample m_State;
+        uint64_t m_Since = 0;           // Since when m_State holds
+        uint64_t m_Reference = 0;       // End of the previous step, or the start of the test
+        bool m_Holding = false;
+        uint64_t m_HoldStart = 0;
+    };
+
+    struct ScriptDeviceResult
+    {
+        DeviceInfo Info;
+        std::vector<TestResult> Tests;
+    };
+
+    // Every device in the recording runs the whole script
+    bool RunScript(const Script& script, const char* recording, std::vector<ScriptDeviceResult>& results, std::string& error);
+}
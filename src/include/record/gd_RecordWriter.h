@@ -0,0 +1,116 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Write controller samples to a recording
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+
+#pragma once
+
+#include "record/gd_RecordFormat.h"
+#include "record/gd_RecordPyramid.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace GD::Record
+{
+    constexpr uint32_t DefaultKeyframeInterval = 1000000;
+    constexpr uint32_t MaxChunkPayload = 1 << 20;
+    constexpr size_t WriterQueueSize = 16384;       // Commands, 4 devices at 1 kHz for 4 seconds
+
+    // Encoding and disk access happen on a background thread, the public functions only queue work
+    // and are safe to call from the polling path. They may come from several threads, but not at
+    // the same time (GD::Recorder holds its lock). Without the background thread (for crash dumps)
+    // every call writes directly.
+    class Writer
+    {
+    public:
+        Writer() = default;
+        ~Writer() { Close(); }
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        // Samples from another clock than GD::Now, like copies of a recording, pass the start of that clock
+        bool Open(const char* path, uint32_t keyframeInterval = DefaultKeyframeInterval, bool background = true, uint64_t startTimestamp = 0);
+        // Finishes the last chunk, writes the index and puts the overview next to the recording
+        void Close();
+        bool IsOpen() const { return m_File != nullptr; }
+
+        // Device changes end the current chunk, so every chunk has a fixed set of devices
+        void AddDevice(const DeviceInfo& info, const Sample& state);
+        void RemoveDevice(uint16_t id);
+        void Append(const Sample& sample);
+        void AppendLog(uint64_t timestamp, const char* text, size_t length);
+
+        uint64_t BytesWritten() const { return m_Offset; }
+        // Samples that did not fit in the queue because the writer thread fell behind
+        uint64_t Dropped() const { return m_Dropped; }
+
+    private:
+        enum CommandType : uint8_t
+        {
+            Command_Sample,
+            Command_AddDevice,
+            Command_RemoveDevice,
+        };
+
+        struct Command
+        {
+            CommandType Type;
+            DeviceInfo Info;
+            Sample State;
+        };
+
+        bool Queue(const Command& command);
+        void ThreadProc();
+        void Process(const Command& command);
+        void FlushChunk();
+        void FlushLog();
+
+        FILE* m_File = nullptr;
+        FileHeader m_Header;
+        std::string m_Path;
+
+        std::thread m_Thread;
+        std::mutex m_Lock;
+        std::condition_variable m_Wake;
+        std::vector<LogRecord> m_LogQueue;
+        bool m_Stop = false;
+
+        // A ring that the writer thread empties. Appending a sample does not lock or allocate,
+        // when the ring is full the sample is dropped and counted. Device changes wait for room.
+        std::unique_ptr<Command[]> m_Queue;
+        std::atomic<size_t> m_QueueHead{ 0 };   // Next to fill, only moved by the producer
+        std::atomic<size_t> m_QueueTail{ 0 };   // Next to process, only moved by the writer thread
+        std::atomic<uint64_t> m_Dropped{ 0 };
+
+        // Only used by the writer thread
+        ChunkEncoder m_Encoder;
+        bool m_ChunkOpen = false;
+        std::vector<KeyframeEntry> m_Devices;
+        std::vector<IndexEntry> m_Index;
+        std::vector<LogRecord> m_Log;
+        std::vector<uint8_t> m_LogBlock;
+        Pyramid m_Pyramid;
+        FILE* m_PyramidFile = nullptr;
+        uint64_t m_LastTimestamp = 0;   // Of the last sample, and of the last chunk once it is flushed
+        uint64_t m_ChunkTimestamp = 0;
+        std::atomic<uint64_t> m_Offset{ 0 };
+    };
+
+    struct RecoverResult
+    {
+        uint64_t OriginalSize = 0;
+        uint64_t ValidSize = 0;         // Header and all intact chunks
+        uint32_t Chunks = 0;
+        bool HadIndex = false;
+    };
+
+    // Cuts a recording back to its last intact chunk and writes a new index.
+    // Files that already have a valid index are left alone.
+    bool Recover(const char* path, RecoverResult& result, std::string& error);
+}
@@ -207,6 +207,33 @@ void ResetDevice()
     ImGui_ImplDX9_CreateDeviceObjects();
 }
 
+// Managed textures are restored by D3D9 itself after a reset
+ImTextureID GD_CreateTexture(int width, int height)
+{
+    LPDIRECT3DTEXTURE9 texture = nullptr;
+    if (!g_pd3dDevice || g_pd3dDevice->CreateTexture(width, height, 1, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &texture, nullptr) < 0)
+        return 0;
+    return (ImTextureID)texture;
+}
+
+bool GD_UpdateTexture(ImTextureID texture, const uint32_t* pixels, int width, int height)
+{
+    LPDIRECT3DTEXTURE9 d3dTexture = (LPDIRECT3DTEXTURE9)texture;
+    D3DLOCKED_RECT rect;
+    if (!d3dTexture || d3dTexture->LockRect(0, &rect, nullptr, 0) < 0)
+        return false;
+    for (int y = 0; y < height; ++y)
+        memcpy((uint8_t*)rect.pBits + (size_t)rect.Pitch * y, pixels + (size_t)width * y, (size_t)width * sizeof(uint32_t));
+    d3dTexture->UnlockRect(0);
+    return true;
+}
+
+void GD_DestroyTexture(ImTextureID texture)
+{
+    if (texture)
+        ((LPDIRECT3DTEXTURE9)texture)->Release();
+}
+
 // Forward declare message handler from imgui_impl_win32.cpp
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
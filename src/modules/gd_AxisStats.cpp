@@ -0,0 +1,336 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Running statistics and rest drift of the XInput axes
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_log.h"
+#include "modules/gd_AxisStats.h"
+#include "imgui.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+using GD::AxisStats::Slots;
+
+// A stick rests when it stays within StillRange for SettleTicks polls, inside twice its threshold.
+// The rest center is the mean of those positions, and later an average over the last RestWindow of them,
+// so it follows a stick that drifts over a long session.
+constexpr int Inputs = 4;
+constexpr double SettleTicks = 100;
+constexpr double RestWindow = 65536;
+constexpr double MinRestTicks = 1000;                       // Before that the rest center is not trusted
+constexpr double DriftClear = 0.9;                          // Fraction of the threshold to fall back under, so the flag does not flicker
+constexpr int MaxChanges = 64;                              // Drift changes waiting for the next frame, more are not logged
+
+struct InputDef
+{
+    const char* Name;
+    int X;
+    int Y;                                                  // -1 for the triggers
+    int32_t Threshold;                                      // The same values analog_glyph uses
+    double StillRange;
+};
+
+static const InputDef s_Inputs[Inputs] = {
+    { "Left stick", GD::Axis_ThumbLX, GD::Axis_ThumbLY, GD::LeftThumbDeadzone, 512.0 },
+    { "Right stick", GD::Axis_ThumbRX, GD::Axis_ThumbRY, GD::RightThumbDeadzone, 512.0 },
+    { "Left trigger", GD::Axis_LeftTrigger, -1, GD::TriggerThreshold, 4.0 },
+    { "Right trigger", GD::Axis_RightTrigger, -1, GD::TriggerThreshold, 4.0 },
+};
+
+// The slot is the innermost index everywhere, so every step below handles all four slots at once.
+// Inactive slots take part with a weight of 0, which keeps the loops free of branches.
+struct AxisState
+{
+    alignas(32) double Count[Slots];
+    alignas(32) double Mean[GD::Axis_Count][Slots];
+    alignas(32) double M2[GD::Axis_Count][Slots];          // Sum of squared differences from the mean (Welford)
+    alignas(32) double Min[GD::Axis_Count][Slots];
+    alignas(32) double Max[GD::Axis_Count][Slots];
+
+    alignas(32) double Anchor[Inputs][2][Slots];
+    alignas(32) double Still[Inputs][Slots];
+    alignas(32) double RestCount[Inputs][Slots];
+    alignas(32) double Rest[Inputs][2][Slots];
+    alignas(32) double Drifting[Inputs][Slots];             // 0 or 1
+};
+
+struct DriftChange
+{
+    int Slot;
+    int Input;
+    bool Drifting;
+    double X, Y;
+};
+
+// Shared with the sampling thread
+static std::mutex s_Lock;
+static AxisState s_State;
+static bool s_Active[Slots]{};
+static bool s_ResetRequested[Slots]{};
+static DriftChange s_Changes[MaxChanges];                   // Logged from the main thread, GD_Log needs ImGui
+static int s_ChangeCount = 0;
+
+// Owned by the UI
+static bool s_Visible = false;
+
+
+static void ResetSlot(int slot, const GD::Sample& sample)
+{
+    s_State.Count[slot] = 0.0;
+    for (int axis = 0; axis < GD::Axis_Count; ++axis)
+    {
+        s_State.Mean[axis][slot] = 0.0;
+        s_State.M2[axis][slot] = 0.0;
+        s_State.Min[axis][slot] = std::numeric_limits<double>::infinity();
+        s_State.Max[axis][slot] = -std::numeric_limits<double>::infinity();
+    }
+    for (int input = 0; input < Inputs; ++input)
+    {
+        const auto& def = s_Inputs[input];
+        s_State.Anchor[input][0][slot] = GD::GetAxis(sample, def.X);
+        s_State.Anchor[input][1][slot] = def.Y >= 0 ? GD::GetAxis(sample, def.Y) : 0.0;
+        s_State.Still[input][slot] = 0.0;
+        s_State.RestCount[input][slot] = 0.0;
+        s_State.Rest[input][0][slot] = 0.0;
+        s_State.Rest[input][1][slot] = 0.0;
+        s_State.Drifting[input][slot] = 0.0;
+    }
+}
+
+void GD::AxisStats::Update(const Sample (&samples)[Slots], const bool (&active)[Slots])
+{
+    alignas(32) double weight[Slots];
+    alignas(32) double values[Axis_Count][Slots];
+    for (int slot = 0; slot < Slots; ++slot)
+    {
+        weight[slot] = active[slot] ? 1.0 : 0.0;
+        for (int axis = 0; axis < Axis_Count; ++axis)
+            values[axis][slot] = GetAxis(samples[slot], axis);
+    }
+
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (int slot = 0; slot < Slots; ++slot)
+    {
+        if ((active[slot] && !s_Active[slot]) || s_ResetRequested[slot])
+            ResetSlot(slot, samples[slot]);
+        s_Active[slot] = active[slot];
+        s_ResetRequested[slot] = false;
+    }
+
+    AxisState& state = s_State;
+    for (int slot = 0; slot < Slots; ++slot)
+        state.Count[slot] += weight[slot];
+
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        for (int slot = 0; slot < Slots; ++slot)
+        {
+            double x = values[axis][slot];
+            double w = weight[slot];
+            double delta = x - state.Mean[axis][slot];
+            state.Mean[axis][slot] += delta * w / std::max(state.Count[slot], 1.0);
+            state.M2[axis][slot] += w * delta * (x - state.Mean[axis][slot]);
+            state.Min[axis][slot] = std::min(state.Min[axis][slot], w > 0.0 ? x : state.Min[axis][slot]);
+            state.Max[axis][slot] = std::max(state.Max[axis][slot], w > 0.0 ? x : state.Max[axis][slot]);
+        }
+    }
+
+    double before[Inputs][Slots];
+    std::copy(&state.Drifting[0][0], &state.Drifting[0][0] + Inputs * Slots, &before[0][0]);
+
+    for (int input = 0; input < Inputs; ++input)
+    {
+        const auto& def = s_Inputs[input];
+        static const double zero[Slots]{};
+        const double* x = values[def.X];
+        const double* y = def.Y >= 0 ? values[def.Y] : zero;
+        double gate = 4.0 * def.Threshold * def.Threshold;
+        double trip = (double)def.Threshold * def.Threshold;
+        double clear = trip * DriftClear * DriftClear;
+
+        for (int slot = 0; slot < Slots; ++slot)
+        {
+            double w = weight[slot];
+            double* anchorX = &state.Anchor[input][0][slot];
+            double* anchorY = &state.Anchor[input][1][slot];
+            double moved = std::max(std::fabs(x[slot] - *anchorX), std::fabs(y[slot] - *anchorY)) > def.StillRange ? 1.0 : 0.0;
+            *anchorX += moved * (x[slot] - *anchorX);
+            *anchorY += moved * (y[slot] - *anchorY);
+            double& still = state.Still[input][slot];
+            still = (still + w) * (1.0 - moved);
+
+            double inside = x[slot] * x[slot] + y[slot] * y[slot] < gate ? 1.0 : 0.0;
+            double resting = w * inside * (still >= SettleTicks ? 1.0 : 0.0);
+            double& count = state.RestCount[input][slot];
+            count += resting;
+            double alpha = resting / std::max(std::min(count, RestWindow), 1.0);
+            double& restX = state.Rest[input][0][slot];
+            double& restY = state.Rest[input][1][slot];
+            restX += alpha * (x[slot] - restX);
+            restY += alpha * (y[slot] - restY);
+
+            double offset = restX * restX + restY * restY;
+            double& drifting = state.Drifting[input][slot];
+            double beyond = offset >= (drifting > 0.0 ? clear : trip) ? 1.0 : 0.0;
+            double trusted = count >= MinRestTicks ? 1.0 : 0.0;
+            drifting += w * (beyond * trusted - drifting);
+        }
+    }
+
+    for (int input = 0; input < Inputs; ++input)
+    {
+        for (int slot = 0; slot < Slots; ++slot)
+        {
+            if (state.Drifting[input][slot] != before[input][slot] && s_ChangeCount < MaxChanges)
+                s_Changes[s_ChangeCount++] = { slot, input, state.Drifting[input][slot] > 0.0, state.Rest[input][0][slot], state.Rest[input][1][slot] };
+        }
+    }
+}
+
+static void LogChanges()
+{
+    DriftChange changes[MaxChanges];
+    std::unique_lock<std::mutex> lock(s_Lock);
+    int count = s_ChangeCount;
+    std::copy(s_Changes, s_Changes + count, changes);
+    s_ChangeCount = 0;
+    lock.unlock();
+
+    for (int n = 0; n < count; ++n)
+    {
+        const auto& change = changes[n];
+        const auto& def = s_Inputs[change.Input];
+        if (change.Drifting)
+            GD_Log("XInput controller %d: %s rests at %.0f, %.0f, outside the threshold of %d\n", change.Slot, def.Name, change.X, change.Y, def.Threshold);
+        else
+            GD_Log("XInput controller %d: %s rests within the threshold again\n", change.Slot, def.Name);
+    }
+}
+
+void GD::AxisStats::RenderFrame()
+{
+    // Also while the window is closed, the log is where drift shows up first
+    LogChanges();
+    if (!s_Visible)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(560, 420), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Axis statistics", &s_Visible))
+    {
+        ImGui::End();
+        return;
+    }
+
+    // Copy what is needed, the sampling thread keeps going
+    AxisState state;
+    bool active[Slots];
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        state = s_State;
+        std::copy(s_Active, s_Active + Slots, active);
+    }
+
+    bool any = false;
+    for (int slot = 0; slot < Slots; ++slot)
+    {
+        if (!active[slot])
+            continue;
+        any = true;
+
+        ImGui::PushID(slot);
+        char label[32];
+        snprintf(label, sizeof(label), "XUser %d", slot);
+        bool open = ImGui::CollapsingHeader(label, ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_AllowOverlap);
+        ImGui::SameLine(ImGui::GetContentRegionAvail().x - 60);
+        if (ImGui::SmallButton("Reset"))
+        {
+            std::unique_lock<std::mutex> lock(s_Lock);
+            s_ResetRequested[slot] = true;
+        }
+        if (!open)
+        {
+            ImGui::PopID();
+            continue;
+        }
+
+        double count = state.Count[slot];
+        ImGui::Text("%.0f polls", count);
+        if (ImGui::BeginTable("axes", 5, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Axis");
+            ImGui::TableSetupColumn("Mean");
+            ImGui::TableSetupColumn("Std dev");
+            ImGui::TableSetupColumn("Min");
+            ImGui::TableSetupColumn("Max");
+            ImGui::TableHeadersRow();
+            for (int axis = 0; axis < Axis_Count && count > 0; ++axis)
+            {
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(GD::AxisName(axis));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", state.Mean[axis][slot]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", count > 1 ? std::sqrt(state.M2[axis][slot] / (count - 1)) : 0.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.0f", state.Min[axis][slot]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.0f", state.Max[axis][slot]);
+            }
+            ImGui::EndTable();
+        }
+
+        if (ImGui::BeginTable("rest", 4, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Input");
+            ImGui::TableSetupColumn("Rest center");
+            ImGui::TableSetupColumn("Offset");
+            ImGui::TableSetupColumn("State");
+            ImGui::TableHeadersRow();
+            for (int input = 0; input < Inputs; ++input)
+            {
+                const auto& def = s_Inputs[input];
+                double restX = state.Rest[input][0][slot];
+                double restY = state.Rest[input][1][slot];
+                double offset = std::sqrt(restX * restX + restY * restY);
+
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(def.Name);
+                ImGui::TableNextColumn();
+                if (def.Y >= 0)
+                    ImGui::Text("%.0f, %.0f", restX, restY);
+                else
+                    ImGui::Text("%.1f", restX);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.0f%% of %d", 100.0 * offset / def.Threshold, def.Threshold);
+                ImGui::TableNextColumn();
+                if (state.RestCount[input][slot] < MinRestTicks)
+                    ImGui::TextDisabled("Waiting for rest");
+                else if (state.Drifting[input][slot] > 0.0)
+                    ImGui::TextColored(ImVec4(1.f, 0.3f, 0.3f, 1.f), "Drift");
+                else
+                    ImGui::TextUnformatted("OK");
+            }
+            ImGui::EndTable();
+        }
+        ImGui::PopID();
+    }
+    if (!any)
+        ImGui::TextUnformatted("No devices connected");
+
+    ImGui::End();
+}
+
+void GD::AxisStats::Show()
+{
+    s_Visible = true;
+}
+
+void GD::AxisStats::Shutdown()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    std::fill(s_Active, s_Active + Slots, false);
+    std::fill(s_ResetRequested, s_ResetRequested + Slots, false);
+    s_ChangeCount = 0;
+}
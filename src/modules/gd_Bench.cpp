@@ -0,0 +1,335 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Test all connected devices at once, and keep the results per product
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_log.h"
+#include "modules/gd_Bench.h"
+#include "gd_bench.h"
+#include "imgui.h"
+#include "imgui_stdlib.h"
+#include <algorithm>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using GD::Record::BenchRecord;
+
+constexpr size_t MaxStations = 16;
+
+struct Station
+{
+    GD::DeviceInfo Info;
+    bool Connected = false;
+    std::unique_ptr<GD::BenchSession> Session;
+};
+
+// Shared with the sampling thread
+static std::mutex s_Lock;
+static Station s_Stations[MaxStations];
+static std::vector<std::unique_ptr<GD::BenchSession>> s_Finished;  // Ended by a disconnect, stored by the UI
+static bool s_Running = false;
+
+// Owned by the UI
+static bool s_Visible = false;
+static std::string s_Path = "GamepadDebug.gdbench";
+static GD::Record::BenchStore s_Store;
+static std::string s_StorePath;
+static float s_Duration = 30.f;                             // Seconds, 0 runs until stopped
+static uint64_t s_StartedAt = 0;
+
+
+static Station* FindStation(uint16_t id)
+{
+    for (auto& station : s_Stations)
+    {
+        if (station.Connected && station.Info.Id == id)
+            return &station;
+    }
+    return nullptr;
+}
+
+void GD::Bench::DeviceConnected(const DeviceInfo& info)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    Station* station = FindStation(info.Id);
+    for (size_t n = 0; n < MaxStations && !station; ++n)
+    {
+        if (!s_Stations[n].Connected)
+            station = &s_Stations[n];
+    }
+    if (!station)
+        return;
+
+    station->Info = info;
+    station->Connected = true;
+    // A device that is plugged in during a run gets a session of its own
+    if (s_Running && !station->Session)
+        station->Session = std::make_unique<GD::BenchSession>(info);
+}
+
+void GD::Bench::DeviceDisconnected(uint16_t id)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    Station* station = FindStation(id);
+    if (!station)
+        return;
+    station->Connected = false;
+    // Stopping waits for the worker, leave that to the UI
+    if (station->Session)
+        s_Finished.push_back(std::move(station->Session));
+}
+
+void GD::Bench::Submit(const Sample& sample)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    Station* station = FindStation(sample.Device);
+    if (station && station->Session)
+        station->Session->Push(sample);
+}
+
+
+static bool OpenStore()
+{
+    if (s_Store.IsOpen() && s_StorePath == s_Path)
+        return true;
+    s_StorePath = s_Path;
+    if (s_Store.Open(s_Path.c_str()))
+        return true;
+    GD_Log("%s\n", s_Store.Error().c_str());
+    return false;
+}
+
+// Sessions that ended are stopped here, so neither the sampling thread nor a disconnect waits for a worker
+static void StoreFinished(bool all)
+{
+    std::vector<std::unique_ptr<GD::BenchSession>> finished;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        finished.swap(s_Finished);
+        if (all)
+        {
+            for (auto& station : s_Stations)
+            {
+                if (station.Session)
+                    finished.push_back(std::move(station.Session));
+            }
+            s_Running = false;
+        }
+    }
+    if (finished.empty())
+        return;
+
+    bool open = OpenStore();
+    for (auto& session : finished)
+    {
+        session->Stop();
+        BenchRecord result = session->Result();
+        if (result.Samples && open && !s_Store.Append(result))
+            GD_Log("%s: %s\n", s_Path.c_str(), s_Store.Error().c_str());
+    }
+}
+
+static void StartAll()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (auto& station : s_Stations)
+    {
+        if (station.Connected && !station.Session)
+            station.Session = std::make_unique<GD::BenchSession>(station.Info);
+    }
+    s_Running = true;
+    s_StartedAt = GD::Now();
+}
+
+static void SetupColumns(const char* first)
+{
+    ImGui::TableSetupColumn(first);
+    ImGui::TableSetupColumn("Duration");
+    ImGui::TableSetupColumn("Rate");
+    ImGui::TableSetupColumn("p99 interval");
+    ImGui::TableSetupColumn("Missed");
+    ImGui::TableSetupColumn("Deadzone L / R");
+    ImGui::TableSetupColumn("Bits L / R");
+    ImGui::TableSetupColumn("Presses");
+    ImGui::TableSetupColumn("Chatter");
+    ImGui::TableHeadersRow();
+}
+
+// Everything after the first column, the sticks show the worse of their two axes
+static void RenderColumns(const BenchRecord& record)
+{
+    ImGui::TableNextColumn();
+    ImGui::Text("%.1f s", record.Duration / 1e3);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.0f Hz", record.ReportRate);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.2f ms", record.IntervalP99 / 1e3);
+    ImGui::TableNextColumn();
+    if (record.MissedPackets)
+        ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(160, 40, 40, 255));
+    ImGui::Text("%u", record.MissedPackets);
+    ImGui::TableNextColumn();
+    ImGui::Text("%d / %d", std::max(record.Deadzone[GD::Axis_ThumbLX], record.Deadzone[GD::Axis_ThumbLY]),
+        std::max(record.Deadzone[GD::Axis_ThumbRX], record.Deadzone[GD::Axis_ThumbRY]));
+    ImGui::TableNextColumn();
+    ImGui::Text("%.1f / %.1f", std::min(record.EffectiveBits[GD::Axis_ThumbLX], record.EffectiveBits[GD::Axis_ThumbLY]),
+        std::min(record.EffectiveBits[GD::Axis_ThumbRX], record.EffectiveBits[GD::Axis_ThumbRY]));
+    ImGui::TableNextColumn();
+    ImGui::Text("%u", record.Presses);
+    ImGui::TableNextColumn();
+    if (record.Chatter)
+        ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(160, 40, 40, 255));
+    ImGui::Text("%u", record.Chatter);
+}
+
+static void RenderStations()
+{
+    struct Live
+    {
+        GD::DeviceInfo Info;
+        BenchRecord Result;
+        uint32_t Backlog;
+    };
+    std::vector<Live> live;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        for (const auto& station : s_Stations)
+        {
+            if (station.Session)
+            {
+                BenchRecord result = station.Session->Result();
+                live.push_back({ station.Info, result, result.PeakBacklog });
+            }
+        }
+    }
+    if (live.empty())
+    {
+        ImGui::TextDisabled("Press Start to test every connected device");
+        return;
+    }
+
+    if (!ImGui::BeginTable("stations", 10, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+        return;
+    SetupColumns("Station");
+    for (const auto& station : live)
+    {
+        ImGui::TableNextColumn();
+        ImGui::Text("XUser %d  %04X / %04X", station.Info.Slot, station.Info.VendorId, station.Info.ProductId);
+        ImGui::SetItemTooltip("%u samples, at most %u waited for the analysis", station.Result.Samples, station.Backlog);
+        RenderColumns(station.Result);
+    }
+    ImGui::EndTable();
+}
+
+static void RenderResults()
+{
+    if (!s_Store.IsOpen())
+        return;
+
+    // One node per product and instance, the records in it oldest first
+    for (uint64_t key : s_Store.Keys())
+    {
+        uint16_t vendorId = (uint16_t)(key >> 24), productId = (uint16_t)(key >> 8);
+        int slot = (int)(key & 255);
+        auto records = s_Store.Find(vendorId, productId, slot);
+        char label[64];
+        snprintf(label, sizeof(label), "%04X / %04X  XUser %d  (%zu)###%llx", vendorId, productId, slot, records.size(), (unsigned long long)key);
+        if (!ImGui::TreeNode(label))
+            continue;
+        if (ImGui::BeginTable("records", 10, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+        {
+            SetupColumns("Time");
+            for (size_t index : records)
+            {
+                const BenchRecord& record = s_Store.Record(index);
+                time_t when = (time_t)record.Time;
+                char text[32] = "?";
+                if (const tm* local = localtime(&when))
+                    strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", local);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(text);
+                RenderColumns(record);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::TreePop();
+    }
+}
+
+void GD::Bench::RenderFrame()
+{
+    if (!s_Visible)
+    {
+        // Devices that went away during a run still get their result stored
+        StoreFinished(false);
+        return;
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(760, 520), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Bench", &s_Visible))
+    {
+        ImGui::End();
+        StoreFinished(false);
+        return;
+    }
+
+    bool running;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        running = s_Running;
+    }
+    uint64_t elapsed = running ? GD::Now() - s_StartedAt : 0;
+    if (running && s_Duration > 0 && elapsed >= (uint64_t)(s_Duration * 1e6))
+    {
+        StoreFinished(true);
+        running = false;
+    }
+    StoreFinished(false);
+
+    ImGui::SetNextItemWidth(240);
+    ImGui::InputText("Results", &s_Path);
+    ImGui::SameLine();
+    if (ImGui::Button("Open"))
+        OpenStore();
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    ImGui::SliderFloat("Duration", &s_Duration, 0.f, 300.f, s_Duration > 0 ? "%.0f s" : "until stopped");
+    ImGui::SameLine();
+    if (!running && ImGui::Button("Start"))
+        StartAll();
+    else if (running && ImGui::Button("Stop"))
+        StoreFinished(true);
+    if (running)
+    {
+        ImGui::SameLine();
+        ImGui::Text("%.1f s", elapsed / 1e6);
+    }
+
+    ImGui::SeparatorText("Stations");
+    RenderStations();
+    ImGui::SeparatorText("Results");
+    if (!s_Store.IsOpen() && !s_StorePath.empty())
+        ImGui::TextColored(ImVec4(1.f, 0.3f, 0.3f, 1.f), "%s", s_Store.Error().c_str());
+    RenderResults();
+
+    ImGui::End();
+}
+
+void GD::Bench::Show()
+{
+    OpenStore();
+    s_Visible = true;
+}
+
+void GD::Bench::Shutdown()
+{
+    // A run that is still going is stored, so a bench that is closed early keeps what it measured
+    StoreFinished(true);
+    s_Store.Close();
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (auto& station : s_Stations)
+        station = {};
+}
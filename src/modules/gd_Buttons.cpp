@@ -0,0 +1,294 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Button press durations, mash rate, chords and chatter
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "modules/gd_Buttons.h"
+#include "gd_buttons.h"
+#include "imgui.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
+
+constexpr size_t MaxButtonDevices = 16;
+constexpr int ShownEvents = 64;
+
+struct DeviceButtons
+{
+    GD::DeviceInfo Info;
+    bool Connected = false;
+    GD::ButtonEdges Edges;
+};
+
+// Shared with the sampling thread
+static std::mutex s_Lock;
+static DeviceButtons s_Devices[MaxButtonDevices];
+static float s_ChatterWindow = 3.f;                         // Milliseconds
+
+// Owned by the UI
+static bool s_Visible = false;
+static int s_Device = 0;
+static int s_Button = 12;                                   // A
+
+
+static DeviceButtons* FindDevice(uint16_t id)
+{
+    for (auto& device : s_Devices)
+    {
+        if (device.Connected && device.Info.Id == id)
+            return &device;
+    }
+    return nullptr;
+}
+
+void GD::Buttons::DeviceConnected(const DeviceInfo& info)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceButtons* device = FindDevice(info.Id);
+    for (size_t n = 0; n < MaxButtonDevices && !device; ++n)
+    {
+        if (!s_Devices[n].Connected)
+            device = &s_Devices[n];
+    }
+    if (!device)
+        return;
+
+    device->Edges.Clear();
+    device->Edges.SetChatterWindow((uint64_t)(s_ChatterWindow * 1000));
+    device->Info = info;
+    device->Connected = true;
+}
+
+void GD::Buttons::DeviceDisconnected(uint16_t id)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (DeviceButtons* device = FindDevice(id))
+        device->Connected = false;
+}
+
+void GD::Buttons::Submit(const Sample& sample)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (DeviceButtons* device = FindDevice(sample.Device))
+        device->Edges.Add(sample.Timestamp, sample.Buttons);
+}
+
+
+static std::string ChordName(uint16_t buttons)
+{
+    std::string name;
+    for (int bit = 0; bit < GD::ButtonEdges::Buttons; ++bit)
+    {
+        if (!((buttons >> bit) & 1))
+            continue;
+        if (!name.empty())
+            name += " + ";
+        const char* button = GD::ButtonName(bit);
+        name += button ? button : "?";
+    }
+    return name;
+}
+
+static void RenderButtonTable(const GD::ButtonEdges& edges, uint64_t now)
+{
+    if (!ImGui::BeginTable("buttons", 9, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+        return;
+
+    ImGui::TableSetupColumn("Button");
+    ImGui::TableSetupColumn("Presses");
+    ImGui::TableSetupColumn("Rate /s");
+    ImGui::TableSetupColumn("Peak /s");
+    ImGui::TableSetupColumn("Mean hold");
+    ImGui::TableSetupColumn("Shortest");
+    ImGui::TableSetupColumn("Longest");
+    ImGui::TableSetupColumn("Chatter");
+    ImGui::TableSetupColumn("Down");
+    ImGui::TableHeadersRow();
+    for (int bit = 0; bit < GD::ButtonEdges::Buttons; ++bit)
+    {
+        const char* name = GD::ButtonName(bit);
+        if (!name)
+            continue;
+        const GD::ButtonStats& stats = edges.Stats(bit);
+        ImGui::TableNextColumn();
+        if (ImGui::Selectable(name, bit == s_Button, ImGuiSelectableFlags_SpanAllColumns))
+            s_Button = bit;
+        ImGui::TableNextColumn();
+        ImGui::Text("%llu", (unsigned long long)stats.Presses);
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", edges.Rate(bit, now));
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", stats.PeakRate);
+        ImGui::TableNextColumn();
+        if (stats.Releases)
+        {
+            ImGui::Text("%.1f ms", stats.TotalHeld / 1000.0 / stats.Releases);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f ms", stats.MinHold / 1000.0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f ms", stats.MaxHold / 1000.0);
+        }
+        else
+        {
+            ImGui::TableNextColumn();
+            ImGui::TableNextColumn();
+        }
+        ImGui::TableNextColumn();
+        if (stats.Chatter)
+            ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(160, 40, 40, 255));
+        ImGui::Text("%llu", (unsigned long long)stats.Chatter);
+        ImGui::TableNextColumn();
+        if ((edges.Down() >> bit) & 1)
+            ImGui::TextUnformatted("down");
+    }
+    ImGui::EndTable();
+}
+
+void GD::Buttons::RenderFrame()
+{
+    if (!s_Visible)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(640, 600), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Buttons", &s_Visible))
+    {
+        ImGui::End();
+        return;
+    }
+
+    // Copy what is needed, the sampling thread keeps going
+    GD::DeviceInfo devices[MaxButtonDevices];
+    GD::ButtonEdges edges;
+    int count = 0;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        for (const auto& device : s_Devices)
+        {
+            if (!device.Connected)
+                continue;
+            if (count == s_Device)
+                edges = device.Edges;
+            devices[count++] = device.Info;
+        }
+    }
+
+    if (!count)
+    {
+        ImGui::TextUnformatted("No devices connected");
+        ImGui::End();
+        return;
+    }
+    s_Device = std::min(s_Device, count - 1);
+
+    char preview[32];
+    snprintf(preview, sizeof(preview), "XUser %d", devices[s_Device].Slot);
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::BeginCombo("Device", preview))
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            char label[32];
+            snprintf(label, sizeof(label), "XUser %d##%d", devices[n].Slot, n);
+            if (ImGui::Selectable(label, n == s_Device))
+                s_Device = n;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    float chatterWindow = s_ChatterWindow;
+    if (ImGui::SliderFloat("Chatter window", &chatterWindow, 0.1f, 20.f, "%.1f ms", ImGuiSliderFlags_Logarithmic))
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        s_ChatterWindow = chatterWindow;
+        for (auto& device : s_Devices)
+            device.Edges.SetChatterWindow((uint64_t)(chatterWindow * 1000));
+    }
+    ImGui::SetItemTooltip("A release and press again, or a press this short, is a bouncing contact.\n"
+        "Changes closer together than the polling interval are not seen.");
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        if (DeviceButtons* device = FindDevice(devices[s_Device].Id))
+            device->Edges.Clear();
+    }
+
+    uint64_t now = GD::Now();
+    RenderButtonTable(edges, now);
+
+    // Hold times span from bouncing contacts to buttons held for seconds, so the buckets double
+    const GD::ButtonStats& stats = edges.Stats(s_Button);
+    ImGui::SeparatorText(GD::ButtonName(s_Button));
+    float holds[GD::ButtonStats::HoldBuckets];
+    for (int n = 0; n < GD::ButtonStats::HoldBuckets; ++n)
+        holds[n] = (float)stats.Holds[n];
+    ImGui::Text("Hold times, bar n holds %.3f .. %.3f ms, doubling from there", GD::ButtonStats::BucketStart(1) / 1000.0, GD::ButtonStats::BucketStart(2) / 1000.0);
+    ImGui::PlotHistogram("##holds", holds, GD::ButtonStats::HoldBuckets, 0, nullptr, 0.f, FLT_MAX, ImVec2(-FLT_MIN, 80));
+    if (ImGui::IsItemHovered())
+    {
+        float x = (ImGui::GetIO().MousePos.x - ImGui::GetItemRectMin().x) / ImGui::GetItemRectSize().x;
+        int bucket = std::clamp((int)(x * GD::ButtonStats::HoldBuckets), 0, GD::ButtonStats::HoldBuckets - 1);
+        ImGui::SetTooltip("%.3f .. %.3f ms: %llu", GD::ButtonStats::BucketStart(bucket) / 1000.0, GD::ButtonStats::BucketStart(bucket + 1) / 1000.0,
+            (unsigned long long)stats.Holds[bucket]);
+    }
+
+    ImGui::SeparatorText("Chords");
+    auto chords = edges.Chords();
+    if (chords.empty())
+        ImGui::TextDisabled("Press buttons together to see them here");
+    else if (ImGui::BeginTable("chords", 4, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Buttons");
+        ImGui::TableSetupColumn("Count");
+        ImGui::TableSetupColumn("Mean spread");
+        ImGui::TableSetupColumn("Max spread");
+        ImGui::TableHeadersRow();
+        for (const auto& chord : chords)
+        {
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(ChordName(chord.Buttons).c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)chord.Count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f ms", chord.TotalSpread / 1000.0 / chord.Count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f ms", chord.MaxSpread / 1000.0);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::SeparatorText("Events");
+    auto events = edges.Events();
+    if (ImGui::BeginChild("events", ImVec2(0, 0), ImGuiChildFlags_FrameStyle))
+    {
+        int shown = 0;
+        for (auto it = events.rbegin(); it != events.rend() && shown < ShownEvents; ++it, ++shown)
+        {
+            const char* name = GD::ButtonName(it->Bit);
+            double ago = it->Timestamp <= now ? (now - it->Timestamp) / 1e6 : 0.0;
+            char held[32] = "";
+            if (!it->Press && it->Duration)
+                snprintf(held, sizeof(held), "held %.2f ms", it->Duration / 1000.0);
+            if (it->Chatter)
+                ImGui::TextColored(ImVec4(1.f, 0.3f, 0.3f, 1.f), "-%8.3f s  %-14s %-4s %s chatter", ago, name ? name : "?", it->Press ? "down" : "up", held);
+            else
+                ImGui::Text("-%8.3f s  %-14s %-4s %s", ago, name ? name : "?", it->Press ? "down" : "up", held);
+        }
+    }
+    ImGui::EndChild();
+
+    ImGui::End();
+}
+
+void GD::Buttons::Show()
+{
+    s_Visible = true;
+}
+
+void GD::Buttons::Shutdown()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (auto& device : s_Devices)
+        device = {};
+}
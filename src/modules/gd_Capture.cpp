@@ -0,0 +1,435 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Oscilloscope style triggered capture of device samples
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_win32.h"
+#include "gd_log.h"
+#include "modules/gd_Capture.h"
+#include "record/gd_RecordWriter.h"
+#include "imgui.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace GD::Capture;
+
+enum CaptureState
+{
+    State_Idle,
+    State_Armed,
+    State_Capturing,    // Triggered, waiting for the post trigger span
+};
+
+// The pre trigger history of a single device
+struct DeviceRing
+{
+    GD::DeviceInfo Info;
+    bool Connected = false;
+    bool HasLast = false;
+    GD::Sample Last;
+    std::unique_ptr<GD::Sample[]> Samples;
+    uint64_t Head = 0;
+};
+
+// At the polling rate of about 1 kHz this holds 8 seconds
+constexpr size_t RingCapacity = 8192;
+constexpr size_t MaxCaptureDevices = 16;
+constexpr uint32_t MaxSpan = 5000000;
+constexpr int PlotPoints = 512;
+
+struct CaptureWindow
+{
+    Trigger Settings;
+    GD::DeviceInfo Info;
+    uint64_t TriggerTimestamp = 0;
+    GD::Sample Initial;                 // State at the start of the window
+    std::vector<GD::Sample> Samples;
+};
+
+// Everything up to s_Pending is shared with the sampling thread
+static std::mutex s_Lock;
+static DeviceRing s_Devices[MaxCaptureDevices];
+static CaptureState s_State = State_Idle;
+static Trigger s_Trigger;
+static CaptureWindow s_Pending;
+static uint64_t s_CaptureEnd = 0;
+static uint32_t s_Generation = 0;
+
+// Owned by the UI
+static bool s_Visible = false;
+static Trigger s_Config;
+static CaptureWindow s_Frozen;
+static uint32_t s_FrozenGeneration = 0;
+static float s_Plot[GD::Axis_Count][PlotPoints];
+static uint16_t s_PlotButtons[PlotPoints];
+
+
+static bool Fires(const Trigger& trigger, const GD::Sample& previous, const GD::Sample& sample)
+{
+    switch (trigger.Type)
+    {
+    case Trigger_ButtonPress:
+        return (~previous.Buttons & sample.Buttons & trigger.Buttons) != 0;
+    case Trigger_ButtonRelease:
+        return (previous.Buttons & ~sample.Buttons & trigger.Buttons) != 0;
+    case Trigger_AxisRising:
+        return GD::GetAxis(previous, trigger.Axis) < trigger.Threshold && GD::GetAxis(sample, trigger.Axis) >= trigger.Threshold;
+    case Trigger_AxisFalling:
+        return GD::GetAxis(previous, trigger.Axis) > trigger.Threshold && GD::GetAxis(sample, trigger.Axis) <= trigger.Threshold;
+    case Trigger_PacketGap:
+        return sample.PacketNumber - previous.PacketNumber > trigger.PacketGap;
+    default:
+        return false;
+    }
+}
+
+static DeviceRing* FindDevice(uint16_t id)
+{
+    for (auto& device : s_Devices)
+    {
+        if (device.Connected && device.Info.Id == id)
+            return &device;
+    }
+    return nullptr;
+}
+
+// Called with s_Lock held
+static void Finish()
+{
+    s_State = State_Idle;
+    s_Generation++;
+}
+
+void GD::Capture::Arm(const Trigger& trigger)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_Trigger = trigger;
+    s_Trigger.PreTrigger = std::min(s_Trigger.PreTrigger, MaxSpan);
+    s_Trigger.PostTrigger = std::min(s_Trigger.PostTrigger, MaxSpan);
+    s_Pending.Samples.clear();
+    s_Pending.Samples.reserve(RingCapacity * 2);
+    s_State = State_Armed;
+}
+
+void GD::Capture::Disarm()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (s_State == State_Capturing)
+        Finish();
+    s_State = State_Idle;
+}
+
+void GD::Capture::DeviceConnected(const DeviceInfo& info)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceRing* ring = FindDevice(info.Id);
+    for (size_t n = 0; n < MaxCaptureDevices && !ring; ++n)
+    {
+        if (!s_Devices[n].Connected)
+            ring = &s_Devices[n];
+    }
+    if (!ring)
+        return;
+
+    if (!ring->Samples)
+        ring->Samples.reset(new GD::Sample[RingCapacity]);
+    ring->Info = info;
+    ring->Connected = true;
+    ring->HasLast = false;
+    ring->Head = 0;
+}
+
+void GD::Capture::DeviceDisconnected(uint16_t id)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (DeviceRing* ring = FindDevice(id))
+    {
+        ring->Connected = false;
+        if (s_State == State_Capturing && s_Pending.Info.Id == id)
+            Finish();
+    }
+}
+
+void GD::Capture::Submit(const Sample& sample)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceRing* ring = FindDevice(sample.Device);
+    if (!ring)
+        return;
+
+    if (s_State == State_Capturing && s_Pending.Info.Id == sample.Device)
+    {
+        if (sample.Timestamp > s_CaptureEnd)
+            Finish();
+        else
+            s_Pending.Samples.push_back(sample);
+    }
+    else if (s_State == State_Armed && ring->HasLast && (s_Trigger.Device < 0 || s_Trigger.Device == sample.Device) &&
+        Fires(s_Trigger, ring->Last, sample))
+    {
+        uint64_t start = sample.Timestamp > s_Trigger.PreTrigger ? sample.Timestamp - s_Trigger.PreTrigger : 0;
+        size_t count = (size_t)std::min<uint64_t>(ring->Head, RingCapacity);
+        size_t first = 0;
+        while (first < count && ring->Samples[(ring->Head - count + first) & (RingCapacity - 1)].Timestamp < start)
+            first++;
+
+        s_Pending.Settings = s_Trigger;
+        s_Pending.Info = ring->Info;
+        s_Pending.TriggerTimestamp = sample.Timestamp;
+        // The state that was active when the window starts, even if it was reported long before
+        s_Pending.Initial = first > 0 ? ring->Samples[(ring->Head - count + first - 1) & (RingCapacity - 1)] : ring->Samples[(ring->Head - count) & (RingCapacity - 1)];
+        s_Pending.Initial.Timestamp = start;
+        s_Pending.Samples.clear();
+        for (size_t n = first; n < count; ++n)
+            s_Pending.Samples.push_back(ring->Samples[(ring->Head - count + n) & (RingCapacity - 1)]);
+        s_Pending.Samples.push_back(sample);
+        s_CaptureEnd = sample.Timestamp + s_Trigger.PostTrigger;
+        s_State = State_Capturing;
+    }
+
+    ring->Samples[ring->Head++ & (RingCapacity - 1)] = sample;
+    ring->Last = sample;
+    ring->HasLast = true;
+}
+
+
+static const char* TriggerName(int type)
+{
+    static const char* names[Trigger_Count] = { "Button press", "Button release", "Axis rising", "Axis falling", "Packet gap" };
+    return (type >= 0 && type < Trigger_Count) ? names[type] : "?";
+}
+
+// Resamples the capture once, XInput only reports changes so every value holds until the next sample
+static void BuildPlot()
+{
+    uint64_t start = s_Frozen.Initial.Timestamp;
+    uint64_t span = s_Frozen.TriggerTimestamp - start + s_Frozen.Settings.PostTrigger;
+    GD::Sample state = s_Frozen.Initial;
+    size_t next = 0;
+    for (int point = 0; point < PlotPoints; ++point)
+    {
+        uint64_t timestamp = start + span * point / (PlotPoints - 1);
+        while (next < s_Frozen.Samples.size() && s_Frozen.Samples[next].Timestamp <= timestamp)
+            state = s_Frozen.Samples[next++];
+        for (int axis = 0; axis < GD::Axis_Count; ++axis)
+            s_Plot[axis][point] = (float)GD::GetAxis(state, axis);
+        s_PlotButtons[point] = state.Buttons;
+    }
+}
+
+static void SaveCapture()
+{
+    SYSTEMTIME st{};
+    GetLocalTime(&st);
+    char path[MAX_PATH];
+    StringCchPrintfA(path, _countof(path), "GamepadDebug_capture_%04d%02d%02d_%02d%02d%02d.gdrec",
+        st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond);
+
+    GD::Record::Writer writer;
+    if (!writer.Open(path, GD::Record::DefaultKeyframeInterval, false))
+    {
+        GD_Log("Failed to create capture %s\n", path);
+        return;
+    }
+
+    writer.AddDevice(s_Frozen.Info, s_Frozen.Initial);
+    for (const auto& sample : s_Frozen.Samples)
+        writer.Append(sample);
+
+    char line[128];
+    int length = snprintf(line, sizeof(line), "Capture triggered: %s\n", TriggerName(s_Frozen.Settings.Type));
+    writer.AppendLog(s_Frozen.TriggerTimestamp, line, (size_t)std::max(length, 0));
+    writer.Close();
+    GD_Log("Saved capture to %s\n", path);
+}
+
+static void RenderButtons(float height)
+{
+    uint16_t used = 0;
+    for (int point = 0; point < PlotPoints; ++point)
+        used |= s_PlotButtons[point];
+    if (!used)
+        return;
+
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    float width = ImGui::GetContentRegionAvail().x;
+    float label = ImGui::CalcTextSize("RIGHT_SHOULDER ").x;
+    for (int bit = 0; bit < 16; ++bit)
+    {
+        if (!(used & (1 << bit)))
+            continue;
+
+        ImVec2 pos = ImGui::GetCursorScreenPos();
+        ImGui::TextUnformatted(GD::ButtonName(bit));
+        float x0 = pos.x + label, x1 = pos.x + width;
+        draw->AddRectFilled(ImVec2(x0, pos.y), ImVec2(x1, pos.y + height), ImGui::GetColorU32(ImGuiCol_FrameBg));
+        for (int point = 0; point < PlotPoints; ++point)
+        {
+            if (s_PlotButtons[point] & (1 << bit))
+            {
+                float a = x0 + (x1 - x0) * point / PlotPoints;
+                float b = x0 + (x1 - x0) * (point + 1) / PlotPoints;
+                draw->AddRectFilled(ImVec2(a, pos.y), ImVec2(b, pos.y + height), ImGui::GetColorU32(ImGuiCol_PlotHistogram));
+            }
+        }
+    }
+}
+
+static void RenderFrozen()
+{
+    const auto& trigger = s_Frozen.Settings;
+    ImGui::Text("%s on XUser %d, %zu samples", TriggerName(trigger.Type), s_Frozen.Info.Slot, s_Frozen.Samples.size());
+    ImGui::SameLine();
+    if (ImGui::Button("Save"))
+        SaveCapture();
+
+    float pre = (float)(s_Frozen.TriggerTimestamp - s_Frozen.Initial.Timestamp);
+    float marker = pre / (pre + trigger.PostTrigger);
+    float label = ImGui::CalcTextSize("RIGHT_SHOULDER ").x;
+    for (int axis = 0; axis < GD::Axis_Count; ++axis)
+    {
+        bool isTrigger = axis == GD::Axis_LeftTrigger || axis == GD::Axis_RightTrigger;
+        float lo = isTrigger ? 0.f : -32768.f, hi = isTrigger ? 255.f : 32767.f;
+
+        ImGui::TextUnformatted(GD::AxisName(axis));
+        ImGui::SameLine(label);
+        ImVec2 pos = ImGui::GetCursorScreenPos();
+        ImGui::PushID(axis);
+        ImGui::PlotLines("##axis", s_Plot[axis], PlotPoints, 0, nullptr, lo, hi, ImVec2(-FLT_MIN, 40));
+        ImGui::PopID();
+
+        float x = pos.x + (ImGui::GetItemRectMax().x - pos.x) * marker;
+        ImGui::GetWindowDrawList()->AddLine(ImVec2(x, pos.y), ImVec2(x, ImGui::GetItemRectMax().y), IM_COL32(255, 64, 64, 255));
+    }
+    RenderButtons(ImGui::GetTextLineHeight());
+}
+
+static void RenderConfig(CaptureState state)
+{
+    auto& config = s_Config;
+    ImGui::SetNextItemWidth(160);
+    ImGui::Combo("Trigger", (int*)&config.Type, [](void*, int idx) { return TriggerName(idx); }, nullptr, Trigger_Count);
+    ImGui::SameLine();
+    static const char* devices[] = { "Any", "XUser 0", "XUser 1", "XUser 2", "XUser 3" };
+    int device = config.Device + 1;
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::Combo("Device", &device, devices, IM_ARRAYSIZE(devices)))
+        config.Device = device - 1;
+
+    switch (config.Type)
+    {
+    case Trigger_ButtonPress:
+    case Trigger_ButtonRelease:
+        for (int bit = 0; bit < 16; ++bit)
+        {
+            if (const char* name = GD::ButtonName(bit))
+            {
+                unsigned int flags = config.Buttons;
+                if (bit % 8)
+                    ImGui::SameLine();
+                ImGui::CheckboxFlags(name, &flags, 1u << bit);
+                config.Buttons = (uint16_t)flags;
+            }
+        }
+        break;
+    case Trigger_AxisRising:
+    case Trigger_AxisFalling:
+        ImGui::SetNextItemWidth(160);
+        ImGui::Combo("Axis", &config.Axis, [](void*, int idx) { return GD::AxisName(idx); }, nullptr, GD::Axis_Count);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120);
+        ImGui::InputInt("Threshold", &config.Threshold);
+        break;
+    case Trigger_PacketGap:
+        ImGui::SetNextItemWidth(120);
+        ImGui::InputScalar("Larger than", ImGuiDataType_U32, &config.PacketGap);
+        break;
+    default:
+        break;
+    }
+
+    int pre = (int)(config.PreTrigger / 1000), post = (int)(config.PostTrigger / 1000);
+    ImGui::SetNextItemWidth(120);
+    if (ImGui::InputInt("Pre (ms)", &pre, 50))
+        config.PreTrigger = (uint32_t)std::clamp(pre, 0, (int)(MaxSpan / 1000)) * 1000;
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    if (ImGui::InputInt("Post (ms)", &post, 50))
+        config.PostTrigger = (uint32_t)std::clamp(post, 0, (int)(MaxSpan / 1000)) * 1000;
+
+    if (state == State_Idle)
+    {
+        if (ImGui::Button("Arm"))
+            GD::Capture::Arm(config);
+    }
+    else
+    {
+        if (ImGui::Button("Disarm"))
+            GD::Capture::Disarm();
+        ImGui::SameLine();
+        ImGui::TextUnformatted(state == State_Armed ? "Waiting for trigger..." : "Triggered, capturing...");
+    }
+}
+
+void GD::Capture::RenderFrame()
+{
+    CaptureState state;
+    bool triggered = false;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        // Without new samples the sampling thread cannot notice that the window is complete
+        if (s_State == State_Capturing && GD::Now() > s_CaptureEnd)
+            Finish();
+        state = s_State;
+        if (s_Generation != s_FrozenGeneration)
+        {
+            s_Frozen = s_Pending;
+            s_FrozenGeneration = s_Generation;
+            triggered = true;
+        }
+    }
+
+    if (triggered)
+    {
+        BuildPlot();
+        GD_Log("Capture triggered: %s on XUser %d\n", TriggerName(s_Frozen.Settings.Type), s_Frozen.Info.Slot);
+    }
+
+    if (!s_Visible)
+        return;
+
+    // Next to the XInput panel, which takes the left half
+    const ImGuiViewport* viewport = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + viewport->WorkSize.x / 2, viewport->WorkPos.y), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(viewport->WorkSize.x / 2, viewport->WorkSize.y * .6f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Triggered capture", &s_Visible))
+    {
+        ImGui::End();
+        return;
+    }
+
+    RenderConfig(state);
+    if (s_FrozenGeneration)
+    {
+        ImGui::Separator();
+        RenderFrozen();
+    }
+
+    ImGui::End();
+}
+
+void GD::Capture::Show()
+{
+    s_Visible = true;
+}
+
+void GD::Capture::Shutdown()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_State = State_Idle;
+    for (auto& device : s_Devices)
+        device = {};
+    s_Pending = {};
+}
@@ -0,0 +1,294 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Crosstalk between the analog axes
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "modules/gd_Crosstalk.h"
+#include "imgui.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+constexpr size_t MaxCrosstalkDevices = 16;
+constexpr int Axes = GD::Axis_Count;
+constexpr double Driven = 0.4;                              // Fraction of the full range where an axis counts as moved on purpose
+constexpr double MinIsolated = 200;                         // Samples before a bleed is reported
+
+// Count, means and co-moments of all axes, updated one sample at a time (the multivariate form of Welford's algorithm)
+struct CoMoments
+{
+    double Count = 0.0;
+    double Mean[Axes]{};
+    double C[Axes][Axes]{};
+
+    void Add(const double (&x)[Axes])
+    {
+        Count += 1.0;
+        double before[Axes], after[Axes];
+        for (int i = 0; i < Axes; ++i)
+        {
+            before[i] = x[i] - Mean[i];
+            Mean[i] += before[i] / Count;
+            after[i] = x[i] - Mean[i];
+        }
+        for (int i = 0; i < Axes; ++i)
+        {
+            for (int j = 0; j < Axes; ++j)
+                C[i][j] += before[i] * after[j];
+        }
+    }
+
+    double Correlation(int i, int j) const
+    {
+        double scale = C[i][i] * C[j][j];
+        return scale > 0.0 ? C[i][j] / std::sqrt(scale) : 0.0;
+    }
+
+    // Change of j per unit of i
+    double Slope(int i, int j) const
+    {
+        return C[i][i] > 0.0 ? C[i][j] / C[i][i] : 0.0;
+    }
+};
+
+struct DeviceCrosstalk
+{
+    GD::DeviceInfo Info;
+    bool Connected = false;
+    CoMoments All;
+    // Only the samples where Isolated[n] was the one axis that was driven, the others should not follow it
+    CoMoments Isolated[Axes];
+};
+
+// Shared with the sampling thread
+static std::mutex s_Lock;
+static DeviceCrosstalk s_Devices[MaxCrosstalkDevices];
+
+// Owned by the UI
+static bool s_Visible = false;
+static int s_Device = 0;
+static float s_Threshold = 2.f;                             // Percent of full scale per full scale on the driven axis
+
+
+static DeviceCrosstalk* FindDevice(uint16_t id)
+{
+    for (auto& device : s_Devices)
+    {
+        if (device.Connected && device.Info.Id == id)
+            return &device;
+    }
+    return nullptr;
+}
+
+// Below this an axis is left alone, the same limits that XInput games use as deadzones
+static double Quiet(int axis)
+{
+    switch (axis)
+    {
+    case GD::Axis_LeftTrigger:
+    case GD::Axis_RightTrigger:
+        return GD::TriggerThreshold / 255.0;
+    case GD::Axis_ThumbLX:
+    case GD::Axis_ThumbLY:
+        return GD::LeftThumbDeadzone / 32768.0;
+    default:
+        return GD::RightThumbDeadzone / 32768.0;
+    }
+}
+
+void GD::Crosstalk::DeviceConnected(const DeviceInfo& info)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceCrosstalk* device = FindDevice(info.Id);
+    for (size_t n = 0; n < MaxCrosstalkDevices && !device; ++n)
+    {
+        if (!s_Devices[n].Connected)
+            device = &s_Devices[n];
+    }
+    if (!device)
+        return;
+
+    *device = {};
+    device->Info = info;
+    device->Connected = true;
+}
+
+void GD::Crosstalk::DeviceDisconnected(uint16_t id)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (DeviceCrosstalk* device = FindDevice(id))
+        device->Connected = false;
+}
+
+void GD::Crosstalk::Submit(const Sample& sample)
+{
+    // Every axis as a fraction of its full range, so the slopes compare sticks and triggers directly
+    double x[Axes];
+    int driven = -1, moved = 0;
+    for (int axis = 0; axis < Axes; ++axis)
+    {
+        x[axis] = GetAxis(sample, axis) / (axis <= Axis_RightTrigger ? 255.0 : 32768.0);
+        double magnitude = std::fabs(x[axis]);
+        moved += magnitude >= Quiet(axis);
+        if (magnitude >= Driven)
+            driven = axis;
+    }
+
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceCrosstalk* device = FindDevice(sample.Device);
+    if (!device)
+        return;
+    device->All.Add(x);
+    if (driven >= 0 && moved == 1)
+        device->Isolated[driven].Add(x);
+}
+
+
+static ImU32 HeatColor(double value)
+{
+    int level = (int)(std::min(1.0, std::fabs(value)) * 200);
+    return IM_COL32(40 + level, 40, 40 + (200 - level) / 4, 255);
+}
+
+void GD::Crosstalk::RenderFrame()
+{
+    if (!s_Visible)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(640, 440), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Crosstalk", &s_Visible))
+    {
+        ImGui::End();
+        return;
+    }
+
+    // Copy what is needed, the sampling thread keeps going
+    GD::DeviceInfo devices[MaxCrosstalkDevices];
+    DeviceCrosstalk selected;
+    int count = 0;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        for (const auto& device : s_Devices)
+        {
+            if (!device.Connected)
+                continue;
+            if (count == s_Device)
+                selected = device;
+            devices[count++] = device.Info;
+        }
+    }
+
+    if (!count)
+    {
+        ImGui::TextUnformatted("No devices connected");
+        ImGui::End();
+        return;
+    }
+    s_Device = std::min(s_Device, count - 1);
+
+    char preview[32];
+    snprintf(preview, sizeof(preview), "XUser %d", devices[s_Device].Slot);
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::BeginCombo("Device", preview))
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            char label[32];
+            snprintf(label, sizeof(label), "XUser %d##%d", devices[n].Slot, n);
+            if (ImGui::Selectable(label, n == s_Device))
+                s_Device = n;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    ImGui::SliderFloat("Threshold", &s_Threshold, 0.1f, 20.f, "%.1f%%", ImGuiSliderFlags_Logarithmic);
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        if (DeviceCrosstalk* device = FindDevice(devices[s_Device].Id))
+        {
+            device->All = {};
+            for (auto& isolated : device->Isolated)
+                isolated = {};
+        }
+    }
+
+    ImGui::SeparatorText("Correlation over all samples");
+    ImGui::Text("%.0f samples, moving a stick diagonally correlates its axes as well", selected.All.Count);
+    if (ImGui::BeginTable("correlation", Axes + 1, ImGuiTableFlags_BordersInner))
+    {
+        ImGui::TableSetupColumn("");
+        for (int axis = 0; axis < Axes; ++axis)
+            ImGui::TableSetupColumn(GD::AxisName(axis));
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < Axes; ++i)
+        {
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(GD::AxisName(i));
+            for (int j = 0; j < Axes; ++j)
+            {
+                ImGui::TableNextColumn();
+                double r = selected.All.Correlation(i, j);
+                if (i != j)
+                    ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, HeatColor(r));
+                ImGui::Text("%+.2f", r);
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    // Row: the axis that was driven alone, column: how much another axis followed it
+    ImGui::SeparatorText("Bleed while one axis is driven alone");
+    ImGui::TextDisabled("Percent of full scale per full scale of the driven axis");
+    int flagged = 0;
+    if (ImGui::BeginTable("bleed", Axes + 2, ImGuiTableFlags_BordersInner))
+    {
+        ImGui::TableSetupColumn("Driven");
+        ImGui::TableSetupColumn("Samples");
+        for (int axis = 0; axis < Axes; ++axis)
+            ImGui::TableSetupColumn(GD::AxisName(axis));
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < Axes; ++i)
+        {
+            const CoMoments& isolated = selected.Isolated[i];
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(GD::AxisName(i));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", isolated.Count);
+            for (int j = 0; j < Axes; ++j)
+            {
+                ImGui::TableNextColumn();
+                if (i == j || isolated.Count < MinIsolated)
+                    continue;
+                double bleed = 100.0 * isolated.Slope(i, j);
+                if (std::fabs(bleed) >= s_Threshold)
+                {
+                    ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(160, 40, 40, 255));
+                    flagged++;
+                }
+                ImGui::Text("%+.2f", bleed);
+            }
+        }
+        ImGui::EndTable();
+    }
+    if (flagged)
+        ImGui::TextColored(ImVec4(1.f, 0.3f, 0.3f, 1.f), "%d axis pairs above %.1f%%", flagged, s_Threshold);
+    else
+        ImGui::TextUnformatted("Move one axis at a time over its full range to measure the bleed");
+
+    ImGui::End();
+}
+
+void GD::Crosstalk::Show()
+{
+    s_Visible = true;
+}
+
+void GD::Crosstalk::Shutdown()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (auto& device : s_Devices)
+        device = {};
+}
@@ -0,0 +1,352 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Keep the last seconds of samples and log output in memory, to dump on request or crash
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_win32.h"
+#include "gd_log.h"
+#include "modules/gd_FlightRecorder.h"
+#include "record/gd_RecordWriter.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+struct FlightLogEntry
+{
+    uint64_t Timestamp;
+    uint16_t Length;
+    char Text[118];
+};
+
+struct FlightDevice
+{
+    GD::DeviceInfo Info;
+    bool Connected;
+};
+
+constexpr size_t MaxFlightDevices = 64;
+constexpr size_t FlightLogCapacity = 1024;
+constexpr size_t FlightChunkRecords = 4096;
+// Timestamp and length of every log record, and the line that says why the dump was made
+constexpr size_t FlightLogBlockSize = sizeof(GD::Record::LogBlockHeader) + (FlightLogCapacity + 1) * (sizeof(uint64_t) + sizeof(uint16_t) + sizeof(FlightLogEntry::Text));
+
+static std::timed_mutex s_Lock;
+static uint64_t s_Window = 0;
+
+// Rings, the capacity is a power of two so the position can just keep counting
+static std::unique_ptr<GD::Sample[]> s_Samples;
+static size_t s_SampleMask = 0;
+static uint64_t s_SampleHead = 0;
+static std::unique_ptr<FlightLogEntry[]> s_Log;
+static uint64_t s_LogHead = 0;
+static FlightDevice s_Devices[MaxFlightDevices];
+static size_t s_DeviceCount = 0;
+
+// Dumps copy the rings here first, so the lock is not held while writing
+static std::unique_ptr<GD::Sample[]> s_SampleSnapshot;
+static std::unique_ptr<FlightLogEntry[]> s_LogSnapshot;
+static FlightDevice s_DeviceSnapshot[MaxFlightDevices];
+
+// A dump is written from these, it may run in an exception filter where the heap cannot be trusted
+static std::atomic_flag s_Dumping = ATOMIC_FLAG_INIT;
+static GD::Record::ChunkEncoder s_Encoder;
+static std::vector<GD::Record::KeyframeEntry> s_Keyframe;
+static std::unique_ptr<GD::Record::IndexEntry[]> s_Index;
+static size_t s_IndexCapacity = 0;
+static std::unique_ptr<uint8_t[]> s_LogBlock;
+
+#ifdef _WIN32
+static LPTOP_LEVEL_EXCEPTION_FILTER s_PreviousFilter = nullptr;
+#endif
+
+static bool DumpInternal(const char* reason, bool crashing);
+
+
+#ifdef _WIN32
+static LONG WINAPI FlightRecorder_ExceptionFilter(EXCEPTION_POINTERS* exception)
+{
+    DumpInternal("unhandled exception", true);
+    return s_PreviousFilter ? s_PreviousFilter(exception) : EXCEPTION_CONTINUE_SEARCH;
+}
+#endif
+
+void GD::FlightRecorder::Init(uint32_t seconds, uint32_t samplesPerSecond)
+{
+    size_t capacity = 1;
+    while (capacity < (size_t)seconds * samplesPerSecond)
+        capacity <<= 1;
+
+    std::unique_lock<std::timed_mutex> lock(s_Lock);
+    s_Window = seconds * 1000000ull;
+    s_Samples.reset(new GD::Sample[capacity]);
+    s_SampleSnapshot.reset(new GD::Sample[capacity]);
+    s_SampleMask = capacity - 1;
+    s_SampleHead = 0;
+    s_Log.reset(new FlightLogEntry[FlightLogCapacity]);
+    s_LogSnapshot.reset(new FlightLogEntry[FlightLogCapacity]);
+    s_LogHead = 0;
+    s_DeviceCount = 0;
+
+    // A chunk ends after a keyframe interval or FlightChunkRecords records, whichever comes first
+    s_Encoder.Reserve(MaxFlightDevices, FlightChunkRecords);
+    s_Keyframe.reserve(MaxFlightDevices);
+    s_IndexCapacity = s_Window / GD::Record::DefaultKeyframeInterval + capacity / FlightChunkRecords + 3;
+    s_Index.reset(new GD::Record::IndexEntry[s_IndexCapacity]);
+    s_LogBlock.reset(new uint8_t[FlightLogBlockSize]);
+
+#ifdef _WIN32
+    s_PreviousFilter = SetUnhandledExceptionFilter(FlightRecorder_ExceptionFilter);
+#endif
+}
+
+void GD::FlightRecorder::Shutdown()
+{
+#ifdef _WIN32
+    SetUnhandledExceptionFilter(s_PreviousFilter);
+#endif
+
+    std::unique_lock<std::timed_mutex> lock(s_Lock);
+    s_Samples.reset();
+    s_SampleSnapshot.reset();
+    s_Log.reset();
+    s_LogSnapshot.reset();
+    s_Index.reset();
+    s_LogBlock.reset();
+    s_SampleMask = 0;
+    s_DeviceCount = 0;
+}
+
+void GD::FlightRecorder::DeviceConnected(const DeviceInfo& info)
+{
+    std::unique_lock<std::timed_mutex> lock(s_Lock);
+    for (size_t n = 0; n < s_DeviceCount; ++n)
+    {
+        if (s_Devices[n].Info.Id == info.Id)
+        {
+            s_Devices[n] = { info, true };
+            return;
+        }
+    }
+    if (s_DeviceCount < MaxFlightDevices)
+        s_Devices[s_DeviceCount++] = { info, true };
+}
+
+void GD::FlightRecorder::DeviceDisconnected(uint16_t id)
+{
+    // Keep the entry, the ring can still contain samples of this device
+    std::unique_lock<std::timed_mutex> lock(s_Lock);
+    for (size_t n = 0; n < s_DeviceCount; ++n)
+    {
+        if (s_Devices[n].Info.Id == id)
+            s_Devices[n].Connected = false;
+    }
+}
+
+void GD::FlightRecorder::Submit(const Sample& sample)
+{
+    std::unique_lock<std::timed_mutex> lock(s_Lock);
+    if (s_Samples)
+        s_Samples[s_SampleHead++ & s_SampleMask] = sample;
+}
+
+void GD::FlightRecorder::Log(uint64_t timestamp, const char* text, size_t length)
+{
+    std::unique_lock<std::timed_mutex> lock(s_Lock);
+    if (!s_Log)
+        return;
+
+    auto& entry = s_Log[s_LogHead++ % FlightLogCapacity];
+    entry.Timestamp = timestamp;
+    entry.Length = (uint16_t)std::min(length, sizeof(entry.Text));
+    memcpy(entry.Text, text, entry.Length);
+}
+
+static bool WriteAll(HANDLE file, const void* data, size_t size, uint64_t& offset)
+{
+    DWORD written = 0;
+    bool ok = WriteFile(file, data, (DWORD)size, &written, nullptr) && written == size;
+    offset += written;
+    return ok;
+}
+
+static bool WriteChunk(HANDLE file, uint64_t& offset, size_t& chunks)
+{
+    if (s_Encoder.Empty() || chunks == s_IndexCapacity)
+        return true;
+
+    GD::Record::ChunkHeader header = s_Encoder.Seal();
+    const auto& payload = s_Encoder.Payload();
+    s_Index[chunks++] = { header.FirstTimestamp, offset };
+    return WriteAll(file, &header, sizeof(header), offset) && WriteAll(file, &s_Encoder.Summary(), sizeof(GD::Record::ChunkSummary), offset) &&
+        WriteAll(file, payload.data(), payload.size(), offset);
+}
+
+static void PutLogRecord(size_t& size, uint64_t timestamp, const char* text, size_t length)
+{
+    uint16_t length16 = (uint16_t)length;
+    memcpy(&s_LogBlock[size], &timestamp, sizeof(timestamp));
+    memcpy(&s_LogBlock[size + sizeof(timestamp)], &length16, sizeof(length16));
+    memcpy(&s_LogBlock[size + sizeof(timestamp) + sizeof(length16)], text, length);
+    size += sizeof(timestamp) + sizeof(length16) + length;
+}
+
+// Only uses what Init allocated, the file is written with the plain Win32 calls
+static bool WriteDump(const char* reason, bool crashing)
+{
+    size_t sampleCount, logCount, deviceCount;
+    uint64_t now = GD::Now();
+
+    {
+        // When crashing, the thread that holds the lock might be the one that crashed
+        std::unique_lock<std::timed_mutex> lock(s_Lock, std::defer_lock);
+        if (!crashing)
+            lock.lock();
+        else if (!lock.try_lock_for(std::chrono::milliseconds(100)))
+            return false;
+
+        if (!s_Samples)
+            return false;
+
+        sampleCount = (size_t)std::min<uint64_t>(s_SampleHead, s_SampleMask + 1);
+        for (size_t n = 0; n < sampleCount; ++n)
+            s_SampleSnapshot[n] = s_Samples[(s_SampleHead - sampleCount + n) & s_SampleMask];
+
+        logCount = (size_t)std::min<uint64_t>(s_LogHead, FlightLogCapacity);
+        for (size_t n = 0; n < logCount; ++n)
+            s_LogSnapshot[n] = s_Log[(s_LogHead - logCount + n) % FlightLogCapacity];
+
+        deviceCount = s_DeviceCount;
+        std::copy(s_Devices, s_Devices + deviceCount, s_DeviceSnapshot);
+    }
+
+    uint64_t start = now > s_Window ? now - s_Window : 0;
+    size_t first = 0;
+    while (first < sampleCount && s_SampleSnapshot[first].Timestamp < start)
+        first++;
+
+    // Milliseconds keep dumps apart, the suffix covers two dumps within the same one
+    SYSTEMTIME st{};
+    GetLocalTime(&st);
+    char path[MAX_PATH];
+    HANDLE file = INVALID_HANDLE_VALUE;
+    for (int attempt = 0; attempt < 100 && file == INVALID_HANDLE_VALUE; ++attempt)
+    {
+        StringCchPrintfA(path, _countof(path), attempt ? "GamepadDebug_flight_%04d%02d%02d_%02d%02d%02d_%03d_%d.gdrec" : "GamepadDebug_flight_%04d%02d%02d_%02d%02d%02d_%03d.gdrec",
+            st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds, attempt);
+        file = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE && GetLastError() != ERROR_FILE_EXISTS)
+            return false;
+    }
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    // The devices start with their first state in the window
+    uint64_t firstTimestamp = first < sampleCount ? s_SampleSnapshot[first].Timestamp : now;
+    s_Keyframe.clear();
+    for (size_t d = 0; d < deviceCount; ++d)
+    {
+        const auto& device = s_DeviceSnapshot[d];
+        const GD::Sample* initial = nullptr;
+        for (size_t n = first; n < sampleCount && !initial; ++n)
+        {
+            if (s_SampleSnapshot[n].Device == device.Info.Id)
+                initial = &s_SampleSnapshot[n];
+        }
+        if (!initial && !device.Connected)
+            continue;
+
+        GD::Record::KeyframeEntry entry;
+        entry.Info = device.Info;
+        entry.State = initial ? *initial : GD::Sample{};
+        entry.State.Device = device.Info.Id;
+        entry.State.Timestamp = firstTimestamp;
+        s_Keyframe.push_back(entry);
+    }
+
+    GD::Record::FileHeader header;
+    header.StartTimestamp = firstTimestamp;
+    header.StartUnixTime = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count() - (now - firstTimestamp);
+    header.KeyframeInterval = GD::Record::DefaultKeyframeInterval;
+    uint64_t offset = 0;
+    size_t chunks = 0;
+    bool ok = WriteAll(file, &header, sizeof(header), offset);
+
+    s_Encoder.Begin(s_Keyframe, firstTimestamp);
+    for (size_t n = first; n < sampleCount && ok; ++n)
+    {
+        const GD::Sample& sample = s_SampleSnapshot[n];
+        auto device = std::find_if(s_Keyframe.begin(), s_Keyframe.end(), [&](const GD::Record::KeyframeEntry& entry) { return entry.Info.Id == sample.Device; });
+        if (device == s_Keyframe.end())
+            continue;
+
+        const auto& chunk = s_Encoder.Header();
+        if (sample.Timestamp - chunk.FirstTimestamp >= header.KeyframeInterval || chunk.RecordCount >= FlightChunkRecords)
+        {
+            ok = WriteChunk(file, offset, chunks);
+            s_Encoder.Begin(s_Keyframe, sample.Timestamp);
+        }
+        s_Encoder.Add(sample);
+        device->State = sample;
+    }
+    ok = ok && WriteChunk(file, offset, chunks);
+
+    // The log block is laid out like EncodeLogBlock does, without its strings
+    size_t size = sizeof(GD::Record::LogBlockHeader);
+    GD::Record::LogBlockHeader logHeader;
+    for (size_t n = 0; n < logCount; ++n)
+    {
+        const auto& entry = s_LogSnapshot[n];
+        if (entry.Timestamp >= start)
+        {
+            PutLogRecord(size, entry.Timestamp, entry.Text, entry.Length);
+            logHeader.Count++;
+        }
+    }
+    char line[sizeof(FlightLogEntry::Text)];
+    int length = snprintf(line, sizeof(line), "Flight recorder dump: %s\n", reason);
+    PutLogRecord(size, now, line, std::min((size_t)std::max(length, 0), sizeof(line) - 1));
+    logHeader.Count++;
+    logHeader.PayloadSize = (uint32_t)(size - sizeof(logHeader));
+    logHeader.Checksum = GD::Record::Crc32(&s_LogBlock[sizeof(logHeader)], logHeader.PayloadSize, GD::Record::Crc32(&logHeader, sizeof(logHeader)));
+    memcpy(&s_LogBlock[0], &logHeader, sizeof(logHeader));
+    ok = ok && WriteAll(file, &s_LogBlock[0], size, offset);
+
+    // The index is read in-place from a mapping, so keep it aligned
+    static const uint8_t padding[8]{};
+    ok = ok && WriteAll(file, padding, (size_t)((8 - offset % 8) % 8), offset);
+    GD::Record::Footer footer;
+    footer.IndexOffset = offset;
+    footer.IndexCount = (uint32_t)chunks;
+    footer.Checksum = GD::Record::Crc32(s_Index.get(), chunks * sizeof(GD::Record::IndexEntry));
+    ok = ok && WriteAll(file, s_Index.get(), chunks * sizeof(GD::Record::IndexEntry), offset);
+    ok = ok && WriteAll(file, &footer, sizeof(footer), offset);
+    ok = FlushFileBuffers(file) && ok;
+    CloseHandle(file);
+
+    if (!crashing)
+        GD_Log("Flight recorder dumped %zu samples to %s (%s)\n", sampleCount - first, path, reason);
+    return ok;
+}
+
+static bool DumpInternal(const char* reason, bool crashing)
+{
+    // The snapshots and the encoder are shared, a second dump at the same time is dropped
+    if (s_Dumping.test_and_set())
+        return false;
+    bool ok = WriteDump(reason, crashing);
+    s_Dumping.clear();
+    return ok;
+}
+
+bool GD::FlightRecorder::Dump(const char* reason)
+{
+    return DumpInternal(reason, false);
+}
+
+void GD::FlightRecorder::Assert(const char* expression, const char* file, int line)
+{
+    GD_Log("Assertion failed: %s (%s:%d)\n", expression, file, line);
+    DumpInternal("assert", false);
+}
@@ -0,0 +1,285 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Where the sticks have been, and the shape of their outer range
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_main.h"
+#include "modules/gd_Heatmap.h"
+#include "imgui.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+using GD::Heatmap::Slots;
+
+constexpr int Sticks = 2;
+constexpr int Bins = 64;                                    // Per side, 1024 stick units per bin
+constexpr int BinShift = 10;
+constexpr int Sectors = 64;
+constexpr int BatchSize = 64;                               // Polls collected before they are binned, about 64 ms
+constexpr double MaxWeight = 1e100;
+constexpr float Pi = 3.14159265358979323846f;
+
+// Decay is done by letting the weight of new samples grow, and scaling everything back down once it gets large
+struct StickMap
+{
+    double Counts[Bins * Bins]{};
+    double Weight = 1.0;
+    float MaxRadius[Sectors]{};
+    uint64_t Samples = 0;
+};
+
+// Owned by the sampling thread
+struct SlotBatch
+{
+    bool Active = false;
+    int Count = 0;
+    uint64_t LastFlush = 0;
+    int32_t X[Sticks][BatchSize];
+    int32_t Y[Sticks][BatchSize];
+};
+
+// Shared with the sampling thread
+static std::mutex s_Lock;
+static StickMap s_Maps[Slots][Sticks];
+static float s_HalfLife = 0.f;                              // Seconds, 0 keeps everything
+static bool s_ResetRequested[Slots]{};
+
+static SlotBatch s_Batches[Slots];
+
+// Owned by the UI
+static ImTextureID s_Textures[Slots][Sticks]{};
+static uint32_t s_Pixels[Bins * Bins];
+
+
+static void ClearMap(StickMap& map)
+{
+    std::fill_n(map.Counts, Bins * Bins, 0.0);
+    std::fill_n(map.MaxRadius, Sectors, 0.f);
+    map.Weight = 1.0;
+    map.Samples = 0;
+}
+
+static void Flush(int slot)
+{
+    SlotBatch& batch = s_Batches[slot];
+    int count = batch.Count;
+    batch.Count = 0;
+    uint64_t now = GD::Now();
+    double elapsed = batch.LastFlush ? (now - batch.LastFlush) / 1e6 : 0.0;
+    batch.LastFlush = now;
+
+    // Bins, sectors and radii for the whole batch first, these loops have no branches and vectorize
+    int32_t bins[Sticks][BatchSize];
+    int32_t sectors[Sticks][BatchSize];
+    float radii[Sticks][BatchSize];
+    for (int stick = 0; stick < Sticks; ++stick)
+    {
+        const int32_t* xs = batch.X[stick];
+        const int32_t* ys = batch.Y[stick];
+        for (int n = 0; n < count; ++n)
+        {
+            int32_t column = (xs[n] + 32768) >> BinShift;
+            int32_t row = (Bins - 1) - ((ys[n] + 32768) >> BinShift);    // Up is up
+            bins[stick][n] = row * Bins + column;
+            radii[stick][n] = std::sqrt((float)xs[n] * xs[n] + (float)ys[n] * ys[n]);
+        }
+        for (int n = 0; n < count; ++n)
+        {
+            float angle = std::atan2((float)ys[n], (float)xs[n]) + Pi;
+            sectors[stick][n] = (int32_t)(angle * (Sectors / (2 * Pi))) & (Sectors - 1);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (s_ResetRequested[slot])
+    {
+        for (auto& map : s_Maps[slot])
+            ClearMap(map);
+        s_ResetRequested[slot] = false;
+    }
+    for (int stick = 0; stick < Sticks; ++stick)
+    {
+        StickMap& map = s_Maps[slot][stick];
+        if (s_HalfLife > 0.f && elapsed > 0.0)
+        {
+            map.Weight *= std::exp2(elapsed / s_HalfLife);
+            if (map.Weight > MaxWeight)
+            {
+                for (double& value : map.Counts)
+                    value /= map.Weight;
+                map.Weight = 1.0;
+            }
+        }
+        for (int n = 0; n < count; ++n)
+            map.Counts[bins[stick][n]] += map.Weight;
+        for (int n = 0; n < count; ++n)
+            map.MaxRadius[sectors[stick][n]] = std::max(map.MaxRadius[sectors[stick][n]], radii[stick][n]);
+        map.Samples += count;
+    }
+}
+
+void GD::Heatmap::Update(const Sample (&samples)[Slots], const bool (&active)[Slots])
+{
+    for (int slot = 0; slot < Slots; ++slot)
+    {
+        SlotBatch& batch = s_Batches[slot];
+        if (active[slot] && !batch.Active)
+        {
+            batch.Count = 0;
+            batch.LastFlush = 0;
+            std::unique_lock<std::mutex> lock(s_Lock);
+            s_ResetRequested[slot] = true;
+        }
+        batch.Active = active[slot];
+        if (!active[slot])
+            continue;
+
+        const Sample& sample = samples[slot];
+        batch.X[0][batch.Count] = sample.ThumbLX;
+        batch.Y[0][batch.Count] = sample.ThumbLY;
+        batch.X[1][batch.Count] = sample.ThumbRX;
+        batch.Y[1][batch.Count] = sample.ThumbRY;
+        if (++batch.Count == BatchSize)
+            Flush(slot);
+    }
+}
+
+
+// Dark blue through red to yellow, the counts are on a log scale so a short visit still shows
+static uint32_t HeatColor(float value)
+{
+    if (value <= 0.f)
+        return 0xFF101018;
+    float r = std::min(1.f, value * 2.f);
+    float g = std::max(0.f, value * 2.f - 1.f);
+    float b = 0.3f * (1.f - value);
+    return 0xFF000000 | ((uint32_t)(r * 255) << 16) | ((uint32_t)(g * 255) << 8) | (uint32_t)(b * 255 + 24);
+}
+
+struct OuterRange
+{
+    int Sectors = 0;
+    float Mean = 0.f;
+    float Min = 0.f;
+    float Max = 0.f;
+    float Circularity = 0.f;                                // RMS deviation from the mean radius, relative to it
+};
+
+// Only the sectors where the stick went past the deadzone say something about the outer range
+static OuterRange MeasureOuterRange(const float* radius, float deadzone)
+{
+    OuterRange range;
+    double sum = 0.0, squares = 0.0;
+    range.Min = 1e9f;
+    for (int sector = 0; sector < Sectors; ++sector)
+    {
+        if (radius[sector] <= deadzone)
+            continue;
+        range.Sectors++;
+        sum += radius[sector];
+        squares += (double)radius[sector] * radius[sector];
+        range.Min = std::min(range.Min, radius[sector]);
+        range.Max = std::max(range.Max, radius[sector]);
+    }
+    if (!range.Sectors)
+        return {};
+    range.Mean = (float)(sum / range.Sectors);
+    double variance = std::max(0.0, squares / range.Sectors - (double)range.Mean * range.Mean);
+    range.Circularity = (float)(std::sqrt(variance) / range.Mean);
+    return range;
+}
+
+void GD::Heatmap::Draw(int slot, int stick, float size)
+{
+    ImTextureID& texture = s_Textures[slot][stick];
+    if (!texture)
+        texture = GD_CreateTexture(Bins, Bins);
+    if (!texture)
+        return;
+
+    float radius[Sectors];
+    uint64_t samples;
+    float halfLife;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        const StickMap& map = s_Maps[slot][stick];
+        double peak = *std::max_element(map.Counts, map.Counts + Bins * Bins);
+        double scale = peak > 0.0 ? 1.0 / std::log1p(peak / map.Weight) : 0.0;
+        for (int n = 0; n < Bins * Bins; ++n)
+            s_Pixels[n] = HeatColor((float)(std::log1p(map.Counts[n] / map.Weight) * scale));
+        std::copy(map.MaxRadius, map.MaxRadius + Sectors, radius);
+        samples = map.Samples;
+        halfLife = s_HalfLife;
+    }
+    GD_UpdateTexture(texture, s_Pixels, Bins, Bins);
+
+    ImVec2 pos = ImGui::GetCursorScreenPos();
+    ImGui::Image(texture, ImVec2(size, size));
+    ImVec2 center(pos.x + size / 2, pos.y + size / 2);
+    float unit = size / 2 / 32768.f;
+    float deadzone = (float)(stick ? GD::RightThumbDeadzone : GD::LeftThumbDeadzone);
+
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    draw->AddCircle(center, 32767 * unit, IM_COL32(255, 255, 255, 60));
+    draw->AddCircle(center, deadzone * unit, IM_COL32(255, 255, 255, 60));
+
+    // The furthest the stick went in every direction, a square gate shows up as a square
+    ImVec2 points[Sectors];
+    int visited = 0;
+    for (int sector = 0; sector < Sectors; ++sector)
+    {
+        float angle = (sector + 0.5f) * (2 * Pi / Sectors) - Pi;
+        points[sector] = ImVec2(center.x + std::cos(angle) * radius[sector] * unit, center.y - std::sin(angle) * radius[sector] * unit);
+        visited += radius[sector] > deadzone;
+    }
+    if (visited == Sectors)
+        draw->AddPolyline(points, Sectors, IM_COL32(80, 255, 120, 255), ImDrawFlags_Closed, 1.f);
+
+    if (ImGui::BeginItemTooltip())
+    {
+        OuterRange range = MeasureOuterRange(radius, deadzone);
+        ImGui::Text("%llu samples", (unsigned long long)samples);
+        if (range.Sectors)
+        {
+            ImGui::Text("Outer range in %d of %d directions", range.Sectors, Sectors);
+            ImGui::Text("Radius %.0f%% (%.0f%% .. %.0f%%) of full scale", 100 * range.Mean / 32767, 100 * range.Min / 32767, 100 * range.Max / 32767);
+            ImGui::Text("Circularity error %.1f%%", 100 * range.Circularity);
+        }
+        else
+        {
+            ImGui::TextUnformatted("Rotate the stick along its gate to measure the outer range");
+        }
+        ImGui::EndTooltip();
+    }
+
+    ImGui::PushID(stick);
+    if (ImGui::BeginPopupContextItem("options"))
+    {
+        ImGui::SetNextItemWidth(120);
+        if (ImGui::SliderFloat("Half-life", &halfLife, 0.f, 60.f, halfLife > 0.f ? "%.1f s" : "Off"))
+        {
+            std::unique_lock<std::mutex> lock(s_Lock);
+            s_HalfLife = halfLife;
+        }
+        if (ImGui::Selectable("Reset"))
+        {
+            std::unique_lock<std::mutex> lock(s_Lock);
+            s_ResetRequested[slot] = true;
+        }
+        ImGui::EndPopup();
+    }
+    ImGui::PopID();
+}
+
+void GD::Heatmap::Shutdown()
+{
+    for (auto& textures : s_Textures)
+    {
+        for (auto& texture : textures)
+        {
+            GD_DestroyTexture(texture);
+            texture = 0;
+        }
+    }
+}
@@ -0,0 +1,63 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Recent samples of all connected devices, shared by the views
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "modules/gd_History.h"
+#include "imgui.h"
+#include <mutex>
+
+// Shared with the sampling threads
+static std::mutex s_Lock;
+static GD::HistoryStore s_Store;
+
+// Owned by the UI
+static int s_BudgetMB = 32;
+
+
+void GD::History::DeviceConnected(const DeviceInfo& info)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_Store.AddDevice(info);
+}
+
+void GD::History::DeviceDisconnected(uint16_t id)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_Store.RemoveDevice(id);
+}
+
+void GD::History::Submit(const Sample& sample)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_Store.Append(sample);
+}
+
+void GD::History::Read(const std::function<void(const HistoryStore& store)>& reader)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    reader(s_Store);
+}
+
+void GD::History::RenderOptions()
+{
+    ImGui::SetNextItemWidth(120);
+    if (ImGui::SliderInt("History", &s_BudgetMB, 4, 512, "%d MB", ImGuiSliderFlags_Logarithmic))
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        s_Store.SetBudget((size_t)s_BudgetMB << 20);
+    }
+    if (ImGui::BeginItemTooltip())
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        ImGui::Text("%zu samples per device, %zu devices", s_Store.Capacity(), s_Store.DeviceCount());
+        ImGui::EndTooltip();
+    }
+}
+
+void GD::History::Shutdown()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    while (s_Store.DeviceCount())
+        s_Store.RemoveDevice(s_Store.Device(0).Id);
+}
@@ -0,0 +1,398 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Recognize fighting game motions and how much of their input windows they use
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "modules/gd_Motions.h"
+#include "gd_motion.h"
+#include "imgui.h"
+#include "imgui_stdlib.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+constexpr size_t MaxMotionDevices = 16;
+constexpr size_t MaxMatches = 64;
+
+enum DirectionSource
+{
+    Source_Either,              // The D-pad when it is pressed, the left stick otherwise
+    Source_LeftStick,
+    Source_DPad,
+};
+
+struct MotionStats
+{
+    uint64_t Count = 0;
+    uint64_t Fastest = UINT64_MAX;
+    uint64_t Total = 0;
+    int64_t TightestMargin = INT64_MAX;     // Least time left of any step window
+};
+
+struct DeviceMotions
+{
+    GD::DeviceInfo Info;
+    bool Connected = false;
+    GD::MotionRecognizer Recognizer;
+    std::vector<GD::MotionMatch> Pending;
+    std::vector<GD::MotionMatch> Matches;   // The newest MaxMatches, oldest first
+    std::vector<MotionStats> Stats;
+    uint64_t Samples = 0;
+    uint64_t First = 0;
+    uint64_t Last = 0;
+};
+
+struct MotionText
+{
+    std::string Name;
+    std::string Notation;
+    std::string Error;
+    int Compiled = -1;                      // Index in the recognizer, -1 when it did not compile
+};
+
+// Shared with the sampling thread
+static std::mutex s_Lock;
+static DeviceMotions s_Devices[MaxMotionDevices];
+static std::vector<GD::Motion> s_Motions;
+static int s_Source = Source_Either;
+
+// Owned by the UI
+static bool s_Visible = false;
+static int s_Device = 0;
+static float s_FrameRate = 60.f;
+static std::vector<MotionText> s_Texts = {
+    { "Quarter circle", "236X" },
+    { "Dragon punch", "623X" },
+    { "Half circle", "41236X" },
+    { "Charge", "[4]6X" },
+    { "Plink", "X~A" },
+};
+static bool s_Compiled = false;
+
+
+static DeviceMotions* FindDevice(uint16_t id)
+{
+    for (auto& device : s_Devices)
+    {
+        if (device.Connected && device.Info.Id == id)
+            return &device;
+    }
+    return nullptr;
+}
+
+static void ResetDevice(DeviceMotions& device)
+{
+    device.Recognizer.SetMotions(s_Motions);
+    device.Matches.clear();
+    device.Stats.assign(s_Motions.size(), MotionStats());
+    device.Samples = 0;
+}
+
+void GD::Motions::DeviceConnected(const DeviceInfo& info)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceMotions* device = FindDevice(info.Id);
+    for (size_t n = 0; n < MaxMotionDevices && !device; ++n)
+    {
+        if (!s_Devices[n].Connected)
+            device = &s_Devices[n];
+    }
+    if (!device)
+        return;
+
+    ResetDevice(*device);
+    device->Info = info;
+    device->Connected = true;
+}
+
+void GD::Motions::DeviceDisconnected(uint16_t id)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (DeviceMotions* device = FindDevice(id))
+        device->Connected = false;
+}
+
+void GD::Motions::Submit(const Sample& sample)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceMotions* device = FindDevice(sample.Device);
+    if (!device)
+        return;
+
+    int direction = 5;
+    if (s_Source != Source_LeftStick)
+        direction = DPadDirection(sample.Buttons);
+    if (s_Source != Source_DPad && direction == 5)
+        direction = NumpadDirection(sample.ThumbLX, sample.ThumbLY, (float)LeftThumbDeadzone);
+
+    if (!device->Samples++)
+        device->First = sample.Timestamp;
+    device->Last = sample.Timestamp;
+
+    device->Pending.clear();
+    device->Recognizer.Add(sample.Timestamp, direction, sample.Buttons, device->Pending);
+    for (const auto& match : device->Pending)
+    {
+        const GD::Motion& motion = device->Recognizer.Motions()[match.Motion];
+        MotionStats& stats = device->Stats[match.Motion];
+        uint64_t total = match.Times[match.Steps - 1] - match.Times[0];
+        stats.Count++;
+        stats.Total += total;
+        stats.Fastest = std::min(stats.Fastest, total);
+        for (int k = 1; k < match.Steps; ++k)
+            stats.TightestMargin = std::min(stats.TightestMargin, (int64_t)motion.Steps[k].Window - (int64_t)(match.Times[k] - match.Times[k - 1]));
+
+        if (device->Matches.size() == MaxMatches)
+            device->Matches.erase(device->Matches.begin());
+        device->Matches.push_back(match);
+    }
+}
+
+
+// Motions that do not compile keep their text, so they can be fixed
+static void CompileMotions()
+{
+    std::vector<GD::Motion> motions;
+    for (auto& text : s_Texts)
+    {
+        GD::Motion motion;
+        text.Error.clear();
+        text.Compiled = -1;
+        if (GD::CompileMotion(text.Name.c_str(), text.Notation.c_str(), s_FrameRate, motion, text.Error))
+        {
+            text.Compiled = (int)motions.size();
+            motions.push_back(motion);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_Motions = motions;
+    for (auto& device : s_Devices)
+        ResetDevice(device);
+    s_Compiled = true;
+}
+
+static void RenderMotionTable(const GD::Motion* motions, const std::vector<MotionStats>& stats)
+{
+    if (!ImGui::BeginTable("motions", 7, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+        return;
+
+    bool changed = false;
+    int remove = -1;
+    ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Notation", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Count");
+    ImGui::TableSetupColumn("Fastest");
+    ImGui::TableSetupColumn("Mean");
+    ImGui::TableSetupColumn("Margin");
+    ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableHeadersRow();
+    for (int n = 0; n < (int)s_Texts.size(); ++n)
+    {
+        MotionText& text = s_Texts[n];
+        ImGui::PushID(n);
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        changed |= ImGui::InputText("##name", &text.Name, ImGuiInputTextFlags_EnterReturnsTrue);
+        changed |= ImGui::IsItemDeactivatedAfterEdit();
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        if (!text.Error.empty())
+            ImGui::PushStyleColor(ImGuiCol_FrameBg, IM_COL32(120, 30, 30, 255));
+        changed |= ImGui::InputText("##notation", &text.Notation, ImGuiInputTextFlags_EnterReturnsTrue);
+        changed |= ImGui::IsItemDeactivatedAfterEdit();
+        if (!text.Error.empty())
+        {
+            ImGui::PopStyleColor();
+            ImGui::SetItemTooltip("%s", text.Error.c_str());
+        }
+
+        ImGui::TableNextColumn();
+        if (text.Compiled >= 0 && text.Compiled < (int)stats.size() && stats[text.Compiled].Count)
+        {
+            const GD::Motion& motion = motions[text.Compiled];
+            const MotionStats& stat = stats[text.Compiled];
+            ImGui::Text("%llu", (unsigned long long)stat.Count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f f", motion.Frames(stat.Fastest));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f f", motion.Frames(stat.Total) / stat.Count);
+            ImGui::TableNextColumn();
+            if (motion.Steps.size() > 1)
+            {
+                double margin = stat.TightestMargin * motion.FrameRate / 1e6;
+                if (margin < 1.0)
+                    ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(160, 40, 40, 255));
+                ImGui::Text("%.2f f", margin);
+            }
+        }
+        else
+        {
+            ImGui::TableNextColumn();
+            ImGui::TableNextColumn();
+            ImGui::TableNextColumn();
+        }
+        ImGui::TableNextColumn();
+        if (ImGui::SmallButton("x"))
+            remove = n;
+        ImGui::PopID();
+    }
+    ImGui::EndTable();
+
+    if (remove >= 0)
+    {
+        s_Texts.erase(s_Texts.begin() + remove);
+        changed = true;
+    }
+    if (ImGui::Button("Add motion"))
+    {
+        s_Texts.push_back({ "Motion", "214X" });
+        changed = true;
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("(?)");
+    ImGui::SetItemTooltip(
+        "Digits are numpad directions (6 is forward, 2 is down), names like A, X or LB are buttons.\n"
+        "[4] charges back for %d frames, [4:30] for 30 frames, down-back also charges back.\n"
+        "X~A plinks: A has to follow X in a later sample, within %d frames.\n"
+        "Each step has to come within %d frames of the one before it, 6/4 sets 4 frames for that step.\n"
+        "Margin is the least time that was left in the window of any step.",
+        GD::ChargeFrames, GD::PlinkWindowFrames, GD::StepWindowFrames);
+    if (changed)
+        CompileMotions();
+}
+
+void GD::Motions::RenderFrame()
+{
+    if (!s_Visible)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(640, 560), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Motions", &s_Visible))
+    {
+        ImGui::End();
+        return;
+    }
+
+    // Copy what is needed, the sampling thread keeps going
+    GD::DeviceInfo devices[MaxMotionDevices];
+    std::vector<GD::Motion> motions;
+    std::vector<GD::MotionMatch> matches;
+    std::vector<MotionStats> stats;
+    int direction = 5;
+    double interval = 0;
+    int count = 0;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        motions = s_Motions;
+        for (const auto& device : s_Devices)
+        {
+            if (!device.Connected)
+                continue;
+            if (count == s_Device)
+            {
+                matches = device.Matches;
+                stats = device.Stats;
+                direction = device.Recognizer.Direction();
+                if (device.Samples > 1)
+                    interval = (device.Last - device.First) / (double)(device.Samples - 1);
+            }
+            devices[count++] = device.Info;
+        }
+    }
+
+    if (!count)
+    {
+        ImGui::TextUnformatted("No devices connected");
+        ImGui::End();
+        return;
+    }
+    s_Device = std::min(s_Device, count - 1);
+
+    char preview[32];
+    snprintf(preview, sizeof(preview), "XUser %d", devices[s_Device].Slot);
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::BeginCombo("Device", preview))
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            char label[32];
+            snprintf(label, sizeof(label), "XUser %d##%d", devices[n].Slot, n);
+            if (ImGui::Selectable(label, n == s_Device))
+                s_Device = n;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    int source = s_Source;
+    if (ImGui::Combo("Directions", &source, "D-pad or stick\0Left stick\0D-pad\0"))
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        s_Source = source;
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(80);
+    if (ImGui::InputFloat("Frame rate", &s_FrameRate, 0.f, 0.f, "%.1f", ImGuiInputTextFlags_EnterReturnsTrue) || ImGui::IsItemDeactivatedAfterEdit())
+    {
+        s_FrameRate = std::clamp(s_FrameRate, 1.f, 1000.f);
+        CompileMotions();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        if (DeviceMotions* device = FindDevice(devices[s_Device].Id))
+            ResetDevice(*device);
+    }
+
+    // A step can not be timed finer than the polling, so that is the resolution of every number below
+    ImGui::Text("Direction %d, polled every %.2f ms (%.2f frames)", direction, interval / 1000.0, interval * s_FrameRate / 1e6);
+
+    ImGui::SeparatorText("Motions");
+    RenderMotionTable(motions.data(), stats);
+
+    ImGui::SeparatorText("Matches");
+    uint64_t now = GD::Now();
+    if (ImGui::BeginChild("matches", ImVec2(0, 0), ImGuiChildFlags_FrameStyle))
+    {
+        for (auto it = matches.rbegin(); it != matches.rend(); ++it)
+        {
+            if (it->Motion >= motions.size())
+                continue;
+            const GD::Motion& motion = motions[it->Motion];
+            double ago = it->Times[it->Steps - 1] <= now ? (now - it->Times[it->Steps - 1]) / 1e6 : 0.0;
+            std::string steps;
+            for (int k = 0; k < it->Steps; ++k)
+            {
+                char step[48];
+                if (k)
+                    snprintf(step, sizeof(step), " +%.2f %s", motion.Frames(it->Times[k] - it->Times[k - 1]), motion.Steps[k].Label.c_str());
+                else
+                    snprintf(step, sizeof(step), "%s", motion.Steps[k].Label.c_str());
+                steps += step;
+            }
+            ImGui::Text("-%8.3f s  %-16s %s  (%.2f frames)", ago, motion.Name.c_str(), steps.c_str(), motion.Frames(it->Times[it->Steps - 1] - it->Times[0]));
+        }
+    }
+    ImGui::EndChild();
+
+    ImGui::End();
+}
+
+void GD::Motions::Show()
+{
+    // Nothing is recognized until the window is opened for the first time
+    if (!s_Compiled)
+        CompileMotions();
+    s_Visible = true;
+}
+
+void GD::Motions::Shutdown()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (auto& device : s_Devices)
+        device = {};
+    s_Motions.clear();
+}
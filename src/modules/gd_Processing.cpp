@@ -0,0 +1,398 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Preview how a game sees the input after its deadzones, curves and filters
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "modules/gd_Processing.h"
+#include "modules/gd_History.h"
+#include "gd_pipeline.h"
+#include "imgui.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+using namespace GD::Processing;
+
+constexpr float MaxLength = 10.f;                           // Seconds
+constexpr int PlotPoints = 256;
+
+struct ControlInfo
+{
+    const char* Name;
+    int AxisX;
+    int AxisY;                                              // -1 for a trigger
+    float FullScale;
+};
+
+static const ControlInfo s_Controls[Control_Count] = {
+    { "Left stick", GD::Axis_ThumbLX, GD::Axis_ThumbLY, 32767.f },
+    { "Right stick", GD::Axis_ThumbRX, GD::Axis_ThumbRY, 32767.f },
+    { "Left trigger", GD::Axis_LeftTrigger, -1, 255.f },
+    { "Right trigger", GD::Axis_RightTrigger, -1, 255.f },
+};
+
+// Owned by the UI, the pipelines are configured per control and shared by all devices
+static bool s_Visible = false;
+static int s_Device = 0;
+static int s_Control = Control_LeftStick;
+static float s_Length = 2.f;                                // Seconds
+static GD::AxisPipeline s_Pipelines[Control_Count];
+static bool s_Configured = false;
+static std::vector<uint64_t> s_Timestamps;
+static std::vector<float> s_Raw[2];
+static std::vector<float> s_Processed[2];
+static std::vector<ImVec2> s_Points;
+static float s_Plots[2][2][PlotPoints];                     // [raw, processed][x, y]
+static double s_Cost = 0.0;                                 // Nanoseconds per sample
+
+
+// Matches what the XInput documentation recommends
+static void ResetPipeline(int control)
+{
+    const ControlInfo& info = s_Controls[control];
+    GD::Stage stage = GD::DefaultStage(info.AxisY < 0 ? GD::Stage_AxialDeadzone : GD::Stage_RadialDeadzone);
+    switch (control)
+    {
+    case Control_LeftStick: stage.Inner = GD::LeftThumbDeadzone / info.FullScale; break;
+    case Control_RightStick: stage.Inner = GD::RightThumbDeadzone / info.FullScale; break;
+    default: stage.Inner = GD::TriggerThreshold / info.FullScale; break;
+    }
+    s_Pipelines[control].SetStages({ stage });
+}
+
+static GD::AxisPipeline& Pipeline(int control)
+{
+    if (!s_Configured)
+    {
+        for (int n = 0; n < Control_Count; ++n)
+            ResetPipeline(n);
+        s_Configured = true;
+    }
+    return s_Pipelines[control];
+}
+
+float GD::Processing::Deadzone(int control)
+{
+    return Pipeline(control).Deadzone() * s_Controls[control].FullScale;
+}
+
+// Copies the recent samples of one control out of the history, already normalized
+static bool ReadHistory(uint16_t id, const ControlInfo& control, uint64_t start)
+{
+    bool known = false;
+    GD::History::Read([&](const GD::HistoryStore& store)
+        {
+            GD::HistorySpan span;
+            if (!store.Span(id, start, span))
+                return;
+            known = true;
+            size_t count = span.Size();
+            s_Timestamps.resize(count);
+            for (auto& values : s_Raw)
+                values.assign(count, 0.f);
+            size_t n = 0;
+            for (int part = 0; part < 2; ++part)
+            {
+                std::copy(span.Timestamps[part], span.Timestamps[part] + span.Count[part], s_Timestamps.begin() + n);
+                GD::NormalizeAxis(span.Axes[control.AxisX][part], span.Count[part], 1.f / control.FullScale, s_Raw[0].data() + n);
+                if (control.AxisY >= 0)
+                    GD::NormalizeAxis(span.Axes[control.AxisY][part], span.Count[part], 1.f / control.FullScale, s_Raw[1].data() + n);
+                n += span.Count[part];
+            }
+        });
+    return known;
+}
+
+// The value held at evenly spaced times, so a burst of samples does not stretch the plot
+static void Resample(const std::vector<float>& values, uint64_t start, uint64_t now, float (&plot)[PlotPoints])
+{
+    size_t n = 0;
+    float held = values.empty() ? 0.f : values[0];
+    for (int point = 0; point < PlotPoints; ++point)
+    {
+        uint64_t time = start + (now - start) * point / (PlotPoints - 1);
+        for (; n < values.size() && s_Timestamps[n] <= time; ++n)
+            held = values[n];
+        plot[point] = held;
+    }
+}
+
+static void StickView(const char* label, const std::vector<float>& x, const std::vector<float>& y, float deadzone, float size)
+{
+    ImVec2 pos = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton(label, ImVec2(size, size));
+    ImVec2 center(pos.x + size / 2, pos.y + size / 2);
+    float unit = size / 2 - 4;
+
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    draw->AddRect(pos, ImVec2(pos.x + size, pos.y + size), IM_COL32(255, 255, 255, 40));
+    draw->AddCircle(center, unit, IM_COL32(255, 255, 255, 60));
+    if (deadzone > 0.f)
+        draw->AddCircle(center, deadzone * unit, IM_COL32(255, 255, 255, 60));
+
+    s_Points.resize(x.size());
+    for (size_t n = 0; n < x.size(); ++n)
+        s_Points[n] = ImVec2(center.x + x[n] * unit, center.y - y[n] * unit);
+    if (s_Points.size() > 1)
+        draw->AddPolyline(s_Points.data(), (int)s_Points.size(), ImGui::GetColorU32(ImGuiCol_PlotLines), ImDrawFlags_None, 1.f);
+    if (!s_Points.empty())
+        draw->AddCircleFilled(s_Points.back(), 4.f, IM_COL32(80, 255, 120, 255));
+    draw->AddText(ImVec2(pos.x + 4, pos.y + 2), ImGui::GetColorU32(ImGuiCol_Text), label);
+}
+
+// The mean of what is shown, with the stick left alone that is where it rests
+static void CenterFromRest(GD::Stage& stage)
+{
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        const std::vector<float>& values = s_Raw[axis];
+        double sum = 0.0;
+        for (float value : values)
+            sum += value;
+        stage.Center[axis] = values.empty() ? 0.f : (float)(sum / values.size());
+    }
+}
+
+static bool RenderStage(GD::Stage& stage, bool stick)
+{
+    bool changed = ImGui::Checkbox("##enabled", &stage.Enabled);
+    ImGui::SameLine();
+    ImGui::TextUnformatted(GD::StageName(stage.Type));
+    ImGui::TableNextColumn();
+
+    int axes = stick ? 2 : 1;
+    ImGui::SetNextItemWidth(120);
+    switch (stage.Type)
+    {
+    case GD::Stage_Calibration:
+        changed |= ImGui::DragScalarN("Center", ImGuiDataType_Float, stage.Center, axes, 0.001f, nullptr, nullptr, "%.3f");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::DragScalarN("Gain", ImGuiDataType_Float, stage.Gain, axes, 0.005f, nullptr, nullptr, "%.3f");
+        ImGui::SameLine();
+        if (ImGui::SmallButton("From rest"))
+        {
+            CenterFromRest(stage);
+            changed = true;
+        }
+        ImGui::SetItemTooltip("Leave the stick alone, the center becomes where it rests");
+        break;
+    case GD::Stage_AxialDeadzone:
+    case GD::Stage_RadialDeadzone:
+    case GD::Stage_AntiDeadzone:
+        changed |= ImGui::SliderFloat("Size", &stage.Inner, 0.f, 0.9f, "%.3f");
+        break;
+    case GD::Stage_ScaledRadialDeadzone:
+        changed |= ImGui::SliderFloat("Inner", &stage.Inner, 0.f, 0.9f, "%.3f");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::SliderFloat("Outer", &stage.Outer, 0.1f, 1.f, "%.3f");
+        stage.Outer = std::max(stage.Outer, stage.Inner + 0.01f);
+        break;
+    case GD::Stage_Curve:
+        changed |= ImGui::SliderFloat("Shape", &stage.Shape, -1.f, 1.f, "%.2f");
+        ImGui::SetItemTooltip("Below 0 moves fast off the center, above 0 gives fine control near it");
+        break;
+    case GD::Stage_OneEuro:
+        changed |= ImGui::SliderFloat("Min cutoff", &stage.MinCutoff, 0.01f, 20.f, "%.2f Hz", ImGuiSliderFlags_Logarithmic);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::SliderFloat("Beta", &stage.Beta, 0.f, 50.f, "%.2f", ImGuiSliderFlags_Logarithmic);
+        ImGui::SetItemTooltip("How fast the cutoff rises with the speed of the stick, higher is less lag");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::SliderFloat("Speed cutoff", &stage.DerivativeCutoff, 0.01f, 20.f, "%.2f Hz", ImGuiSliderFlags_Logarithmic);
+        break;
+    default:
+        break;
+    }
+    return changed;
+}
+
+static void RenderStages(GD::AxisPipeline& pipeline, bool stick)
+{
+    std::vector<GD::Stage> stages = pipeline.Stages();
+    bool changed = false;
+    int remove = -1, up = -1;
+
+    if (ImGui::BeginTable("stages", 3, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Stage", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Settings", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableHeadersRow();
+        for (int n = 0; n < (int)stages.size(); ++n)
+        {
+            ImGui::PushID(n);
+            ImGui::TableNextColumn();
+            changed |= RenderStage(stages[n], stick);
+            ImGui::TableNextColumn();
+            if (ImGui::ArrowButton("up", ImGuiDir_Up) && n > 0)
+                up = n;
+            ImGui::SameLine();
+            if (ImGui::ArrowButton("down", ImGuiDir_Down) && n + 1 < (int)stages.size())
+                up = n + 1;
+            ImGui::SameLine();
+            if (ImGui::SmallButton("x"))
+                remove = n;
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+
+    if (up > 0)
+    {
+        std::swap(stages[up - 1], stages[up]);
+        changed = true;
+    }
+    if (remove >= 0)
+    {
+        stages.erase(stages.begin() + remove);
+        changed = true;
+    }
+    ImGui::SetNextItemWidth(200);
+    if (ImGui::BeginCombo("##add", "Add stage", ImGuiComboFlags_NoArrowButton))
+    {
+        for (int type = 0; type < GD::Stage_Count; ++type)
+        {
+            if (ImGui::Selectable(GD::StageName(type)))
+            {
+                stages.push_back(GD::DefaultStage((GD::StageType)type));
+                changed = true;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    if (changed)
+        pipeline.SetStages(stages);
+}
+
+void GD::Processing::RenderFrame()
+{
+    if (!s_Visible)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(720, 640), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Processing", &s_Visible))
+    {
+        ImGui::End();
+        return;
+    }
+
+    DeviceInfo devices[16];
+    int count = 0;
+    GD::History::Read([&](const HistoryStore& store)
+        {
+            for (size_t n = 0; n < store.DeviceCount() && count < 16; ++n)
+                devices[count++] = store.Device(n);
+        });
+    if (!count)
+    {
+        ImGui::TextUnformatted("No devices connected");
+        ImGui::End();
+        return;
+    }
+    s_Device = std::min(s_Device, count - 1);
+
+    char preview[32];
+    snprintf(preview, sizeof(preview), "XUser %d", devices[s_Device].Slot);
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::BeginCombo("Device", preview))
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            char label[32];
+            snprintf(label, sizeof(label), "XUser %d##%d", devices[n].Slot, n);
+            if (ImGui::Selectable(label, n == s_Device))
+                s_Device = n;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    if (ImGui::BeginCombo("Control", s_Controls[s_Control].Name))
+    {
+        for (int n = 0; n < Control_Count; ++n)
+        {
+            if (ImGui::Selectable(s_Controls[n].Name, n == s_Control))
+                s_Control = n;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    ImGui::SliderFloat("Length", &s_Length, 0.1f, MaxLength, "%.1f s");
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+        ResetPipeline(s_Control);
+
+    const ControlInfo& control = s_Controls[s_Control];
+    bool stick = control.AxisY >= 0;
+    AxisPipeline& pipeline = Pipeline(s_Control);
+
+    // The whole window goes through the pipeline from a clean state every frame, so a change shows on all of it
+    uint64_t now = GD::Now();
+    uint64_t start = now - (uint64_t)(s_Length * 1e6f);
+    if (!ReadHistory(devices[s_Device].Id, control, start))
+    {
+        s_Timestamps.clear();
+        for (auto& values : s_Raw)
+            values.clear();
+    }
+    size_t samples = s_Timestamps.size();
+    for (int axis = 0; axis < 2; ++axis)
+        s_Processed[axis] = s_Raw[axis];
+    pipeline.Reset();
+    uint64_t begin = GD::Now();
+    pipeline.Process(s_Timestamps.data(), s_Processed[0].data(), s_Processed[1].data(), samples);
+    if (samples)
+        s_Cost = 0.9 * s_Cost + 0.1 * (GD::Now() - begin) * 1e3 / samples;
+
+    ImGui::SeparatorText("Pipeline");
+    RenderStages(pipeline, stick);
+    ImGui::TextDisabled("%zu samples, %.1f ns per sample", samples, s_Cost);
+
+    ImGui::SeparatorText("Raw and processed");
+    for (int axis = 0; axis < (stick ? 2 : 1); ++axis)
+    {
+        Resample(s_Raw[axis], start, now, s_Plots[0][axis]);
+        Resample(s_Processed[axis], start, now, s_Plots[1][axis]);
+    }
+    if (ImGui::BeginTable("views", 2))
+    {
+        float low = stick ? -1.f : 0.f;
+        for (int which = 0; which < 2; ++which)
+        {
+            ImGui::TableNextColumn();
+            const char* title = which ? "Processed" : "Raw";
+            if (stick)
+            {
+                float size = std::min(ImGui::GetContentRegionAvail().x, 240.f);
+                StickView(title, which ? s_Processed[0] : s_Raw[0], which ? s_Processed[1] : s_Raw[1], which ? 0.f : pipeline.Deadzone(), size);
+            }
+            else
+            {
+                ImGui::TextUnformatted(title);
+            }
+            const std::vector<float>& last = which ? s_Processed[0] : s_Raw[0];
+            ImGui::PlotLines("##x", s_Plots[which][0], PlotPoints, 0, stick ? "X" : nullptr, low, 1.f, ImVec2(-FLT_MIN, 60));
+            if (stick)
+                ImGui::PlotLines("##y", s_Plots[which][1], PlotPoints, 0, "Y", low, 1.f, ImVec2(-FLT_MIN, 60));
+            if (!last.empty())
+            {
+                if (stick)
+                    ImGui::Text("%.3f, %.3f", last.back(), (which ? s_Processed[1] : s_Raw[1]).back());
+                else
+                    ImGui::Text("%.3f", last.back());
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void GD::Processing::Show()
+{
+    s_Visible = true;
+}
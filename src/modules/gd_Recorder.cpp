@@ -0,0 +1,178 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Record the samples of all connected devices
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_win32.h"
+#include "gd_log.h"
+#include "modules/gd_Recorder.h"
+#include "modules/gd_Bench.h"
+#include "modules/gd_Buttons.h"
+#include "modules/gd_Capture.h"
+#include "modules/gd_Crosstalk.h"
+#include "modules/gd_FlightRecorder.h"
+#include "modules/gd_History.h"
+#include "modules/gd_Motions.h"
+#include "modules/gd_Resolution.h"
+#include "modules/gd_Scripts.h"
+#include "modules/gd_Spectrum.h"
+#include "modules/gd_Timing.h"
+#include "record/gd_RecordWriter.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct LiveDevice
+{
+    GD::DeviceInfo Info;
+    GD::Sample State;
+};
+
+// Log output can arrive from any thread
+static std::mutex s_Lock;
+static GD::Record::Writer s_Writer;
+static std::vector<LiveDevice> s_Devices;
+static std::string s_LastPath;
+
+
+bool GD::Recorder::Start()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (s_Writer.IsOpen())
+        return true;
+
+    SYSTEMTIME st{};
+    GetLocalTime(&st);
+    char path[MAX_PATH];
+    StringCchPrintfA(path, _countof(path), "GamepadDebug_%04d%02d%02d_%02d%02d%02d.gdrec",
+        st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond);
+
+    if (!s_Writer.Open(path))
+    {
+        lock.unlock();
+        GD_Log("Failed to create recording %s\n", path);
+        return false;
+    }
+
+    for (const auto& device : s_Devices)
+        s_Writer.AddDevice(device.Info, device.State);
+
+    s_LastPath = path;
+    lock.unlock();
+    GD_Log("Recording to %s\n", path);
+    return true;
+}
+
+void GD::Recorder::Stop()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (!s_Writer.IsOpen())
+        return;
+
+    uint64_t bytes = s_Writer.BytesWritten();
+    s_Writer.Close();
+    uint64_t dropped = s_Writer.Dropped();
+    lock.unlock();
+    GD_Log("Recording stopped, %llu bytes written\n", bytes);
+    if (dropped)
+        GD_Log("The writer fell behind, %llu samples were dropped\n", dropped);
+}
+
+bool GD::Recorder::IsRecording()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    return s_Writer.IsOpen();
+}
+
+const char* GD::Recorder::LastPath()
+{
+    return s_LastPath.c_str();
+}
+
+void GD::Recorder::DeviceConnected(const DeviceInfo& info)
+{
+    DeviceDisconnected(info.Id);
+    GD::FlightRecorder::DeviceConnected(info);
+    GD::Capture::DeviceConnected(info);
+    GD::Spectrum::DeviceConnected(info);
+    GD::Timing::DeviceConnected(info);
+    GD::Resolution::DeviceConnected(info);
+    GD::Crosstalk::DeviceConnected(info);
+    GD::History::DeviceConnected(info);
+    GD::Buttons::DeviceConnected(info);
+    GD::Motions::DeviceConnected(info);
+    GD::Scripts::DeviceConnected(info);
+    GD::Bench::DeviceConnected(info);
+
+    LiveDevice device;
+    device.Info = info;
+    device.State.Device = info.Id;
+    device.State.Timestamp = GD::Now();
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_Devices.push_back(device);
+    s_Writer.AddDevice(device.Info, device.State);
+}
+
+void GD::Recorder::DeviceDisconnected(uint16_t id)
+{
+    GD::FlightRecorder::DeviceDisconnected(id);
+    GD::Capture::DeviceDisconnected(id);
+    GD::Spectrum::DeviceDisconnected(id);
+    GD::Timing::DeviceDisconnected(id);
+    GD::Resolution::DeviceDisconnected(id);
+    GD::Crosstalk::DeviceDisconnected(id);
+    GD::History::DeviceDisconnected(id);
+    GD::Buttons::DeviceDisconnected(id);
+    GD::Motions::DeviceDisconnected(id);
+    GD::Scripts::DeviceDisconnected(id);
+    GD::Bench::DeviceDisconnected(id);
+
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (auto it = s_Devices.begin(); it != s_Devices.end(); ++it)
+    {
+        if (it->Info.Id == id)
+        {
+            s_Devices.erase(it);
+            s_Writer.RemoveDevice(id);
+            return;
+        }
+    }
+}
+
+void GD::Recorder::Submit(const Sample& sample)
+{
+    GD::FlightRecorder::Submit(sample);
+    GD::Capture::Submit(sample);
+    GD::Spectrum::Submit(sample);
+    GD::Timing::Submit(sample);
+    GD::Resolution::Submit(sample);
+    GD::Crosstalk::Submit(sample);
+    GD::History::Submit(sample);
+    GD::Buttons::Submit(sample);
+    GD::Motions::Submit(sample);
+    GD::Scripts::Submit(sample);
+    GD::Bench::Submit(sample);
+
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (auto& device : s_Devices)
+    {
+        if (device.Info.Id == sample.Device)
+            device.State = sample;
+    }
+    s_Writer.Append(sample);
+}
+
+void GD::Recorder::Log(uint64_t timestamp, const char* text, size_t length)
+{
+    GD::FlightRecorder::Log(timestamp, text, length);
+
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_Writer.AppendLog(timestamp, text, length);
+}
+
+void GD::Recorder::Shutdown()
+{
+    Stop();
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_Devices.clear();
+}
@@ -0,0 +1,475 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Replay recorded sessions
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_log.h"
+#include "modules/gd_Recorder.h"
+#include "modules/gd_Replay.h"
+#include "record/gd_RecordExport.h"
+#include "record/gd_RecordPyramid.h"
+#include "record/gd_RecordReader.h"
+#include "record/gd_RecordQuery.h"
+#include "record/gd_RecordWriter.h"
+#include "imgui.h"
+#include "imgui_internal.h"
+#include "imgui_stdlib.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <future>
+#include <string>
+
+static bool s_Visible = false;
+static std::string s_Path;
+static GD::Record::Reader s_Reader;
+static std::vector<GD::Record::KeyframeEntry> s_State;
+static double s_Position = 0.0;    // Seconds since the first chunk
+static double s_StatePosition = -1.0;
+static bool s_Playing = false;
+static std::vector<GD::Record::LogRecord> s_Log;
+
+static std::string s_QueryText;
+static std::future<std::vector<GD::Record::QueryMatch>> s_QueryResult;
+static std::vector<GD::Record::QueryMatch> s_Matches;
+static GD::Record::QueryStats s_QueryStats;
+
+static const char* s_ExportFormats[] = { ".parquet", ".vcd" };
+static std::future<std::string> s_ExportResult;     // Error message, empty on success
+static std::string s_ExportPath;
+
+static GD::Record::Pyramid s_Pyramid;
+static std::future<GD::Record::Pyramid> s_PyramidResult;
+static double s_ViewStart = 0.0;    // Seconds since the first chunk, like s_Position
+static double s_ViewEnd = 0.0;
+static int s_TimelineDevice = 0;
+static std::vector<GD::Record::Bucket> s_Columns;     // Decimated view, only redone when the view changes
+static uint64_t s_ColumnsStart = 0;
+static uint64_t s_ColumnsEnd = 0;
+static int s_ColumnsDevice = -1;
+static int s_ColumnsLevel = 0;
+
+
+// The file the recorder is still writing to, recovering that would cut it off under the writer
+static bool IsLiveRecording(const std::string& path)
+{
+    if (!GD::Recorder::IsRecording())
+        return false;
+    std::error_code ec;
+    return std::filesystem::equivalent(path, GD::Recorder::LastPath(), ec) || path == GD::Recorder::LastPath();
+}
+
+static void OpenRecording()
+{
+    if (s_QueryResult.valid())
+        s_QueryResult.wait();
+    if (s_ExportResult.valid())
+        s_ExportResult.wait();
+    if (s_PyramidResult.valid())
+        s_PyramidResult.wait();
+    s_QueryResult = {};
+    s_PyramidResult = {};
+    s_Pyramid.Begin(0);
+    s_ViewStart = s_ViewEnd = 0.0;
+    s_ColumnsDevice = -1;
+    s_Matches.clear();
+    s_Playing = false;
+    s_Position = 0.0;
+    s_StatePosition = -1.0;
+    s_State.clear();
+    s_Log.clear();
+    if (!s_Reader.Open(s_Path.c_str()))
+    {
+        if (IsLiveRecording(s_Path))
+        {
+            GD_Log("%s is still being recorded, stop the recording to replay it\n", s_Path.c_str());
+            return;
+        }
+        // A recording that was interrupted has no index yet, so cut it back to the last intact chunk
+        GD::Record::RecoverResult result;
+        std::string error;
+        if (!GD::Record::Recover(s_Path.c_str(), result, error))
+        {
+            GD_Log("Failed to open %s: %s\n", s_Path.c_str(), error.c_str());
+            return;
+        }
+        if (!result.HadIndex)
+            GD_Log("Recovered %s: %u chunks, %llu of %llu bytes kept\n", s_Path.c_str(), result.Chunks, result.ValidSize, result.OriginalSize);
+        if (!s_Reader.Open(s_Path.c_str()))
+        {
+            GD_Log("Failed to open %s: %s\n", s_Path.c_str(), s_Reader.Error().c_str());
+            return;
+        }
+    }
+
+    s_Reader.ReadLog(s_Log);
+    std::stable_sort(s_Log.begin(), s_Log.end(), [](const GD::Record::LogRecord& a, const GD::Record::LogRecord& b)
+        {
+            return a.Timestamp < b.Timestamp;
+        });
+    GD_Log("Opened %s, %zu chunks\n", s_Path.c_str(), s_Reader.ChunkCount());
+
+    // Recordings made before there was an overview, or that lost it, get one on a thread
+    std::string pyramidPath = s_Path + GD::Record::PyramidExtension;
+    if (!s_Pyramid.Load(pyramidPath.c_str(), s_Reader))
+    {
+        s_PyramidResult = std::async(std::launch::async, [path = s_Path, pyramidPath]()
+            {
+                GD::Record::Pyramid pyramid;
+                GD::Record::Reader reader;
+                if (reader.Open(path.c_str()) && GD::Record::BuildPyramid(reader, pyramid))
+                    pyramid.Save(pyramidPath.c_str(), reader);
+                return pyramid;
+            });
+    }
+}
+
+static void RenderLog(uint64_t position)
+{
+    if (s_Log.empty())
+        return;
+
+    // The last few lines that were logged before the current position
+    auto end = std::upper_bound(s_Log.begin(), s_Log.end(), position, [](uint64_t timestamp, const GD::Record::LogRecord& record)
+        {
+            return timestamp < record.Timestamp;
+        });
+    auto begin = end - std::min<ptrdiff_t>(end - s_Log.begin(), 8);
+
+    ImGui::SeparatorText("Log");
+    for (auto it = begin; it != end; ++it)
+    {
+        double when = ((int64_t)it->Timestamp - (int64_t)s_Reader.FirstTimestamp()) / 1e6;
+        ImGui::TextWrapped("%7.3f | %.*s", when, (int)it->Text.size(), it->Text.c_str());
+    }
+}
+
+static void RenderQuery()
+{
+    bool running = s_QueryResult.valid();
+    if (running && s_QueryResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        s_Matches = s_QueryResult.get();
+        running = false;
+        GD_Log("Query finished: %zu matches, decoded %llu of %llu chunks\n", s_Matches.size(), s_QueryStats.DecodedChunks, s_QueryStats.Chunks);
+    }
+
+    ImGui::BeginDisabled(running);
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6f);
+    bool run = ImGui::InputTextWithHint("##query", "GUIDE for>=2s, sThumbLX>30000 !LEFT_THUMB", &s_QueryText, ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::SameLine();
+    run = ImGui::Button(running ? "Running..." : "Find") || run;
+    ImGui::EndDisabled();
+
+    if (run && !running)
+    {
+        GD::Record::Condition condition;
+        std::string error;
+        if (!GD::Record::ParseCondition(s_QueryText.c_str(), condition, error))
+        {
+            GD_Log("Invalid query: %s\n", error.c_str());
+        }
+        else
+        {
+            s_Matches.clear();
+            s_QueryResult = std::async(std::launch::async, [condition, path = s_Path]()
+                {
+                    return GD::Record::RunQuery(condition, { path }, 0, &s_QueryStats);
+                });
+        }
+    }
+
+    if (!s_Matches.empty() && ImGui::BeginListBox("##matches", ImVec2(-FLT_MIN, 5 * ImGui::GetTextLineHeightWithSpacing())))
+    {
+        uint64_t first = s_Reader.FirstTimestamp();
+        for (size_t n = 0; n < s_Matches.size(); ++n)
+        {
+            const auto& match = s_Matches[n];
+            char label[96];
+            snprintf(label, sizeof(label), "XUser %d: %.3f s - %.3f s (%.3f s)##%zu", match.Device,
+                (match.Start - first) / 1e6, (match.End - first) / 1e6, (match.End - match.Start) / 1e6, n);
+            if (ImGui::Selectable(label))
+            {
+                s_Position = (match.Start - first) / 1e6;
+                s_Playing = false;
+            }
+        }
+        ImGui::EndListBox();
+    }
+}
+
+static void RenderExport()
+{
+    bool running = s_ExportResult.valid();
+    if (running && s_ExportResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        std::string error = s_ExportResult.get();
+        running = false;
+        if (error.empty())
+            GD_Log("Exported %s\n", s_ExportPath.c_str());
+        else
+            GD_Log("Failed to export %s: %s\n", s_ExportPath.c_str(), error.c_str());
+    }
+
+    ImGui::BeginDisabled(running);
+    for (const char* format : s_ExportFormats)
+    {
+        ImGui::SameLine();
+        char label[32];
+        snprintf(label, sizeof(label), "Export %s", format);
+        if (ImGui::Button(label))
+        {
+            // Written next to the recording, on a thread because long recordings take a while
+            s_ExportPath = s_Path + format;
+            s_ExportResult = std::async(std::launch::async, [path = s_Path, output = s_ExportPath]()
+                {
+                    std::string error;
+                    GD::Record::Export(path.c_str(), output.c_str(), error);
+                    return error;
+                });
+        }
+    }
+    ImGui::EndDisabled();
+}
+
+// One lane of the timeline, each column is filled from the lowest to the highest value in it
+static void DrawLane(ImDrawList* draw, const ImRect& bb, int axis, float low, float high)
+{
+    draw->AddRectFilled(bb.Min, bb.Max, ImGui::GetColorU32(ImGuiCol_FrameBg));
+    int spans = 0;
+    for (const auto& column : s_Columns)
+        spans += !column.Empty();
+    if (spans)
+    {
+        float columnWidth = bb.GetWidth() / s_Columns.size();
+        float scale = bb.GetHeight() / (high - low);
+        ImU32 color = ImGui::GetColorU32(ImGuiCol_PlotLines);
+        draw->PrimReserve(spans * 6, spans * 4);
+        for (size_t n = 0; n < s_Columns.size(); ++n)
+        {
+            const auto& column = s_Columns[n];
+            if (column.Empty())
+                continue;
+            float x = bb.Min.x + n * columnWidth;
+            float top = ImFloor(bb.Max.y - (column.Max[axis] - low) * scale);
+            float bottom = ImMax(bb.Max.y - (column.Min[axis] - low) * scale, top + 1.f);
+            draw->PrimRect(ImVec2(x, ImClamp(top, bb.Min.y, bb.Max.y - 1.f)), ImVec2(x + ImMax(columnWidth, 1.f), ImClamp(bottom, bb.Min.y + 1.f, bb.Max.y)), color);
+        }
+    }
+    draw->AddText(bb.Min, ImGui::GetColorU32(ImGuiCol_TextDisabled), GD::AxisName(axis));
+}
+
+static void RenderTimeline(double duration)
+{
+    if (s_PyramidResult.valid())
+    {
+        if (s_PyramidResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ImGui::TextDisabled("Building the overview...");
+            return;
+        }
+        s_Pyramid = s_PyramidResult.get();
+        s_ColumnsDevice = -1;
+        GD_Log("Built the overview of %s\n", s_Path.c_str());
+    }
+    if (!s_Pyramid.DeviceCount() || duration <= 0.0)
+        return;
+
+    ImGui::SeparatorText("Timeline");
+    s_TimelineDevice = std::min(s_TimelineDevice, (int)s_Pyramid.DeviceCount() - 1);
+    char preview[32];
+    snprintf(preview, sizeof(preview), "XUser %d", s_Pyramid.Device(s_TimelineDevice).Slot);
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::BeginCombo("Device", preview))
+    {
+        for (int n = 0; n < (int)s_Pyramid.DeviceCount(); ++n)
+        {
+            char label[32];
+            snprintf(label, sizeof(label), "XUser %d##%d", s_Pyramid.Device(n).Slot, n);
+            if (ImGui::Selectable(label, n == s_TimelineDevice))
+                s_TimelineDevice = n;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Show all") || s_ViewEnd <= s_ViewStart)
+    {
+        s_ViewStart = 0.0;
+        s_ViewEnd = duration;
+    }
+
+    float laneHeight = 2 * ImGui::GetTextLineHeight();
+    float spacing = ImGui::GetStyle().ItemInnerSpacing.y;
+    ImVec2 pos = ImGui::GetCursorScreenPos();
+    ImVec2 size(ImGui::GetContentRegionAvail().x, GD::Axis_Count * (laneHeight + spacing));
+    if (size.x < 1.f)
+        return;
+    ImGui::InvisibleButton("##timeline", size);
+    ImGui::SetItemKeyOwner(ImGuiKey_MouseWheelY);
+
+    // Wheel zooms around the mouse, dragging pans, a click moves the position
+    double span = s_ViewEnd - s_ViewStart;
+    ImGuiIO& io = ImGui::GetIO();
+    double mouse = s_ViewStart + (io.MousePos.x - pos.x) / size.x * span;
+    if (ImGui::IsItemHovered() && io.MouseWheel != 0.f)
+    {
+        double zoomed = std::clamp(span * std::pow(0.8, io.MouseWheel), 1e-3, duration);
+        s_ViewStart = mouse - (mouse - s_ViewStart) * zoomed / span;
+        s_ViewEnd = s_ViewStart + zoomed;
+    }
+    if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left))
+    {
+        double shift = -io.MouseDelta.x / size.x * span;
+        s_ViewStart += shift;
+        s_ViewEnd += shift;
+    }
+    else if (ImGui::IsItemDeactivated() && !ImGui::IsMouseDragPastThreshold(ImGuiMouseButton_Left))
+    {
+        s_Position = std::clamp(mouse, 0.0, duration);
+        s_Playing = false;
+    }
+    span = s_ViewEnd - s_ViewStart;
+    s_ViewStart = std::clamp(s_ViewStart, 0.0, duration - span);
+    s_ViewEnd = s_ViewStart + span;
+
+    // The cost depends on the width, the pyramid level is picked to match it
+    uint64_t first = s_Reader.FirstTimestamp();
+    uint64_t start = first + (uint64_t)(s_ViewStart * 1e6);
+    uint64_t end = first + (uint64_t)(s_ViewEnd * 1e6);
+    if (start != s_ColumnsStart || end != s_ColumnsEnd || (int)size.x != (int)s_Columns.size() || s_TimelineDevice != s_ColumnsDevice)
+    {
+        GD::Record::Decimate(s_Reader, &s_Pyramid, s_Pyramid.Device(s_TimelineDevice).Id, start, end, (int)size.x, s_Columns, &s_ColumnsLevel);
+        s_ColumnsStart = start;
+        s_ColumnsEnd = end;
+        s_ColumnsDevice = s_TimelineDevice;
+    }
+
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    for (int axis = 0; axis < GD::Axis_Count; ++axis)
+    {
+        ImVec2 min(pos.x, pos.y + axis * (laneHeight + spacing));
+        bool trigger = axis == GD::Axis_LeftTrigger || axis == GD::Axis_RightTrigger;
+        DrawLane(draw, ImRect(min, ImVec2(min.x + size.x, min.y + laneHeight)), axis, trigger ? 0.f : -32768.f, trigger ? 255.f : 32767.f);
+    }
+    if (s_Position >= s_ViewStart && s_Position <= s_ViewEnd)
+    {
+        float x = pos.x + (float)((s_Position - s_ViewStart) / span) * size.x;
+        draw->AddLine(ImVec2(x, pos.y), ImVec2(x, pos.y + size.y), IM_COL32(255, 200, 60, 255));
+    }
+
+    if (s_ColumnsLevel >= 0)
+        ImGui::TextDisabled("%.3f s - %.3f s, overview level %d", s_ViewStart, s_ViewEnd, s_ColumnsLevel);
+    else
+        ImGui::TextDisabled("%.3f s - %.3f s, from the records", s_ViewStart, s_ViewEnd);
+}
+
+void GD::Replay::RenderFrame()
+{
+    if (!s_Visible)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(640, 560), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Replay", &s_Visible))
+    {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::InputText("##path", &s_Path);
+    ImGui::SameLine();
+    if (ImGui::Button("Open"))
+        OpenRecording();
+
+    if (s_Reader.IsOpen())
+    {
+        double duration = (s_Reader.LastTimestamp() - s_Reader.FirstTimestamp()) / 1e6;
+
+        if (ImGui::Button(s_Playing ? "Pause" : "Play"))
+            s_Playing = !s_Playing;
+        RenderExport();
+        ImGui::SameLine();
+        if (s_Playing)
+        {
+            s_Position += ImGui::GetIO().DeltaTime;
+            if (s_Position >= duration)
+            {
+                s_Position = duration;
+                s_Playing = false;
+            }
+        }
+        const double zero = 0.0;
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        ImGui::SliderScalar("##position", ImGuiDataType_Double, &s_Position, &zero, &duration, "%.3f s");
+
+        // Every seek goes through the chunk index, so this stays cheap for long recordings
+        if (s_Position != s_StatePosition)
+        {
+            s_Reader.Seek(s_Reader.FirstTimestamp() + (uint64_t)(s_Position * 1e6), s_State);
+            s_StatePosition = s_Position;
+        }
+
+        RenderTimeline(duration);
+        RenderQuery();
+
+        if (ImGui::BeginTable("devices", 7, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Device");
+            ImGui::TableSetupColumn("Packet");
+            ImGui::TableSetupColumn("Buttons");
+            ImGui::TableSetupColumn("Triggers");
+            ImGui::TableSetupColumn("Left thumb");
+            ImGui::TableSetupColumn("Right thumb");
+            ImGui::TableSetupColumn("V / P / PV");
+            ImGui::TableHeadersRow();
+
+            for (const auto& device : s_State)
+            {
+                const auto& state = device.State;
+                ImGui::TableNextColumn();
+                ImGui::Text("XUser %d", device.Info.Slot);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", state.PacketNumber);
+                ImGui::TableNextColumn();
+                ImGui::Text("%04X", state.Buttons);
+                ImGui::TableNextColumn();
+                ImGui::Text("%d, %d", state.LeftTrigger, state.RightTrigger);
+                ImGui::TableNextColumn();
+                ImGui::Text("%d, %d", state.ThumbLX, state.ThumbLY);
+                ImGui::TableNextColumn();
+                ImGui::Text("%d, %d", state.ThumbRX, state.ThumbRY);
+                ImGui::TableNextColumn();
+                ImGui::Text("%04X / %04X / %04X", device.Info.VendorId, device.Info.ProductId, device.Info.ProductVersion);
+            }
+            ImGui::EndTable();
+        }
+
+        RenderLog(s_Reader.FirstTimestamp() + (uint64_t)(s_Position * 1e6));
+    }
+
+    ImGui::End();
+}
+
+void GD::Replay::Show(const char* path)
+{
+    s_Visible = true;
+    if (path && *path && s_Path != path)
+    {
+        s_Path = path;
+        OpenRecording();
+    }
+}
+
+void GD::Replay::Shutdown()
+{
+    if (s_QueryResult.valid())
+        s_QueryResult.wait();
+    if (s_ExportResult.valid())
+        s_ExportResult.wait();
+    if (s_PyramidResult.valid())
+        s_PyramidResult.wait();
+    s_Reader.Close();
+    s_Pyramid.Begin(0);
+    s_Columns.clear();
+    s_State.clear();
+    s_Log.clear();
+}
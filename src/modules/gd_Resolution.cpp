@@ -0,0 +1,250 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Effective resolution and missing codes of the analog axes
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "modules/gd_Resolution.h"
+#include "gd_resolution.h"
+#include "imgui.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+constexpr size_t MaxResolutionDevices = 16;
+constexpr int MapColumns = 256;
+
+struct DeviceResolution
+{
+    GD::DeviceInfo Info;
+    bool Connected = false;
+    std::vector<GD::AxisResolution> Axes;
+};
+
+// Shared with the sampling thread
+static std::mutex s_Lock;
+static DeviceResolution s_Devices[MaxResolutionDevices];
+
+// Owned by the UI
+static bool s_Visible = false;
+static int s_Device = 0;
+static int s_Axis = GD::Axis_ThumbLX;
+
+
+static DeviceResolution* FindDevice(uint16_t id)
+{
+    for (auto& device : s_Devices)
+    {
+        if (device.Connected && device.Info.Id == id)
+            return &device;
+    }
+    return nullptr;
+}
+
+void GD::Resolution::DeviceConnected(const DeviceInfo& info)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceResolution* device = FindDevice(info.Id);
+    for (size_t n = 0; n < MaxResolutionDevices && !device; ++n)
+    {
+        if (!s_Devices[n].Connected)
+            device = &s_Devices[n];
+    }
+    if (!device)
+        return;
+
+    if (device->Axes.empty())
+    {
+        for (int axis = 0; axis < Axis_Count; ++axis)
+            device->Axes.emplace_back(axis);
+    }
+    for (auto& axis : device->Axes)
+        axis.Clear();
+    device->Info = info;
+    device->Connected = true;
+}
+
+void GD::Resolution::DeviceDisconnected(uint16_t id)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (DeviceResolution* device = FindDevice(id))
+        device->Connected = false;
+}
+
+void GD::Resolution::Submit(const Sample& sample)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceResolution* device = FindDevice(sample.Device);
+    if (!device)
+        return;
+    for (int axis = 0; axis < Axis_Count; ++axis)
+        device->Axes[axis].Add(GetAxis(sample, axis));
+}
+
+
+// One column per MapColumns-th of the codes: green when every code on the step grid showed up,
+// red when codes are missing, dark outside the range that was reached
+static void DrawCodeMap(const GD::AxisResolution& axis, const GD::ResolutionInfo& info)
+{
+    ImVec2 pos = ImGui::GetCursorScreenPos();
+    float width = ImGui::GetContentRegionAvail().x;
+    float height = ImGui::GetFrameHeight();
+    ImGui::Dummy(ImVec2(width, height));
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+
+    uint32_t perColumn = axis.CodeCount() / MapColumns;
+    uint32_t expected = std::max<uint32_t>(1, (uint32_t)(perColumn / std::max(info.Step, 1.0)));
+    float columnWidth = width / MapColumns;
+    for (int column = 0; column < MapColumns; ++column)
+    {
+        int32_t first = axis.Lowest() + column * (int32_t)perColumn;
+        int32_t last = first + (int32_t)perColumn - 1;
+        ImU32 color = IM_COL32(40, 40, 40, 255);
+        if (info.Codes && last >= info.Min && first <= info.Max)
+        {
+            float coverage = std::min(1.f, (float)axis.SeenInRange(column * perColumn, perColumn) / expected);
+            color = IM_COL32((int)(220 * (1 - coverage)), (int)(200 * coverage), 40, 255);
+        }
+        float x = pos.x + column * columnWidth;
+        draw->AddRectFilled(ImVec2(x, pos.y), ImVec2(x + std::max(columnWidth, 1.f), pos.y + height), color);
+    }
+}
+
+void GD::Resolution::RenderFrame()
+{
+    if (!s_Visible)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(640, 400), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Resolution", &s_Visible))
+    {
+        ImGui::End();
+        return;
+    }
+
+    // Copy the selected device, the sampling thread keeps going
+    GD::DeviceInfo devices[MaxResolutionDevices];
+    std::vector<GD::AxisResolution> axes;
+    int count = 0;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        for (const auto& device : s_Devices)
+        {
+            if (!device.Connected)
+                continue;
+            if (count == s_Device)
+                axes = device.Axes;
+            devices[count++] = device.Info;
+        }
+    }
+
+    if (!count)
+    {
+        ImGui::TextUnformatted("No devices connected");
+        ImGui::End();
+        return;
+    }
+    s_Device = std::min(s_Device, count - 1);
+
+    char preview[32];
+    snprintf(preview, sizeof(preview), "XUser %d", devices[s_Device].Slot);
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::BeginCombo("Device", preview))
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            char label[32];
+            snprintf(label, sizeof(label), "XUser %d##%d", devices[n].Slot, n);
+            if (ImGui::Selectable(label, n == s_Device))
+                s_Device = n;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        for (auto& device : s_Devices)
+        {
+            if (device.Connected && device.Info.Id == devices[s_Device].Id)
+            {
+                for (auto& axis : device.Axes)
+                    axis.Clear();
+            }
+        }
+    }
+    if (axes.empty())
+    {
+        ImGui::End();
+        return;
+    }
+
+    GD::ResolutionInfo infos[GD::Axis_Count];
+    for (int axis = 0; axis < GD::Axis_Count; ++axis)
+        infos[axis] = axes[axis].Analyze();
+
+    if (ImGui::BeginTable("axes", 7, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Axis");
+        ImGui::TableSetupColumn("Codes");
+        ImGui::TableSetupColumn("Range");
+        ImGui::TableSetupColumn("Step");
+        ImGui::TableSetupColumn("Effective bits");
+        ImGui::TableSetupColumn("Missing");
+        ImGui::TableSetupColumn("Largest gap");
+        ImGui::TableHeadersRow();
+        for (int axis = 0; axis < GD::Axis_Count; ++axis)
+        {
+            const auto& info = infos[axis];
+            ImGui::TableNextColumn();
+            if (ImGui::Selectable(GD::AxisName(axis), axis == s_Axis, ImGuiSelectableFlags_SpanAllColumns))
+                s_Axis = axis;
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", info.Codes);
+            if (info.Codes < 2)
+            {
+                ImGui::TableNextRow();
+                continue;
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%d .. %d", info.Min, info.Max);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", info.Step);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", info.EffectiveBits);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", info.MissingCodes);
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", info.LargestGap);
+        }
+        ImGui::EndTable();
+    }
+
+    const auto& axis = axes[s_Axis];
+    const auto& info = infos[s_Axis];
+    ImGui::SeparatorText(GD::AxisName(s_Axis));
+    ImGui::Text("Codes seen, %u per column", axis.CodeCount() / MapColumns);
+    DrawCodeMap(axis, info);
+
+    // Counts span many decades, so the bars are logarithmic
+    float steps[GD::AxisResolution::StepBuckets];
+    int buckets = axis.CodeCount() > 256 ? GD::AxisResolution::StepBuckets : 9;
+    for (int n = 0; n < buckets; ++n)
+        steps[n] = std::log10((float)axis.Steps()[n] + 1);
+    ImGui::Text("Moves between samples, bar n holds moves of 2^(n-1) .. 2^n - 1 (log scale)");
+    ImGui::PlotHistogram("##steps", steps, buckets, 0, nullptr, 0.f, FLT_MAX, ImVec2(-FLT_MIN, 100));
+
+    ImGui::End();
+}
+
+void GD::Resolution::Show()
+{
+    s_Visible = true;
+}
+
+void GD::Resolution::Shutdown()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (auto& device : s_Devices)
+        device = {};
+}
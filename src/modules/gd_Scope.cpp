@@ -0,0 +1,89 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Recent history of the axes, for the scope plots
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "modules/gd_Scope.h"
+#include "modules/gd_History.h"
+#include "imgui.h"
+#include <algorithm>
+
+constexpr float MaxLength = 10.f;                           // Seconds
+
+// Owned by the UI
+static float s_Length = 2.f;                                // Seconds
+static std::vector<int> s_From;
+static std::vector<int> s_To;
+
+
+bool GD::Scope::Decimate(uint16_t device, int columns, Envelope& envelope)
+{
+    if (s_Length <= 0.f || columns <= 0)
+        return false;
+
+    envelope.Columns = columns;
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        envelope.Min[axis].assign(columns, INT16_MAX);
+        envelope.Max[axis].assign(columns, INT16_MIN);
+    }
+
+    uint64_t now = GD::Now();
+    uint64_t span = (uint64_t)(s_Length * 1e6f);
+    uint64_t start = now - span;
+    auto column = [&](uint64_t timestamp)
+        {
+            return timestamp <= start ? 0 : (int)std::min<uint64_t>((timestamp - start) * columns / span, columns - 1);
+        };
+
+    GD::History::Read([&](const HistoryStore& store)
+        {
+            HistorySpan history;
+            if (!store.Span(device, start, history))
+                return;
+
+            // Each sample covers the columns up to the next one, so a value that was held shows as a flat line
+            size_t count = history.Size();
+            s_From.resize(count);
+            s_To.resize(count);
+            size_t n = 0;
+            for (int part = 0; part < 2; ++part)
+            {
+                for (size_t k = 0; k < history.Count[part]; ++k, ++n)
+                {
+                    s_From[n] = column(history.Timestamps[part][k]);
+                    if (n)
+                        s_To[n - 1] = s_From[n];
+                }
+            }
+            if (count)
+                s_To[count - 1] = column(now);
+
+            // Then one pass per axis over its own array, every sample and every column is visited once
+            for (int axis = 0; axis < Axis_Count; ++axis)
+            {
+                int16_t* mins = envelope.Min[axis].data();
+                int16_t* maxs = envelope.Max[axis].data();
+                n = 0;
+                for (int part = 0; part < 2; ++part)
+                {
+                    const int16_t* values = history.Axes[axis][part];
+                    for (size_t k = 0; k < history.Count[part]; ++k, ++n)
+                    {
+                        for (int c = s_From[n]; c <= s_To[n]; ++c)
+                        {
+                            mins[c] = std::min(mins[c], values[k]);
+                            maxs[c] = std::max(maxs[c], values[k]);
+                        }
+                    }
+                }
+            }
+        });
+    return true;
+}
+
+void GD::Scope::RenderOptions()
+{
+    ImGui::SetNextItemWidth(120);
+    ImGui::SliderFloat("Scope", &s_Length, 0.f, MaxLength, s_Length > 0.f ? "%.1f s" : "Off");
+}
@@ -0,0 +1,342 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Run test scripts against a live device or a recording
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "gd_log.h"
+#include "modules/gd_Scripts.h"
+#include "modules/gd_History.h"
+#include "modules/gd_Recorder.h"
+#include "record/gd_RecordScript.h"
+#include "imgui.h"
+#include "imgui_stdlib.h"
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+using GD::Record::ScriptMatcher;
+
+constexpr size_t MaxScriptDevices = 16;
+
+struct ScriptDevice
+{
+    GD::DeviceInfo Info;
+    bool Connected = false;
+};
+
+struct RecordingRun
+{
+    std::string Error;
+    std::vector<GD::Record::ScriptDeviceResult> Devices;
+};
+
+// Shared with the sampling thread
+static std::mutex s_Lock;
+static ScriptDevice s_Devices[MaxScriptDevices];
+static std::unique_ptr<ScriptMatcher> s_Matcher;            // The live run
+static uint16_t s_RunDevice = 0;
+
+// Owned by the UI
+static bool s_Visible = false;
+static std::string s_Path = "test.gdscript";
+static GD::Record::Script s_Script;
+static std::string s_Error;
+static int s_Device = 0;
+static std::string s_RecordingPath;
+static std::future<RecordingRun> s_RecordingResult;
+static RecordingRun s_Recording;
+static GD::Record::Script s_RecordingScript;                // The script that s_Recording ran
+
+
+static ScriptDevice* FindDevice(uint16_t id)
+{
+    for (auto& device : s_Devices)
+    {
+        if (device.Connected && device.Info.Id == id)
+            return &device;
+    }
+    return nullptr;
+}
+
+void GD::Scripts::DeviceConnected(const DeviceInfo& info)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    ScriptDevice* device = FindDevice(info.Id);
+    for (size_t n = 0; n < MaxScriptDevices && !device; ++n)
+    {
+        if (!s_Devices[n].Connected)
+            device = &s_Devices[n];
+    }
+    if (!device)
+        return;
+
+    device->Info = info;
+    device->Connected = true;
+}
+
+void GD::Scripts::DeviceDisconnected(uint16_t id)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (ScriptDevice* device = FindDevice(id))
+        device->Connected = false;
+    // A device that goes away fails what it was doing
+    if (s_Matcher && s_RunDevice == id && !s_Matcher->Done())
+        s_Matcher->Finish(GD::Now());
+}
+
+void GD::Scripts::Submit(const Sample& sample)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (s_Matcher && s_RunDevice == sample.Device && !s_Matcher->Done())
+        s_Matcher->Add(sample);
+}
+
+
+static void LoadScript()
+{
+    s_Error.clear();
+    GD::Record::Script script;
+    if (GD::Record::LoadScript(s_Path.c_str(), script, s_Error))
+        s_Script = script;
+    else
+        GD_Log("%s: %s\n", s_Path.c_str(), s_Error.c_str());
+}
+
+static void RenderResults(const GD::Record::Script& script, const std::vector<GD::Record::TestResult>& results, uint64_t now)
+{
+    if (!ImGui::BeginTable("results", 4, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+        return;
+
+    ImGui::TableSetupColumn("Test");
+    ImGui::TableSetupColumn("Result");
+    ImGui::TableSetupColumn("Time");
+    ImGui::TableSetupColumn("Margin", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableHeadersRow();
+    for (size_t n = 0; n < results.size() && n < script.Tests.size(); ++n)
+    {
+        const auto& result = results[n];
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(script.Tests[n].Name.c_str());
+        ImGui::TableNextColumn();
+        switch (result.State)
+        {
+        case GD::Record::Test_Pending:
+            ImGui::TextDisabled("pending");
+            break;
+        case GD::Record::Test_Running:
+            ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "running");
+            break;
+        case GD::Record::Test_Passed:
+            ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(40, 120, 40, 255));
+            ImGui::TextUnformatted("PASS");
+            break;
+        case GD::Record::Test_Failed:
+            ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(160, 40, 40, 255));
+            ImGui::TextUnformatted("FAIL");
+            break;
+        }
+        ImGui::TableNextColumn();
+        if (result.State == GD::Record::Test_Running)
+            ImGui::Text("%.3f s", now > result.Start ? (now - result.Start) / 1e6 : 0.0);
+        else if (result.State != GD::Record::Test_Pending)
+            ImGui::Text("%.3f s", (result.End - result.Start) / 1e6);
+        ImGui::TableNextColumn();
+        int64_t margin;
+        if (result.State == GD::Record::Test_Failed)
+            ImGui::TextUnformatted(result.Message.c_str());
+        else if (result.TightestMargin(script.Tests[n], margin))
+            ImGui::Text("%.1f ms", margin / 1e3);
+    }
+    ImGui::EndTable();
+}
+
+static void RenderLive(const GD::DeviceInfo* devices, int count)
+{
+    ImGui::SeparatorText("Live");
+    if (!count)
+    {
+        ImGui::TextUnformatted("No devices connected");
+        return;
+    }
+    s_Device = std::min(s_Device, count - 1);
+
+    char preview[32];
+    snprintf(preview, sizeof(preview), "XUser %d", devices[s_Device].Slot);
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::BeginCombo("Device", preview))
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            char label[32];
+            snprintf(label, sizeof(label), "XUser %d##%d", devices[n].Slot, n);
+            if (ImGui::Selectable(label, n == s_Device))
+                s_Device = n;
+        }
+        ImGui::EndCombo();
+    }
+
+    // Copy the run, the sampling thread keeps going
+    std::unique_ptr<ScriptMatcher> run;
+    uint64_t now = GD::Now();
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        if (s_Matcher)
+        {
+            s_Matcher->Advance(now);
+            run = std::make_unique<ScriptMatcher>(*s_Matcher);
+        }
+    }
+
+    ImGui::SameLine();
+    bool running = run && !run->Done();
+    ImGui::BeginDisabled(s_Script.Tests.empty());
+    if (ImGui::Button(running ? "Stop" : "Start"))
+    {
+        // The first test starts now, from the state the device is in
+        GD::Sample state;
+        bool known = false;
+        if (!running)
+            GD::History::Read([&](const GD::HistoryStore& store) { known = store.Latest(devices[s_Device].Id, state); });
+
+        std::unique_lock<std::mutex> lock(s_Lock);
+        if (running)
+        {
+            s_Matcher->Finish(now);
+        }
+        else
+        {
+            s_Matcher = std::make_unique<ScriptMatcher>(s_Script);
+            s_RunDevice = devices[s_Device].Id;
+            if (known)
+            {
+                state.Timestamp = now;
+                s_Matcher->Add(state);
+            }
+        }
+    }
+    ImGui::EndDisabled();
+    if (!run)
+        return;
+
+    // Tell the operator what to do
+    ImGui::SameLine();
+    if (running)
+    {
+        const auto& test = run->GetScript().Tests[run->Test()];
+        ImGui::Text("%s: %s", test.Name.c_str(), test.Steps[run->Step()].Text.c_str());
+    }
+    else
+    {
+        size_t failed = run->Failed();
+        if (failed)
+            ImGui::TextColored(ImVec4(1.f, 0.3f, 0.3f, 1.f), "%zu of %zu tests failed", failed, run->Results().size());
+        else
+            ImGui::TextColored(ImVec4(0.3f, 1.f, 0.3f, 1.f), "All %zu tests passed", run->Results().size());
+    }
+    RenderResults(run->GetScript(), run->Results(), now);
+}
+
+static void RenderRecording()
+{
+    ImGui::SeparatorText("Recording");
+    if (s_RecordingPath.empty() && GD::Recorder::LastPath())
+        s_RecordingPath = GD::Recorder::LastPath();
+
+    bool running = s_RecordingResult.valid();
+    if (running && s_RecordingResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        s_Recording = s_RecordingResult.get();
+        running = false;
+    }
+
+    ImGui::InputText("##recording", &s_RecordingPath);
+    ImGui::SameLine();
+    ImGui::BeginDisabled(running || s_Script.Tests.empty());
+    if (ImGui::Button("Run"))
+    {
+        s_RecordingScript = s_Script;
+        s_RecordingResult = std::async(std::launch::async, [script = s_Script, path = s_RecordingPath]()
+            {
+                RecordingRun run;
+                GD::Record::RunScript(script, path.c_str(), run.Devices, run.Error);
+                return run;
+            });
+    }
+    ImGui::EndDisabled();
+
+    if (running)
+        ImGui::TextUnformatted("Running...");
+    else if (!s_Recording.Error.empty())
+        ImGui::TextColored(ImVec4(1.f, 0.3f, 0.3f, 1.f), "%s", s_Recording.Error.c_str());
+    for (const auto& device : s_Recording.Devices)
+    {
+        ImGui::PushID(device.Info.Id);
+        ImGui::Text("Device %u, %04X / %04X / %04X", device.Info.Id, device.Info.VendorId, device.Info.ProductId, device.Info.ProductVersion);
+        RenderResults(s_RecordingScript, device.Tests, 0);
+        ImGui::PopID();
+    }
+}
+
+void GD::Scripts::RenderFrame()
+{
+    if (!s_Visible)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(640, 560), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Test script", &s_Visible))
+    {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::InputText("##path", &s_Path);
+    ImGui::SameLine();
+    if (ImGui::Button("Load"))
+        LoadScript();
+    ImGui::SameLine();
+    ImGui::TextDisabled("(?)");
+    ImGui::SetItemTooltip(
+        "test A then RT\n"
+        "    A\n"
+        "    RT>200 within 200ms\n"
+        "    !A RT<30 within 1s\n"
+        "test Hold guide\n"
+        "    GUIDE for>=2s within 5s\n\n"
+        "Every step is a condition like in the replay query, and has to start within the time after the step before it.");
+    if (!s_Error.empty())
+        ImGui::TextColored(ImVec4(1.f, 0.3f, 0.3f, 1.f), "%s", s_Error.c_str());
+    else if (!s_Script.Tests.empty())
+        ImGui::Text("%zu tests", s_Script.Tests.size());
+
+    GD::DeviceInfo devices[MaxScriptDevices];
+    int count = 0;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        for (const auto& device : s_Devices)
+        {
+            if (device.Connected)
+                devices[count++] = device.Info;
+        }
+    }
+    RenderLive(devices, count);
+    RenderRecording();
+
+    ImGui::End();
+}
+
+void GD::Scripts::Show()
+{
+    s_Visible = true;
+}
+
+void GD::Scripts::Shutdown()
+{
+    if (s_RecordingResult.valid())
+        s_RecordingResult.wait();
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_Matcher.reset();
+    for (auto& device : s_Devices)
+        device = {};
+}
@@ -0,0 +1,355 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Frequency spectrum of the axis noise
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "modules/gd_Spectrum.h"
+#include "gd_fft.h"
+#include "imgui.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// XInput only reports changes, so the samples are held on a regular grid before they are transformed
+constexpr uint64_t GridStep = 1000;                         // Microseconds, 1 kHz
+constexpr double SampleRate = 1e6 / GridStep;
+constexpr size_t WindowSize = 512;
+constexpr size_t HopSize = 128;                             // A new transform every HopSize samples, the windows overlap by 75%
+constexpr size_t Bins = WindowSize / 2 + 1;
+constexpr size_t MaxSpectrumDevices = 16;
+constexpr int MaxPeaks = 4;
+constexpr float PeakThreshold = 10.f;                       // dB above the median of the bins around it
+constexpr size_t FloorBins = 16;
+
+struct DeviceSpectrum
+{
+    GD::DeviceInfo Info;
+    bool Connected = false;
+    bool HasLast = false;
+    GD::Sample Last;
+    uint64_t NextGrid = 0;
+    uint64_t Head = 0;                                      // Grid values written, History is a ring of WindowSize
+    size_t SinceTransform = 0;
+    uint32_t Transforms = 0;
+    std::unique_ptr<float[]> History;                       // [Axis_Count][WindowSize]
+    std::unique_ptr<double[]> Power;                        // [Axis_Count][Bins], averaged over the transforms
+};
+
+struct Peak
+{
+    float Frequency;
+    float Level;
+    float AboveFloor;
+};
+
+// Everything up to s_Buffer is shared with the sampling thread
+static std::mutex s_Lock;
+static DeviceSpectrum s_Devices[MaxSpectrumDevices];
+static float s_Averaging = 0.1f;                            // Weight of a new transform in the average
+static std::unique_ptr<GD::Fft> s_Fft;
+static double s_Window[WindowSize];
+static double s_WindowGain = 0.0;
+static std::vector<std::complex<double>> s_Buffer;
+
+// Owned by the UI
+static bool s_Visible = false;
+static int s_Device = 0;
+static int s_Axis = GD::Axis_ThumbLX;
+static float s_Decibels[Bins];
+static Peak s_Peaks[MaxPeaks];
+static int s_PeakCount = 0;
+static float s_Floor = 0.f;
+
+
+static DeviceSpectrum* FindDevice(uint16_t id)
+{
+    for (auto& device : s_Devices)
+    {
+        if (device.Connected && device.Info.Id == id)
+            return &device;
+    }
+    return nullptr;
+}
+
+// Called with s_Lock held, transforms the last WindowSize values of every axis
+static void Transform(DeviceSpectrum& device)
+{
+    if (!s_Fft)
+    {
+        const double pi = 3.14159265358979323846;
+        s_Fft = std::make_unique<GD::Fft>(WindowSize);
+        s_Buffer.resize(WindowSize);
+        s_WindowGain = 0.0;
+        for (size_t n = 0; n < WindowSize; ++n)
+        {
+            s_Window[n] = 0.5 - 0.5 * std::cos(2 * pi * (double)n / WindowSize);     // Hann
+            s_WindowGain += s_Window[n];
+        }
+    }
+
+    size_t start = (size_t)(device.Head & (WindowSize - 1));
+    double weight = device.Transforms ? s_Averaging : 1.0;
+    for (int axis = 0; axis < GD::Axis_Count; ++axis)
+    {
+        const float* history = device.History.get() + axis * WindowSize;
+        double mean = 0.0;
+        for (size_t n = 0; n < WindowSize; ++n)
+            mean += history[n];
+        mean /= WindowSize;
+
+        // Oldest value first, without the rest position so only the noise is left
+        for (size_t n = 0; n < WindowSize; ++n)
+            s_Buffer[n] = (history[(start + n) & (WindowSize - 1)] - mean) * s_Window[n];
+        s_Fft->Forward(s_Buffer.data());
+
+        // Amplitude relative to the full range of the axis, so a full scale sine is 0 dB
+        double range = axis <= GD::Axis_RightTrigger ? 255.0 : 32768.0;
+        double scale = 2.0 / (s_WindowGain * range);
+        double* power = device.Power.get() + axis * Bins;
+        for (size_t bin = 0; bin < Bins; ++bin)
+        {
+            double value = std::norm(s_Buffer[bin] * scale);
+            power[bin] += (value - power[bin]) * weight;
+        }
+    }
+    device.Transforms++;
+}
+
+void GD::Spectrum::DeviceConnected(const DeviceInfo& info)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceSpectrum* device = FindDevice(info.Id);
+    for (size_t n = 0; n < MaxSpectrumDevices && !device; ++n)
+    {
+        if (!s_Devices[n].Connected)
+            device = &s_Devices[n];
+    }
+    if (!device)
+        return;
+
+    if (!device->History)
+    {
+        device->History.reset(new float[GD::Axis_Count * WindowSize]);
+        device->Power.reset(new double[GD::Axis_Count * Bins]);
+    }
+    std::fill_n(device->Power.get(), GD::Axis_Count * Bins, 0.0);
+    device->Info = info;
+    device->Connected = true;
+    device->HasLast = false;
+    device->Head = 0;
+    device->SinceTransform = 0;
+    device->Transforms = 0;
+}
+
+void GD::Spectrum::DeviceDisconnected(uint16_t id)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (DeviceSpectrum* device = FindDevice(id))
+        device->Connected = false;
+}
+
+void GD::Spectrum::Submit(const Sample& sample)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceSpectrum* device = FindDevice(sample.Device);
+    if (!device)
+        return;
+
+    if (!device->HasLast)
+    {
+        device->NextGrid = sample.Timestamp;
+    }
+    else
+    {
+        // After a long quiet period only the last window matters, and it holds the same value everywhere
+        uint64_t quiet = GridStep * WindowSize;
+        if (sample.Timestamp > device->NextGrid + quiet)
+            device->NextGrid += (sample.Timestamp - device->NextGrid - quiet) / GridStep * GridStep;
+
+        for (; device->NextGrid < sample.Timestamp; device->NextGrid += GridStep)
+        {
+            size_t slot = (size_t)(device->Head++ & (WindowSize - 1));
+            for (int axis = 0; axis < GD::Axis_Count; ++axis)
+                device->History[axis * WindowSize + slot] = (float)GD::GetAxis(device->Last, axis);
+            if (++device->SinceTransform >= HopSize && device->Head >= WindowSize)
+            {
+                Transform(*device);
+                device->SinceTransform = 0;
+            }
+        }
+    }
+    device->Last = sample;
+    device->HasLast = true;
+}
+
+
+static float Median(const float* values, size_t count)
+{
+    float sorted[Bins];
+    std::copy(values, values + count, sorted);
+    std::nth_element(sorted, sorted + count / 2, sorted + count);
+    return sorted[count / 2];
+}
+
+// Local maxima that stand out from the median level around them, with the frequency interpolated between the bins.
+// Holding the reports makes the noise itself fall off towards the report rate, so one floor for everything does not work.
+static void FindPeaks()
+{
+    s_Floor = Median(s_Decibels + 1, Bins - 1);
+
+    s_PeakCount = 0;
+    for (size_t bin = 2; bin + 1 < Bins; ++bin)
+    {
+        float left = s_Decibels[bin - 1], center = s_Decibels[bin], right = s_Decibels[bin + 1];
+        if (center <= left || center < right)
+            continue;
+        size_t first = bin > FloorBins + 1 ? bin - FloorBins : 1;
+        size_t last = std::min(Bins, bin + FloorBins + 1);
+        float floor = Median(s_Decibels + first, last - first);
+        if (center < floor + PeakThreshold)
+            continue;
+
+        float curve = left - 2 * center + right;
+        float offset = curve < 0 ? 0.5f * (left - right) / curve : 0.f;
+        Peak peak{ (float)((bin + offset) * SampleRate / WindowSize), center, center - floor };
+
+        // Keep the highest peaks, sorted from high to low
+        int at = s_PeakCount;
+        while (at > 0 && s_Peaks[at - 1].Level < peak.Level)
+            at--;
+        if (at >= MaxPeaks)
+            continue;
+        for (int n = std::min(s_PeakCount, MaxPeaks - 1); n > at; --n)
+            s_Peaks[n] = s_Peaks[n - 1];
+        s_Peaks[at] = peak;
+        s_PeakCount = std::min(s_PeakCount + 1, MaxPeaks);
+    }
+}
+
+void GD::Spectrum::RenderFrame()
+{
+    if (!s_Visible)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(640, 360), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Noise spectrum", &s_Visible))
+    {
+        ImGui::End();
+        return;
+    }
+
+    // Copy what is needed, the sampling thread keeps going
+    GD::DeviceInfo devices[MaxSpectrumDevices];
+    int count = 0;
+    uint32_t transforms = 0;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        for (const auto& device : s_Devices)
+        {
+            if (!device.Connected)
+                continue;
+            if (count == s_Device)
+            {
+                transforms = device.Transforms;
+                const double* power = device.Power.get() + s_Axis * Bins;
+                for (size_t bin = 0; bin < Bins; ++bin)
+                    s_Decibels[bin] = (float)(10.0 * std::log10(std::max(power[bin], 1e-14)));
+            }
+            devices[count++] = device.Info;
+        }
+    }
+
+    if (!count)
+    {
+        ImGui::TextUnformatted("No devices connected");
+        ImGui::End();
+        return;
+    }
+    s_Device = std::min(s_Device, count - 1);
+
+    char preview[32];
+    snprintf(preview, sizeof(preview), "XUser %d", devices[s_Device].Slot);
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::BeginCombo("Device", preview))
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            char label[32];
+            snprintf(label, sizeof(label), "XUser %d##%d", devices[n].Slot, n);
+            if (ImGui::Selectable(label, n == s_Device))
+                s_Device = n;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(140);
+    ImGui::Combo("Axis", &s_Axis, [](void*, int idx) { return GD::AxisName(idx); }, nullptr, GD::Axis_Count);
+    ImGui::SameLine();
+    float averaging = s_Averaging;
+    ImGui::SetNextItemWidth(120);
+    if (ImGui::SliderFloat("Averaging", &averaging, 0.01f, 1.f, "%.2f", ImGuiSliderFlags_Logarithmic))
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        s_Averaging = averaging;
+    }
+
+    if (!transforms)
+    {
+        ImGui::TextUnformatted("Collecting samples...");
+        ImGui::End();
+        return;
+    }
+
+    FindPeaks();
+    ImGui::Text("%.0f Hz sampling, %.2f Hz per bin, %u transforms, floor %.1f dB", SampleRate, SampleRate / WindowSize, transforms, s_Floor);
+
+    ImVec2 pos = ImGui::GetCursorScreenPos();
+    ImGui::PlotLines("##spectrum", s_Decibels, (int)Bins, 0, nullptr, -140.f, 0.f, ImVec2(-FLT_MIN, 160));
+    ImVec2 max = ImGui::GetItemRectMax();
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    for (int n = 0; n < s_PeakCount; ++n)
+    {
+        float x = pos.x + (max.x - pos.x) * (float)(s_Peaks[n].Frequency / (SampleRate / 2));
+        draw->AddLine(ImVec2(x, pos.y), ImVec2(x, max.y), IM_COL32(255, 64, 64, 255));
+        char label[32];
+        snprintf(label, sizeof(label), "%.1f Hz", s_Peaks[n].Frequency);
+        draw->AddText(ImVec2(x + 2, pos.y + n * ImGui::GetTextLineHeight()), IM_COL32(255, 64, 64, 255), label);
+    }
+
+    if (ImGui::BeginTable("peaks", 3, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Frequency");
+        ImGui::TableSetupColumn("Level");
+        ImGui::TableSetupColumn("Above floor");
+        ImGui::TableHeadersRow();
+        for (int n = 0; n < s_PeakCount; ++n)
+        {
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f Hz", s_Peaks[n].Frequency);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f dB", s_Peaks[n].Level);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f dB", s_Peaks[n].AboveFloor);
+        }
+        ImGui::EndTable();
+    }
+    if (!s_PeakCount)
+        ImGui::TextUnformatted("No periodic noise found");
+
+    ImGui::End();
+}
+
+void GD::Spectrum::Show()
+{
+    s_Visible = true;
+}
+
+void GD::Spectrum::Shutdown()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (auto& device : s_Devices)
+        device = {};
+    s_Fft.reset();
+}
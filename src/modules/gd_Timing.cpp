@@ -0,0 +1,228 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Quantiles of sample intervals, enumeration and frame times
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "modules/gd_Timing.h"
+#include "gd_digest.h"
+#include "imgui.h"
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <string>
+
+constexpr size_t MaxTimingDevices = 16;
+
+struct DeviceTiming
+{
+    GD::DeviceInfo Info;
+    bool Used = false;
+    bool Connected = false;
+    uint64_t LastTimestamp = 0;
+    GD::Digest Intervals;
+};
+
+// Shared with the sampling thread
+static std::mutex s_Lock;
+static DeviceTiming s_Devices[MaxTimingDevices];
+static GD::Digest s_Enumerations;
+static GD::Digest s_Frames;
+
+// Owned by the UI
+static bool s_Visible = false;
+
+static const double s_Quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+static const char* s_QuantileNames[] = { "p50", "p90", "p99", "p99.9" };
+
+
+static DeviceTiming* FindDevice(uint16_t id)
+{
+    for (auto& device : s_Devices)
+    {
+        if (device.Connected && device.Info.Id == id)
+            return &device;
+    }
+    return nullptr;
+}
+
+void GD::Timing::DeviceConnected(const DeviceInfo& info)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    // A device that comes back in the same slot keeps its history, so a long session survives a reconnect
+    DeviceTiming* device = nullptr;
+    for (auto& existing : s_Devices)
+    {
+        if (existing.Used && existing.Info.Id == info.Id && existing.Info.VendorId == info.VendorId && existing.Info.ProductId == info.ProductId)
+            device = &existing;
+    }
+    for (size_t n = 0; n < MaxTimingDevices && !device; ++n)
+    {
+        if (!s_Devices[n].Used)
+            device = &s_Devices[n];
+    }
+    for (size_t n = 0; n < MaxTimingDevices && !device; ++n)
+    {
+        if (!s_Devices[n].Connected)
+        {
+            device = &s_Devices[n];
+            device->Intervals.Clear();
+        }
+    }
+    if (!device)
+        return;
+
+    device->Info = info;
+    device->Used = true;
+    device->Connected = true;
+    device->LastTimestamp = 0;
+}
+
+void GD::Timing::DeviceDisconnected(uint16_t id)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (DeviceTiming* device = FindDevice(id))
+        device->Connected = false;
+}
+
+void GD::Timing::Submit(const Sample& sample)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    DeviceTiming* device = FindDevice(sample.Device);
+    if (!device)
+        return;
+    if (device->LastTimestamp && sample.Timestamp > device->LastTimestamp)
+        device->Intervals.Add((double)(sample.Timestamp - device->LastTimestamp));
+    device->LastTimestamp = sample.Timestamp;
+}
+
+void GD::Timing::AddEnumeration(uint64_t duration)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_Enumerations.Add((double)duration);
+}
+
+void GD::Timing::AddFrame(uint64_t duration)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    s_Frames.Add((double)duration);
+}
+
+double GD::Timing::IntervalQuantile(uint16_t id, double q)
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    if (DeviceTiming* device = FindDevice(id))
+        return device->Intervals.Quantile(q);
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+
+struct TimingRow
+{
+    char Name[32];
+    GD::Digest Values;
+};
+
+static void AppendCsv(std::string& csv, const TimingRow& row)
+{
+    char line[256];
+    int length = snprintf(line, sizeof(line), "%s,%.0f", row.Name, row.Values.Count());
+    for (double q : s_Quantiles)
+        length += snprintf(line + length, sizeof(line) - length, ",%.1f", row.Values.Quantile(q));
+    snprintf(line + length, sizeof(line) - length, ",%.1f\n", row.Values.Max());
+    csv += line;
+}
+
+void GD::Timing::RenderFrame()
+{
+    if (!s_Visible)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(560, 240), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Timing", &s_Visible))
+    {
+        ImGui::End();
+        return;
+    }
+
+    // Copy the digests, the queries sort their buffers and the sampling thread keeps going
+    TimingRow rows[MaxTimingDevices + 2];
+    int count = 0;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        snprintf(rows[count].Name, sizeof(rows[count].Name), "Frame time");
+        rows[count++].Values = s_Frames;
+        snprintf(rows[count].Name, sizeof(rows[count].Name), "Enumeration");
+        rows[count++].Values = s_Enumerations;
+        for (const auto& device : s_Devices)
+        {
+            if (!device.Used)
+                continue;
+            snprintf(rows[count].Name, sizeof(rows[count].Name), "XUser %d interval%s", device.Info.Slot, device.Connected ? "" : " (gone)");
+            rows[count++].Values = device.Intervals;
+        }
+    }
+
+    if (ImGui::Button("Copy as CSV"))
+    {
+        std::string csv = "name,count,p50_us,p90_us,p99_us,p99.9_us,max_us\n";
+        for (int n = 0; n < count; ++n)
+            AppendCsv(csv, rows[n]);
+        ImGui::SetClipboardText(csv.c_str());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        s_Frames.Clear();
+        s_Enumerations.Clear();
+        for (auto& device : s_Devices)
+            device.Intervals.Clear();
+    }
+
+    if (ImGui::BeginTable("timing", 7, ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Milliseconds");
+        ImGui::TableSetupColumn("Count");
+        for (const char* name : s_QuantileNames)
+            ImGui::TableSetupColumn(name);
+        ImGui::TableSetupColumn("Max");
+        ImGui::TableHeadersRow();
+        for (int n = 0; n < count; ++n)
+        {
+            const auto& row = rows[n];
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(row.Name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", row.Values.Count());
+            if (!row.Values.Count())
+            {
+                ImGui::TableNextRow();
+                continue;
+            }
+            for (double q : s_Quantiles)
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", row.Values.Quantile(q) / 1000);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", row.Values.Max() / 1000);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void GD::Timing::Show()
+{
+    s_Visible = true;
+}
+
+void GD::Timing::Shutdown()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (auto& device : s_Devices)
+        device = {};
+    s_Enumerations.Clear();
+    s_Frames.Clear();
+}
@@ -0,0 +1,189 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     The recent path of the sticks
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "modules/gd_Trail.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+using GD::Trail::Slots;
+
+constexpr int Sticks = 2;
+constexpr size_t Capacity = 4096;                           // Positions per stick, only changes are stored
+constexpr int MaxVertices = 256;                            // Per trail, after decimation
+constexpr int FadeSteps = 4;
+
+struct TrailPoint
+{
+    uint64_t Timestamp;
+    int16_t X;
+    int16_t Y;
+};
+
+struct TrailRing
+{
+    TrailPoint Points[Capacity];
+    uint64_t Head = 0;                                      // Points written, the ring holds the last Capacity of them
+};
+
+// Shared with the sampling thread
+static std::mutex s_Lock;
+static TrailRing s_Rings[Slots][Sticks];
+static bool s_Active[Slots]{};
+
+// Owned by the UI
+static float s_Length = 1.f;                                // Seconds
+static std::vector<ImVec2> s_Points;
+static std::vector<ImVec2> s_Decimated;
+static std::vector<uint8_t> s_Keep;
+static std::vector<std::pair<int, int>> s_Stack;
+
+
+void GD::Trail::Update(const Sample (&samples)[Slots], const bool (&active)[Slots])
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (int slot = 0; slot < Slots; ++slot)
+    {
+        if (active[slot] && !s_Active[slot])
+        {
+            for (auto& ring : s_Rings[slot])
+                ring.Head = 0;
+        }
+        s_Active[slot] = active[slot];
+        if (!active[slot])
+            continue;
+
+        const Sample& sample = samples[slot];
+        int16_t xs[Sticks] = { sample.ThumbLX, sample.ThumbRX };
+        int16_t ys[Sticks] = { sample.ThumbLY, sample.ThumbRY };
+        for (int stick = 0; stick < Sticks; ++stick)
+        {
+            TrailRing& ring = s_Rings[slot][stick];
+            const TrailPoint& last = ring.Points[(ring.Head - 1) & (Capacity - 1)];
+            if (ring.Head && last.X == xs[stick] && last.Y == ys[stick])
+                continue;
+            ring.Points[ring.Head++ & (Capacity - 1)] = { sample.Timestamp, xs[stick], ys[stick] };
+        }
+    }
+}
+
+// Ramer-Douglas-Peucker without recursion: keeps the points that stick out more than epsilon pixels
+// from the line between the points that are kept around them, so the corners of a motion survive
+static void Simplify(const std::vector<ImVec2>& points, float epsilon, std::vector<ImVec2>& output)
+{
+    int count = (int)points.size();
+    s_Keep.assign(count, 0);
+    s_Keep[0] = s_Keep[count - 1] = 1;
+    s_Stack.clear();
+    s_Stack.push_back({ 0, count - 1 });
+    while (!s_Stack.empty())
+    {
+        auto [first, last] = s_Stack.back();
+        s_Stack.pop_back();
+        ImVec2 a = points[first], b = points[last];
+        float dx = b.x - a.x, dy = b.y - a.y;
+        float length = std::sqrt(dx * dx + dy * dy);
+        float furthest = 0.f;
+        int index = -1;
+        for (int n = first + 1; n < last; ++n)
+        {
+            float px = points[n].x - a.x, py = points[n].y - a.y;
+            float distance = length > 0.f ? std::fabs(px * dy - py * dx) / length : std::sqrt(px * px + py * py);
+            if (distance > furthest)
+            {
+                furthest = distance;
+                index = n;
+            }
+        }
+        if (index >= 0 && furthest > epsilon)
+        {
+            s_Keep[index] = 1;
+            s_Stack.push_back({ first, index });
+            s_Stack.push_back({ index, last });
+        }
+    }
+
+    output.clear();
+    for (int n = 0; n < count; ++n)
+    {
+        if (s_Keep[n])
+            output.push_back(points[n]);
+    }
+}
+
+void GD::Trail::Draw(int slot, int stick, const ImVec2& min, float size)
+{
+    if (s_Length <= 0.f)
+        return;
+
+    // Newest first while copying, then turned around; positions that land on the same pixel are dropped right away
+    s_Points.clear();
+    uint64_t since = GD::Now() - (uint64_t)(s_Length * 1e6f);
+    float scale = size / 65536.f;
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        const TrailRing& ring = s_Rings[slot][stick];
+        uint64_t oldest = ring.Head > Capacity ? ring.Head - Capacity : 0;
+        ImVec2 previous(-1.f, -1.f);
+        for (uint64_t n = ring.Head; n > oldest; --n)
+        {
+            const TrailPoint& point = ring.Points[(n - 1) & (Capacity - 1)];
+            ImVec2 pos(std::floor(min.x + (point.X + 32768.f) * scale) + 0.5f, std::floor(min.y + (32767.f - point.Y) * scale) + 0.5f);
+            if (pos.x != previous.x || pos.y != previous.y)
+                s_Points.push_back(pos);
+            previous = pos;
+            if (point.Timestamp < since)
+                break;
+        }
+    }
+    if (s_Points.empty())
+        return;
+    std::reverse(s_Points.begin(), s_Points.end());
+
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    ImU32 color = IM_COL32(120, 200, 255, 255);
+    draw->AddCircleFilled(s_Points.back(), 2.5f, color);
+    if (s_Points.size() < 2)
+        return;
+
+    // A busy trail gets a coarser epsilon until it fits the budget
+    float epsilon = 0.5f;
+    Simplify(s_Points, epsilon, s_Decimated);
+    while ((int)s_Decimated.size() > MaxVertices)
+    {
+        epsilon *= 2.f;
+        Simplify(s_Points, epsilon, s_Decimated);
+    }
+
+    // Older parts fade out, each part is one polyline that shares its first vertex with the previous one
+    int count = (int)s_Decimated.size();
+    for (int part = 0; part < FadeSteps; ++part)
+    {
+        int first = part * (count - 1) / FadeSteps;
+        int last = (part + 1) * (count - 1) / FadeSteps;
+        if (last <= first)
+            continue;
+        ImU32 faded = (color & ~IM_COL32_A_MASK) | ((ImU32)(255 * (part + 1) / FadeSteps) << IM_COL32_A_SHIFT);
+        draw->AddPolyline(&s_Decimated[first], last - first + 1, faded, ImDrawFlags_None, 1.5f);
+    }
+}
+
+void GD::Trail::RenderOptions()
+{
+    ImGui::SetNextItemWidth(120);
+    ImGui::SliderFloat("Trail", &s_Length, 0.f, 4.f, s_Length > 0.f ? "%.2f s" : "Off");
+}
+
+void GD::Trail::Shutdown()
+{
+    std::unique_lock<std::mutex> lock(s_Lock);
+    for (auto& rings : s_Rings)
+    {
+        for (auto& ring : rings)
+            ring.Head = 0;
+    }
+    std::fill(s_Active, s_Active + Slots, false);
+}
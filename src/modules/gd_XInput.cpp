@@ -5,12 +5,35 @@
 
 #include "gd_win32.h"
 #include "gd_log.h"
+#include "gd_motion.h"
 #include "fonts/cf_xbox_one.h"
 #include "modules/gd_XInput.h"
+#include "modules/gd_AxisStats.h"
+#include "modules/gd_Bench.h"
+#include "modules/gd_Buttons.h"
+#include "modules/gd_Capture.h"
+#include "modules/gd_Crosstalk.h"
+#include "modules/gd_FlightRecorder.h"
+#include "modules/gd_Heatmap.h"
+#include "modules/gd_History.h"
+#include "modules/gd_Motions.h"
+#include "modules/gd_Processing.h"
+#include "modules/gd_Recorder.h"
+#include "modules/gd_Replay.h"
+#include "modules/gd_Resolution.h"
+#include "modules/gd_Scope.h"
+#include "modules/gd_Scripts.h"
+#include "modules/gd_Spectrum.h"
+#include "modules/gd_Timing.h"
+#include "modules/gd_Trail.h"
 #include <Xinput.h>
+#include <timeapi.h>
 #include "imgui.h"
 #include "imgui_internal.h"
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <thread>
 
 using std::string;
 
@@ -80,11 +103,54 @@ struct XInputDevice
 
 
 static XInputDevice s_XInputDevices[4]{};
+static GD::Scope::Envelope s_Envelope;
+
+// Devices are polled on their own thread, so samples are not limited to the frame rate
+struct XInputPollSlot
+{
+    std::atomic<bool> Active{ false };
+    std::atomic<bool> Lost{ false };
+    XINPUT_STATE_EX State{};    // Protected by s_PollLock
+};
+
+static XInputPollSlot s_PollSlots[XUSER_MAX_COUNT];
+static std::mutex s_PollLock;
+static std::thread s_PollThread;
+static std::atomic<bool> s_PollStop{ false };
 
 static void XInput_Poweroff(DWORD XUser);
 static void XInput_EnableDisable(BOOL fEnable);
 static void XInput_SetRumble(DWORD XUser, WORD left, WORD right);
 
+static GD::Sample MakeSample(DWORD XUser, const XINPUT_STATE_EX& state)
+{
+    GD::Sample sample;
+    sample.Timestamp = GD::Now();
+    sample.PacketNumber = state.dwPacketNumber;
+    sample.Device = (uint16_t)XUser;
+    sample.Buttons = state.Gamepad.wButtons;
+    sample.LeftTrigger = state.Gamepad.bLeftTrigger;
+    sample.RightTrigger = state.Gamepad.bRightTrigger;
+    sample.ThumbLX = state.Gamepad.sThumbLX;
+    sample.ThumbLY = state.Gamepad.sThumbLY;
+    sample.ThumbRX = state.Gamepad.sThumbRX;
+    sample.ThumbRY = state.Gamepad.sThumbRY;
+    return sample;
+}
+
+static GD::DeviceInfo MakeDeviceInfo(DWORD XUser, const XINPUT_CAPABILITIES_EX& capabilities)
+{
+    GD::DeviceInfo info;
+    info.Id = (uint16_t)XUser;
+    info.Api = GD::DeviceApi_XInput;
+    info.Slot = (uint8_t)XUser;
+    info.VendorId = capabilities.vendorId;
+    info.ProductId = capabilities.productId;
+    info.ProductVersion = capabilities.productVersion;
+    info.SubType = capabilities.Capabilities.SubType;
+    return info;
+}
+
 static const string SubTypeToString(BYTE subtype)
 {
     switch (subtype)
@@ -306,39 +372,60 @@ static void ProgressBarEx(float fraction, const ImVec2& size_arg, const char* ov
     }
 }
 
-const char* analog_glyph(SHORT sThumbX, SHORT sThumbY, float deadzone)
+// A scrolling plot of one axis, one filled span per pixel column from the lowest to the highest value in it.
+// All spans go into the draw list as one reserved batch, so a busy axis costs the same as a quiet one
+static void ScopePlot(const GD::Scope::Envelope& envelope, int axis, float low, float high, const ImVec2& size_arg)
 {
-#ifndef M_PI
-#define M_PI       3.14159265358979323846
-#endif
-
-    float magnitude = sqrtf(sThumbX * (float)sThumbX + sThumbY * (float)sThumbY);
-    int xpos = 1;
-    int ypos = 1;
-    if (magnitude >= deadzone)
+    ImGuiWindow* window = ImGui::GetCurrentWindow();
+    if (window->SkipItems)
+        return;
+
+    ImGuiContext& g = *GImGui;
+    const ImGuiStyle& style = g.Style;
+
+    ImVec2 pos = window->DC.CursorPos;
+    ImVec2 size = ImGui::CalcItemSize(size_arg, ImGui::CalcItemWidth(), (g.FontSize + style.FramePadding.y * 2.0f) * 2);
+    ImRect bb(pos, pos + size);
+    ImGui::ItemSize(size, style.FramePadding.y);
+    if (!ImGui::ItemAdd(bb, 0))
+        return;
+
+    ImGui::RenderFrame(bb.Min, bb.Max, ImGui::GetColorU32(ImGuiCol_FrameBg), true, style.FrameRounding);
+    bb.Expand(ImVec2(-style.FrameBorderSize, -style.FrameBorderSize));
+    if (low < 0.0f)
     {
-        float direction = atan2f(sThumbY, sThumbX);
-        if (direction < 0.0f)
-            direction += 2.0f * (float)M_PI;
-        float angle = direction * (180.0f / (float)M_PI);
-        if (angle < 22.5f || angle >= 337.5f)
-            return "6";
-        else if (angle < 67.5f)
-            return "9";
-        else if (angle < 112.5f)
-            return "8";
-        else if (angle < 157.5f)
-            return "7";
-        else if (angle < 202.5f)
-            return "4";
-        else if (angle < 247.5f)
-            return "1";
-        else if (angle < 292.5f)
-            return "2";
-        else
-            return "3";
+        float zero = ImLerp(bb.Max.y, bb.Min.y, -low / (high - low));
+        window->DrawList->AddLine(ImVec2(bb.Min.x, zero), ImVec2(bb.Max.x, zero), ImGui::GetColorU32(ImGuiCol_Border));
+    }
+
+    const int16_t* mins = envelope.Min[axis].data();
+    const int16_t* maxs = envelope.Max[axis].data();
+    int spans = 0;
+    for (int column = 0; column < envelope.Columns; ++column)
+        spans += mins[column] <= maxs[column];
+    if (!spans)
+        return;
+
+    float column_w = bb.GetWidth() / envelope.Columns;
+    float scale = bb.GetHeight() / (high - low);
+    ImU32 col = ImGui::GetColorU32(ImGuiCol_PlotLines);
+    window->DrawList->PrimReserve(spans * 6, spans * 4);
+    for (int column = 0; column < envelope.Columns; ++column)
+    {
+        if (mins[column] > maxs[column])
+            continue;
+        // At least one pixel high, so a value that does not move still shows
+        float x = bb.Min.x + column * column_w;
+        float y0 = ImFloor(bb.Max.y - (maxs[column] - low) * scale);
+        float y1 = ImMax(bb.Max.y - (mins[column] - low) * scale, y0 + 1.0f);
+        window->DrawList->PrimRect(ImVec2(x, ImClamp(y0, bb.Min.y, bb.Max.y - 1.0f)), ImVec2(x + ImMax(column_w, 1.0f), ImClamp(y1, bb.Min.y + 1.0f, bb.Max.y)), col);
     }
-    return "5";
+}
+
+const char* analog_glyph(SHORT sThumbX, SHORT sThumbY, float deadzone)
+{
+    static const char* glyphs[10] = { "", "1", "2", "3", "4", "5", "6", "7", "8", "9" };
+    return glyphs[GD::NumpadDirection(sThumbX, sThumbY, deadzone)];
 }
 
 void GD::XInput::RenderFrame()
@@ -376,6 +463,48 @@ void GD::XInput::RenderFrame()
             XInput_EnableDisable(FALSE);
         if (ImGui::Selectable("Enumerate devices"))
             GD::XInput::EnumerateDevices();
+
+        ImGui::Separator();
+        if (!GD::Recorder::IsRecording())
+        {
+            if (ImGui::Selectable("Start recording"))
+                GD::Recorder::Start();
+        }
+        else
+        {
+            if (ImGui::Selectable("Stop recording"))
+                GD::Recorder::Stop();
+        }
+        if (ImGui::Selectable("Triggered capture..."))
+            GD::Capture::Show();
+        if (ImGui::Selectable("Noise spectrum..."))
+            GD::Spectrum::Show();
+        if (ImGui::Selectable("Axis statistics..."))
+            GD::AxisStats::Show();
+        if (ImGui::Selectable("Timing..."))
+            GD::Timing::Show();
+        if (ImGui::Selectable("Resolution..."))
+            GD::Resolution::Show();
+        if (ImGui::Selectable("Crosstalk..."))
+            GD::Crosstalk::Show();
+        if (ImGui::Selectable("Buttons..."))
+            GD::Buttons::Show();
+        if (ImGui::Selectable("Motions..."))
+            GD::Motions::Show();
+        if (ImGui::Selectable("Test script..."))
+            GD::Scripts::Show();
+        if (ImGui::Selectable("Bench..."))
+            GD::Bench::Show();
+        if (ImGui::Selectable("Processing..."))
+            GD::Processing::Show();
+        if (ImGui::Selectable("Dump flight recorder (F9)"))
+            GD::FlightRecorder::Dump("requested");
+        if (ImGui::Selectable("Replay..."))
+            GD::Replay::Show(GD::Recorder::LastPath());
+        ImGui::Separator();
+        GD::Trail::RenderOptions();
+        GD::Scope::RenderOptions();
+        GD::History::RenderOptions();
         ImGui::EndPopup();
     }
 
@@ -426,7 +555,7 @@ void GD::XInput::RenderFrame()
                         include_if(XINPUT_CAPS_WIRELESS, "Device is wireless.");
                         include_if(XINPUT_CAPS_NO_NAVIGATION, "Device lacks menu navigation buttons (START, BACK, DPAD).");
                         include_if(XINPUT_CAPS_PMD_SUPPORTED, "Device supports plug-in modules.");
-                        assert(Flags == 0 && "Unknown flags detected! Please report this.");
+                        GD_ASSERT(Flags == 0 && "Unknown flags detected! Please report this.");
 
                         ImGui::EndTooltip();
                     }
@@ -519,11 +648,21 @@ void GD::XInput::RenderFrame()
                 sprintf_s(buf, "%d", device.Gamepad.bRightTrigger);
                 ImGui::ProgressBar(device.Gamepad.bRightTrigger / 255.0f, ImVec2(avail.x / 2.f - style.FramePadding.x, 0.f), buf);
 
+                // One decimation pass per device covers all the scope plots, every plot is as wide as a bar
+                ImVec2 scope_size(avail.x / 2.f - style.FramePadding.x, 2 * height);
+                bool scope = device.connected && GD::Scope::Decimate((uint16_t)i, (int)scope_size.x, s_Envelope);
+                if (scope)
+                {
+                    ScopePlot(s_Envelope, GD::Axis_LeftTrigger, 0.f, 255.f, scope_size);
+                    ImGui::SameLine();
+                    ScopePlot(s_Envelope, GD::Axis_RightTrigger, 0.f, 255.f, scope_size);
+                }
+
 
                 ImGui::TableNextColumn();
                 ImGui::PushFont(io.Fonts->Fonts[1]);
                 ImGui::Text(CF_ANALOG_L);
-                auto gl = analog_glyph(device.Gamepad.sThumbLX, device.Gamepad.sThumbLY, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
+                auto gl = analog_glyph(device.Gamepad.sThumbLX, device.Gamepad.sThumbLY, GD::Processing::Deadzone(GD::Processing::Control_LeftStick));
                 ImGui::SameLine();
                 ImGui::Text(gl);
                 ImGui::PopFont();
@@ -534,11 +673,17 @@ void GD::XInput::RenderFrame()
                 ImGui::SameLine();
                 sprintf_s(buf, "Y: %d", device.Gamepad.sThumbLY);
                 ProgressBarEx(device.Gamepad.sThumbLY / 32767.0f, ImVec2(avail.x / 2.f - style.FramePadding.x, 0.f), buf);
+                if (scope)
+                {
+                    ScopePlot(s_Envelope, GD::Axis_ThumbLX, -32768.f, 32767.f, scope_size);
+                    ImGui::SameLine();
+                    ScopePlot(s_Envelope, GD::Axis_ThumbLY, -32768.f, 32767.f, scope_size);
+                }
 
                 ImGui::TableNextColumn();
                 ImGui::PushFont(io.Fonts->Fonts[1]);
                 ImGui::Text(CF_ANALOG_R);
-                gl = analog_glyph(device.Gamepad.sThumbRX, device.Gamepad.sThumbRY, XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE);
+                gl = analog_glyph(device.Gamepad.sThumbRX, device.Gamepad.sThumbRY, GD::Processing::Deadzone(GD::Processing::Control_RightStick));
                 ImGui::SameLine();
                 ImGui::Text(gl);
                 ImGui::PopFont();
@@ -548,6 +693,28 @@ void GD::XInput::RenderFrame()
                 ImGui::SameLine();
                 sprintf_s(buf, "Y: %d", device.Gamepad.sThumbRY);
                 ProgressBarEx(device.Gamepad.sThumbRY / 32767.0f, ImVec2(avail.x / 2.f - style.FramePadding.x, 0.f), buf);
+                if (scope)
+                {
+                    ScopePlot(s_Envelope, GD::Axis_ThumbRX, -32768.f, 32767.f, scope_size);
+                    ImGui::SameLine();
+                    ScopePlot(s_Envelope, GD::Axis_ThumbRY, -32768.f, 32767.f, scope_size);
+                }
+
+                ImGui::TableNextColumn();
+                ImGui::Text("Range");
+                ImGui::TableNextColumn();
+                if (device.connected)
+                {
+                    float side = ImMin(avail.x / 2.f - style.FramePadding.x, 8 * height);
+                    for (int stick = 0; stick < 2; ++stick)
+                    {
+                        if (stick)
+                            ImGui::SameLine();
+                        ImVec2 pos = ImGui::GetCursorScreenPos();
+                        GD::Heatmap::Draw(i, stick, side);
+                        GD::Trail::Draw(i, stick, pos, side);
+                    }
+                }
 
                 ImGui::TableNextColumn();
                 ImGui::Text("Battery");
@@ -614,6 +781,55 @@ void GD::XInput::RenderFrame()
     ImGui::End();
 }
 
+static void XInput_PollThread()
+{
+    // Ask for 1 ms timer resolution, so Sleep(1) does not turn into 15 ms
+    timeBeginPeriod(1);
+    DWORD packets[XUSER_MAX_COUNT]{};
+    bool active[XUSER_MAX_COUNT]{};
+    GD::Sample samples[XUSER_MAX_COUNT];
+    while (!s_PollStop)
+    {
+        for (DWORD i = 0; i < XUSER_MAX_COUNT; ++i)
+        {
+            auto& slot = s_PollSlots[i];
+            bool wasActive = active[i];
+            active[i] = slot.Active;
+            if (!active[i])
+                continue;
+            if (!wasActive)
+                packets[i] = 0;
+
+            XINPUT_STATE_EX state{};
+            if (s_XInputGetStateEx(i, &state) != ERROR_SUCCESS)
+            {
+                // Reported from the main thread, see Update
+                slot.Active = false;
+                slot.Lost = true;
+                active[i] = false;
+                continue;
+            }
+            if (!wasActive)
+                samples[i] = MakeSample(i, state);
+            if (state.dwPacketNumber != packets[i])
+            {
+                packets[i] = state.dwPacketNumber;
+                samples[i] = MakeSample(i, state);
+                GD::Recorder::Submit(samples[i]);
+
+                std::unique_lock<std::mutex> lock(s_PollLock);
+                slot.State = state;
+            }
+        }
+        // Every poll counts, not only the changes, so the statistics weigh each state by how long it was held
+        GD::AxisStats::Update(samples, active);
+        GD::Heatmap::Update(samples, active);
+        GD::Trail::Update(samples, active);
+        Sleep(1);
+    }
+    timeEndPeriod(1);
+}
+
 void GD::XInput::Update(double time)
 {
     if (!s_XInputGetStateEx)
@@ -632,34 +848,32 @@ void GD::XInput::Update(double time)
     {
         if (s_XInputDevices[i].connected)
         {
-            XINPUT_STATE_EX state{};
-            DWORD res = s_XInputGetStateEx(i, &state);
-            if (res == ERROR_SUCCESS)
+            if (s_PollSlots[i].Lost.exchange(false))
+            {
+                GD_Log("XInput controller %d is lost\n", i);
+                s_XInputDevices[i] = {};
+                GD::Recorder::DeviceDisconnected((uint16_t)i);
+                continue;
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(s_PollLock);
+                s_XInputDevices[i].dwPacketNumber = s_PollSlots[i].State.dwPacketNumber;
+                s_XInputDevices[i].Gamepad = s_PollSlots[i].State.Gamepad;
+            }
+            if (updateBattery)
             {
-                if (state.dwPacketNumber != s_XInputDevices[i].dwPacketNumber)
+                XINPUT_BATTERY_INFORMATION batteryInfo{};
+                DWORD res = s_XInputGetBatteryInformation(i, BATTERY_DEVTYPE_GAMEPAD, &batteryInfo);
+                if (res == ERROR_SUCCESS)
                 {
-                    s_XInputDevices[i].dwPacketNumber = state.dwPacketNumber;
-                    s_XInputDevices[i].Gamepad = state.Gamepad;
+                    s_XInputDevices[i].BatteryInfo = batteryInfo;
                 }
-                if (updateBattery)
+                else
                 {
-                    XINPUT_BATTERY_INFORMATION batteryInfo{};
-                    DWORD res = s_XInputGetBatteryInformation(i, BATTERY_DEVTYPE_GAMEPAD, &batteryInfo);
-                    if (res == ERROR_SUCCESS)
-                    {
-                        s_XInputDevices[i].BatteryInfo = batteryInfo;
-                    }
-                    else
-                    {
-                        GD_Log("Failed to get battery information for controller %d\n", i);
-                    }
+                    GD_Log("Failed to get battery information for controller %d\n", i);
                 }
             }
-            else
-            {
-                GD_Log("XInput controller %d is lost\n", i);
-                s_XInputDevices[i] = {};
-            }
         }
     }
 }
@@ -696,11 +910,20 @@ void GD::XInput::EnumerateDevices()
                 s_XInputDevices[i].Gamepad = {};
                 s_XInputDevices[i].dwPacketNumber = 0;
                 s_XInputDevices[i].BatteryInfo = {};
+                GD::Recorder::DeviceConnected(MakeDeviceInfo(i, capabilitiesEx));
+                {
+                    std::unique_lock<std::mutex> lock(s_PollLock);
+                    s_PollSlots[i].State = {};
+                }
+                s_PollSlots[i].Lost = false;
+                s_PollSlots[i].Active = true;
             }
             else
             {
                 GD_Log("XInput controller %d is disconnected\n", i);
+                s_PollSlots[i].Active = false;
                 s_XInputDevices[i] = {};
+                GD::Recorder::DeviceDisconnected((uint16_t)i);
             }
         }
     }
@@ -817,10 +1040,21 @@ void GD::XInput::Init()
         GD::XInput::Shutdown();
         return;
     }
+
+    s_PollThread = std::thread(XInput_PollThread);
 }
 
 void GD::XInput::Shutdown()
 {
+    if (s_PollThread.joinable())
+    {
+        s_PollStop = true;
+        s_PollThread.join();
+        s_PollStop = false;
+    }
+    for (auto& slot : s_PollSlots)
+        slot.Active = false;
+
     if (s_XInputInstance)
     {
         FreeLibrary(s_XInputInstance);
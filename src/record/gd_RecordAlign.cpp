@@ -0,0 +1,299 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Find the clock offset between two recordings of the same input
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordAlign.h"
+#include "record/gd_RecordReader.h"
+#include "gd_fft.h"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+
+using namespace GD::Record;
+
+constexpr size_t MinFftSize = 1024;
+
+
+uint64_t GD::Record::ReportInterval(const Reader& reader, uint16_t device)
+{
+    DeviceStream stream(reader, device);
+    std::vector<uint64_t> gaps;
+    GD::Sample previous, sample;
+    bool first = true;
+    while (gaps.size() < 4096 && stream.Next(sample))
+    {
+        if (!first && sample.Timestamp > previous.Timestamp)
+            gaps.push_back(sample.Timestamp - previous.Timestamp);
+        previous = sample;
+        first = false;
+    }
+    if (gaps.empty())
+        return 0;
+    std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+    return gaps[gaps.size() / 2];
+}
+
+// The state of a device at every step of a regular grid
+class Resampler
+{
+public:
+    Resampler(const Reader& reader, uint16_t device, int64_t offset, const std::vector<int>& channels, int64_t start, uint64_t step, uint64_t interval, uint64_t spread)
+        : m_Stream(reader, device, offset)
+        , m_EdgeStream(reader, device, offset)
+        , m_Channels(channels)
+        , m_Time(start)
+        , m_Step((int64_t)step)
+        , m_Interval((int64_t)interval)
+        , m_Spread((int64_t)spread)
+    {
+        m_HasNext = m_Stream.Next(m_Next);
+        m_Current = m_Next;
+        m_HasEdge = m_EdgeStream.Next(m_EdgeState);
+    }
+
+    // Appends count values to every channel
+    void Pull(size_t count, std::vector<std::vector<double>>& values)
+    {
+        for (size_t n = 0; n < count; ++n)
+        {
+            while (m_HasNext && (int64_t)m_Next.Timestamp <= m_Time)
+            {
+                m_Current = m_Next;
+                m_HasNext = m_Stream.Next(m_Next);
+            }
+            PullEdges();
+            for (size_t channel = 0; channel < m_Channels.size(); ++channel)
+                values[channel].push_back(Value(m_Channels[channel]));
+            m_Time += m_Step;
+        }
+    }
+
+private:
+    struct Edge
+    {
+        int64_t Time;
+        double Count;
+    };
+
+    // The report with an edge arrived somewhere up to one report interval after it happened, so the edge is
+    // placed in the middle of that interval. Otherwise every recording would be late by its own report latency.
+    void PullEdges()
+    {
+        while (m_HasEdge && (int64_t)m_EdgeState.Timestamp <= m_Time + m_Spread + m_Interval)
+        {
+            GD::Sample report;
+            m_HasEdge = m_EdgeStream.Next(report);
+            if (!m_HasEdge)
+                break;
+            int changed = (int)std::bitset<16>((uint16_t)(m_EdgeState.Buttons ^ report.Buttons)).count();
+            if (changed)
+            {
+                int64_t since = std::min<int64_t>((int64_t)(report.Timestamp - m_EdgeState.Timestamp), m_Interval);
+                m_Edges.push_back({ (int64_t)report.Timestamp - since / 2, (double)changed });
+            }
+            m_EdgeState = report;
+        }
+        // Only edges within the spread of this grid time still count
+        int64_t before = m_Time - m_Spread;
+        m_Edges.erase(std::remove_if(m_Edges.begin(), m_Edges.end(), [before](const Edge& edge) { return edge.Time <= before; }), m_Edges.end());
+    }
+
+    // Every channel is scaled to about -1 .. 1, so they weigh the same in the sum.
+    // Holding the last value would delay the signal by half a report interval, which differs between recordings.
+    // So the axes are interpolated between the samples around the grid time. Where in its report interval an edge
+    // happened is unknown, as an impulse the peak would follow the most common delay instead of the average one.
+    // So every edge is a smooth bump, wider than the report intervals of both recordings.
+    double Value(int channel) const
+    {
+        if (channel == AlignChannel_Buttons)
+        {
+            double value = 0.0;
+            for (const auto& edge : m_Edges)
+            {
+                double distance = (double)(edge.Time - m_Time) / (double)m_Spread;
+                if (distance > -1.0 && distance < 1.0)
+                    value += edge.Count * (1.0 - distance * distance);
+            }
+            return value;
+        }
+
+        bool between = m_HasNext && m_Next.Timestamp > m_Current.Timestamp && m_Time > (int64_t)m_Current.Timestamp;
+        double interval = between ? (double)(m_Next.Timestamp - m_Current.Timestamp) : 1.0;
+        double range = channel <= GD::Axis_RightTrigger ? 255.0 : 32768.0;
+        double value = GD::GetAxis(m_Current, channel);
+        if (between)
+            value += (GD::GetAxis(m_Next, channel) - value) * (double)(m_Time - (int64_t)m_Current.Timestamp) / interval;
+        return value / range;
+    }
+
+    DeviceStream m_Stream;
+    DeviceStream m_EdgeStream;                              // Runs ahead, edges can be placed before their report
+    const std::vector<int>& m_Channels;
+    GD::Sample m_Current;
+    GD::Sample m_Next;
+    bool m_HasNext = false;
+    GD::Sample m_EdgeState;                                 // The last report read by m_EdgeStream
+    bool m_HasEdge = false;
+    std::vector<Edge> m_Edges;
+    int64_t m_Time;
+    int64_t m_Step;
+    int64_t m_Interval;
+    int64_t m_Spread;                                       // Half the width of the bump of an edge
+};
+
+// Copies values without their mean into the start of a zero padded buffer, returns the energy
+static double Fill(const double* values, size_t count, std::vector<std::complex<double>>& buffer)
+{
+    double mean = 0.0;
+    for (size_t n = 0; n < count; ++n)
+        mean += values[n];
+    mean /= (double)std::max<size_t>(count, 1);
+
+    double energy = 0.0;
+    std::fill(buffer.begin(), buffer.end(), std::complex<double>());
+    for (size_t n = 0; n < count; ++n)
+    {
+        buffer[n] = values[n] - mean;
+        energy += (values[n] - mean) * (values[n] - mean);
+    }
+    return energy;
+}
+
+bool GD::Record::Align(const char* a, const char* b, const AlignOptions& options, AlignResult& result, std::string& error)
+{
+    Reader readers[2];
+    const char* paths[2] = { a, b };
+    int ids[2] = { options.DeviceA, options.DeviceB };
+    DeviceInfo infos[2];
+    for (int side = 0; side < 2; ++side)
+    {
+        if (!readers[side].Open(paths[side]))
+        {
+            error = std::string(paths[side]) + ": " + readers[side].Error();
+            return false;
+        }
+        if (!readers[side].FindDevice(ids[side], infos[side]))
+        {
+            error = std::string(paths[side]) + ": device not found";
+            return false;
+        }
+    }
+    if (options.Channels.empty() || !options.Resolution)
+    {
+        error = "Nothing to correlate";
+        return false;
+    }
+
+    int64_t guess = options.Guess;
+    if (options.Start == AlignStart_Clock)
+    {
+        // The same wall clock time in both recordings
+        const auto& headerA = readers[0].Header();
+        const auto& headerB = readers[1].Header();
+        guess = ((int64_t)headerB.StartUnixTime - (int64_t)headerB.StartTimestamp) - ((int64_t)headerA.StartUnixTime - (int64_t)headerA.StartTimestamp);
+    }
+
+    int64_t start = std::max((int64_t)readers[0].FirstTimestamp(), (int64_t)readers[1].FirstTimestamp() + guess);
+    int64_t end = std::min((int64_t)readers[0].LastTimestamp(), (int64_t)readers[1].LastTimestamp() + guess);
+    if (end <= start)
+    {
+        error = "The recordings do not overlap at the guessed offset";
+        return false;
+    }
+
+    // Lags 0 .. 2 * maxLag of the window of B line up with lags -maxLag .. maxLag of the block of A.
+    // The block and the window fit in one transform without wrapping around.
+    int64_t step = (int64_t)options.Resolution;
+    size_t maxLag = std::max<size_t>(1, (size_t)(options.MaxLag / options.Resolution));
+    GD::Fft fft(GD::Fft::NextSize(std::max(4 * maxLag, MinFftSize)));
+    size_t blockSize = fft.Size() - 2 * maxLag;
+    size_t total = (size_t)((end - start) / step) + 1;
+    size_t channels = options.Channels.size();
+
+    uint64_t intervals[2] = { ReportInterval(readers[0], infos[0].Id), ReportInterval(readers[1], infos[1].Id) };
+    uint64_t spread = 2 * std::max({ intervals[0], intervals[1], options.Resolution });
+    Resampler resamplerA(readers[0], infos[0].Id, 0, options.Channels, start, options.Resolution, intervals[0], spread);
+    Resampler resamplerB(readers[1], infos[1].Id, guess, options.Channels, start - (int64_t)maxLag * step, options.Resolution, intervals[1], spread);
+    std::vector<std::vector<double>> block(channels), window(channels);
+    resamplerB.Pull(blockSize + 2 * maxLag, window);
+
+    std::vector<std::complex<double>> spectrumA(fft.Size()), spectrumB(fft.Size()), sum(fft.Size());
+    // Every lag has its own energy of B, the part of the window that lines up with the block at that lag.
+    // Dividing by it keeps a stretch of B with more motion from winning over the lag that actually matches.
+    std::vector<double> correlation(2 * maxLag + 1), energyB(2 * maxLag + 1);
+    std::vector<double> sums(blockSize + 2 * maxLag + 1), squares(sums.size());
+    double energyA = 0.0;
+    result.Blocks = 0;
+
+    for (size_t first = 0; first < total; first += blockSize)
+    {
+        size_t count = std::min(blockSize, total - first);
+        for (auto& values : block)
+            values.clear();
+        resamplerA.Pull(count, block);
+
+        std::fill(sum.begin(), sum.end(), std::complex<double>());
+        for (size_t channel = 0; channel < channels; ++channel)
+        {
+            energyA += Fill(block[channel].data(), count, spectrumA);
+            Fill(window[channel].data(), count + 2 * maxLag, spectrumB);
+            double sumA = 0.0;
+            for (size_t n = 0; n < count; ++n)
+                sumA += spectrumA[n].real();
+            // Prefix sums, for the mean and energy of every stretch of count values in the window
+            for (size_t n = 0; n < count + 2 * maxLag; ++n)
+            {
+                double value = spectrumB[n].real();
+                sums[n + 1] = sums[n] + value;
+                squares[n + 1] = squares[n] + value * value;
+            }
+            // The product and the energy both take the mean of B under the lag off, not the mean of the window.
+            // A has its mean off already, so for the product that only removes rounding, but both now agree.
+            for (size_t lag = 0; lag <= 2 * maxLag; ++lag)
+            {
+                double part = sums[lag + count] - sums[lag];
+                energyB[lag] += squares[lag + count] - squares[lag] - part * part / (double)count;
+                correlation[lag] -= sumA * part / (double)count;
+            }
+            fft.Forward(spectrumA.data());
+            fft.Forward(spectrumB.data());
+            for (size_t n = 0; n < fft.Size(); ++n)
+                sum[n] += std::conj(spectrumA[n]) * spectrumB[n];
+        }
+        fft.Inverse(sum.data());
+        for (size_t lag = 0; lag <= 2 * maxLag; ++lag)
+            correlation[lag] += sum[lag].real();
+
+        // Slide the window of B along with the block of A
+        for (auto& values : window)
+            values.erase(values.begin(), values.begin() + count);
+        resamplerB.Pull(count, window);
+        result.Blocks++;
+    }
+
+    if (energyA <= 0.0 || *std::max_element(energyB.begin(), energyB.end()) <= 0.0)
+    {
+        error = "The chosen signals do not change";
+        return false;
+    }
+
+    for (size_t lag = 0; lag <= 2 * maxLag; ++lag)
+        correlation[lag] = energyB[lag] > 0.0 ? correlation[lag] / std::sqrt(energyA * energyB[lag]) : 0.0;
+
+    size_t peak = (size_t)(std::max_element(correlation.begin(), correlation.end()) - correlation.begin());
+    double fraction = 0.0;
+    if (peak > 0 && peak < 2 * maxLag)
+    {
+        double left = correlation[peak - 1], center = correlation[peak], right = correlation[peak + 1];
+        double curve = left - 2 * center + right;
+        if (curve < 0)
+            fraction = 0.5 * (left - right) / curve;
+    }
+
+    // A positive lag means B happens later than A, so it has to move back
+    double lag = ((double)peak + fraction - (double)maxLag) * (double)step;
+    result.Offset = guess - (int64_t)std::llround(lag);
+    result.Correlation = correlation[peak];
+    return true;
+}
@@ -0,0 +1,340 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Batch statistics over many recordings
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordAnalytics.h"
+#include "record/gd_RecordReader.h"
+#include "gd_threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+using namespace GD::Record;
+
+constexpr size_t BlockSize = 256;
+constexpr size_t ChunksPerTask = 16;
+
+
+void Moments::Merge(const Moments& other)
+{
+    if (!other.Count)
+        return;
+    uint64_t count = Count + other.Count;
+    double delta = other.Mean - Mean;
+    Mean += delta * other.Count / count;
+    M2 += other.M2 + delta * delta * ((double)Count * other.Count / count);
+    Count = count;
+}
+
+void Moments::MergeSums(uint64_t count, double sum, double sumSquares)
+{
+    if (!count)
+        return;
+    Moments block;
+    block.Count = count;
+    block.Mean = sum / count;
+    block.M2 = std::max(0.0, sumSquares - sum * block.Mean);
+    Merge(block);
+}
+
+void AxisStats::Merge(const AxisStats& other)
+{
+    Values.Merge(other.Values);
+    Min = std::min(Min, other.Min);
+    Max = std::max(Max, other.Max);
+}
+
+void RestStats::Merge(const RestStats& other)
+{
+    X.Merge(other.X);
+    Y.Merge(other.Y);
+}
+
+void SessionStats::Merge(const SessionStats& other)
+{
+    Samples += other.Samples;
+    FirstTimestamp = std::min(FirstTimestamp, other.FirstTimestamp);
+    LastTimestamp = std::max(LastTimestamp, other.LastTimestamp);
+    MissedPackets += other.MissedPackets;
+    ButtonPresses += other.ButtonPresses;
+    Intervals.Merge(other.Intervals);
+    for (int axis = 0; axis < Axis_Count; ++axis)
+        Axes[axis].Merge(other.Axes[axis]);
+    LeftRest.Merge(other.LeftRest);
+    RightRest.Merge(other.RightRest);
+}
+
+double GD::Record::Drift(const RestStats& rest)
+{
+    if (!rest.X.Count)
+        return -1.0;
+    return std::sqrt(rest.X.Mean * rest.X.Mean + rest.Y.Mean * rest.Y.Mean);
+}
+
+static void AddDrift(uint64_t (&histogram)[DriftBins], const RestStats& rest)
+{
+    double drift = Drift(rest);
+    if (drift >= 0)
+        histogram[std::min((int)(drift / DriftBinWidth), DriftBins - 1)]++;
+}
+
+void ProductStats::Add(const SessionStats& session)
+{
+    Sessions++;
+    Samples += session.Samples;
+    if (session.LastTimestamp > session.FirstTimestamp)
+        Duration += session.LastTimestamp - session.FirstTimestamp;
+    MissedPackets += session.MissedPackets;
+    ButtonPresses += session.ButtonPresses;
+    Intervals.Merge(session.Intervals);
+    for (int axis = 0; axis < Axis_Count; ++axis)
+        Axes[axis].Merge(session.Axes[axis]);
+    AddDrift(LeftDrift, session.LeftRest);
+    AddDrift(RightDrift, session.RightRest);
+}
+
+void ProductStats::Merge(const ProductStats& other)
+{
+    Sessions += other.Sessions;
+    Samples += other.Samples;
+    Duration += other.Duration;
+    MissedPackets += other.MissedPackets;
+    ButtonPresses += other.ButtonPresses;
+    Intervals.Merge(other.Intervals);
+    for (int axis = 0; axis < Axis_Count; ++axis)
+        Axes[axis].Merge(other.Axes[axis]);
+    for (int bin = 0; bin < DriftBins; ++bin)
+    {
+        LeftDrift[bin] += other.LeftDrift[bin];
+        RightDrift[bin] += other.RightDrift[bin];
+    }
+}
+
+
+static bool SameSession(const GD::DeviceInfo& a, const GD::DeviceInfo& b)
+{
+    return a.Id == b.Id && a.Api == b.Api && a.VendorId == b.VendorId && a.ProductId == b.ProductId && a.ProductVersion == b.ProductVersion;
+}
+
+static bool SameProduct(const GD::DeviceInfo& a, const GD::DeviceInfo& b)
+{
+    return a.VendorId == b.VendorId && a.ProductId == b.ProductId && a.ProductVersion == b.ProductVersion;
+}
+
+// Reduces the rest position of one stick over a block, without branches so it vectorizes
+static void ReduceRest(const int32_t* xs, const int32_t* ys, size_t count, int32_t deadzone, RestStats& rest)
+{
+    int64_t n = 0, sx = 0, sy = 0, sxx = 0, syy = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        int32_t x = xs[i], y = ys[i];
+        int32_t inside = (x > -deadzone) & (x < deadzone) & (y > -deadzone) & (y < deadzone);
+        int32_t mask = -inside;
+        n += inside;
+        sx += x & mask;
+        sy += y & mask;
+        sxx += (int64_t)(x & mask) * (x & mask);
+        syy += (int64_t)(y & mask) * (y & mask);
+    }
+    rest.X.MergeSums((uint64_t)n, (double)sx, (double)sxx);
+    rest.Y.MergeSums((uint64_t)n, (double)sy, (double)syy);
+}
+
+// Collects the samples of one device column by column, and reduces them a block at a time
+struct SessionBlock
+{
+    SessionStats Stats;
+    uint16_t LastButtons = 0;
+    uint32_t LastPacket = 0;
+    uint64_t LastTimestamp = 0;
+    size_t Fill = 0;
+    int32_t Values[GD::Axis_Count][BlockSize];
+
+    void Add(const GD::Sample& sample)
+    {
+        Stats.ButtonPresses += (uint64_t)std::bitset<16>((uint16_t)(~LastButtons & sample.Buttons)).count();
+        if (sample.PacketNumber - LastPacket > 1 && sample.PacketNumber - LastPacket < 0x80000000u)
+            Stats.MissedPackets += sample.PacketNumber - LastPacket - 1;
+        if (LastTimestamp && sample.Timestamp > LastTimestamp)
+            Stats.Intervals.Add((double)(sample.Timestamp - LastTimestamp));
+        LastButtons = sample.Buttons;
+        LastPacket = sample.PacketNumber;
+        LastTimestamp = sample.Timestamp;
+        Stats.Samples++;
+
+        for (int axis = 0; axis < GD::Axis_Count; ++axis)
+            Values[axis][Fill] = GD::GetAxis(sample, axis);
+        if (++Fill == BlockSize)
+            Flush();
+    }
+
+    void Flush()
+    {
+        for (int axis = 0; axis < GD::Axis_Count; ++axis)
+        {
+            const int32_t* values = Values[axis];
+            int64_t sum = 0, squares = 0;
+            int32_t lo = INT32_MAX, hi = INT32_MIN;
+            for (size_t i = 0; i < Fill; ++i)
+            {
+                sum += values[i];
+                squares += (int64_t)values[i] * values[i];
+                lo = std::min(lo, values[i]);
+                hi = std::max(hi, values[i]);
+            }
+            auto& stats = Stats.Axes[axis];
+            stats.Values.MergeSums(Fill, (double)sum, (double)squares);
+            stats.Min = std::min(stats.Min, lo);
+            stats.Max = std::max(stats.Max, hi);
+        }
+        ReduceRest(Values[GD::Axis_ThumbLX], Values[GD::Axis_ThumbLY], Fill, GD::LeftThumbDeadzone, Stats.LeftRest);
+        ReduceRest(Values[GD::Axis_ThumbRX], Values[GD::Axis_ThumbRY], Fill, GD::RightThumbDeadzone, Stats.RightRest);
+        Fill = 0;
+    }
+};
+
+struct FileJob
+{
+    std::unique_ptr<Reader> File;
+    std::mutex Lock;
+    std::vector<SessionStats> Sessions;
+};
+
+static void AnalyzeChunks(FileJob& job, size_t first, size_t last)
+{
+    std::vector<std::unique_ptr<SessionBlock>> blocks;
+    std::vector<SessionBlock*> current;
+
+    for (size_t chunk = first; chunk < last; ++chunk)
+    {
+        ChunkDecoder decoder;
+        if (!job.File->BeginChunk(chunk, decoder))
+            continue;
+
+        // Blocks for the devices of this chunk, in keyframe order
+        current.clear();
+        for (const auto& device : decoder.Devices())
+        {
+            SessionBlock* block = nullptr;
+            for (auto& existing : blocks)
+            {
+                if (SameSession(existing->Stats.Info, device.Info))
+                    block = existing.get();
+            }
+            if (!block)
+            {
+                blocks.push_back(std::make_unique<SessionBlock>());
+                block = blocks.back().get();
+                block->Stats.Info = device.Info;
+            }
+            // The keyframe holds the state before the first record, so edges at the chunk start are counted correctly
+            block->LastButtons = device.State.Buttons;
+            block->LastPacket = device.State.PacketNumber;
+            block->LastTimestamp = device.State.Timestamp;
+            block->Stats.FirstTimestamp = std::min(block->Stats.FirstTimestamp, decoder.Header().FirstTimestamp);
+            block->Stats.LastTimestamp = std::max(block->Stats.LastTimestamp, decoder.Header().LastTimestamp);
+            current.push_back(block);
+        }
+
+        GD::Sample sample;
+        while (decoder.Next(sample))
+        {
+            const auto& devices = decoder.Devices();
+            for (size_t n = 0; n < devices.size(); ++n)
+            {
+                if (devices[n].Info.Id == sample.Device)
+                {
+                    current[n]->Add(sample);
+                    break;
+                }
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(job.Lock);
+    for (auto& block : blocks)
+    {
+        block->Flush();
+        auto it = std::find_if(job.Sessions.begin(), job.Sessions.end(), [&](const SessionStats& session)
+            {
+                return SameSession(session.Info, block->Stats.Info);
+            });
+        if (it == job.Sessions.end())
+            job.Sessions.push_back(block->Stats);
+        else
+            it->Merge(block->Stats);
+    }
+}
+
+AnalyticsResult GD::Record::Analyze(const std::vector<std::string>& files, unsigned threads)
+{
+    AnalyticsResult result;
+    std::vector<std::unique_ptr<FileJob>> jobs;
+    std::atomic<uint64_t> failed{ 0 }, chunks{ 0 };
+
+    {
+        GD::ThreadPool pool(threads);
+        for (const auto& file : files)
+        {
+            jobs.push_back(std::make_unique<FileJob>());
+            FileJob* job = jobs.back().get();
+            // Opening the file is a task as well, it then splits its chunks into more tasks on the same worker
+            pool.Submit([&pool, &failed, &chunks, job, path = file]()
+                {
+                    job->File = std::make_unique<Reader>();
+                    if (!job->File->Open(path.c_str()))
+                    {
+                        failed++;
+                        return;
+                    }
+                    size_t count = job->File->ChunkCount();
+                    chunks += count;
+                    for (size_t first = 0; first < count; first += ChunksPerTask)
+                    {
+                        size_t last = std::min(count, first + ChunksPerTask);
+                        pool.Submit([job, first, last]() { AnalyzeChunks(*job, first, last); });
+                    }
+                });
+        }
+        pool.Wait();
+    }
+
+    for (const auto& job : jobs)
+    {
+        for (const auto& session : job->Sessions)
+        {
+            auto it = std::find_if(result.Products.begin(), result.Products.end(), [&](const ProductStats& product)
+                {
+                    return SameProduct(product.Info, session.Info);
+                });
+            if (it == result.Products.end())
+            {
+                result.Products.emplace_back();
+                it = result.Products.end() - 1;
+                it->Info.Api = session.Info.Api;
+                it->Info.VendorId = session.Info.VendorId;
+                it->Info.ProductId = session.Info.ProductId;
+                it->Info.ProductVersion = session.Info.ProductVersion;
+            }
+            it->Add(session);
+        }
+    }
+
+    std::sort(result.Products.begin(), result.Products.end(), [](const ProductStats& a, const ProductStats& b)
+        {
+            if (a.Info.VendorId != b.Info.VendorId)
+                return a.Info.VendorId < b.Info.VendorId;
+            if (a.Info.ProductId != b.Info.ProductId)
+                return a.Info.ProductId < b.Info.ProductId;
+            return a.Info.ProductVersion < b.Info.ProductVersion;
+        });
+
+    result.Files = files.size();
+    result.FailedFiles = failed;
+    result.Chunks = chunks;
+    return result;
+}
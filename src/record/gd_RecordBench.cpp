@@ -0,0 +1,124 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Append-only store of bench test results, indexed by product and instance
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordBench.h"
+#include "record/gd_RecordFormat.h"
+#include "gd_file.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace GD::Record;
+
+
+static uint32_t RecordChecksum(BenchRecord record)
+{
+    record.Checksum = 0;
+    return Crc32(&record, sizeof(record));
+}
+
+bool BenchStore::Fail(const std::string& error)
+{
+    m_Error = error;
+    Close();
+    return false;
+}
+
+void BenchStore::Close()
+{
+    if (m_File)
+        fclose(m_File);
+    m_File = nullptr;
+    m_Records.clear();
+    m_Index.clear();
+}
+
+bool BenchStore::Open(const char* path)
+{
+    Close();
+    m_Error.clear();
+
+    m_File = GD::OpenFile(path, "r+b");
+    if (!m_File)
+    {
+        m_File = GD::OpenFile(path, "w+b");
+        if (!m_File)
+            return Fail(std::string("Failed to create ") + path);
+        BenchHeader header;
+        header.RecordSize = sizeof(BenchRecord);
+        if (fwrite(&header, sizeof(header), 1, m_File) != 1 || !GD::SyncFile(m_File))
+            return Fail(std::string("Failed to write ") + path);
+        return true;
+    }
+
+    BenchHeader header;
+    if (fread(&header, sizeof(header), 1, m_File) != 1 || header.Magic != BenchMagic)
+        return Fail(std::string(path) + " is not a results file");
+    if (header.Version != BenchVersion || header.RecordSize != sizeof(BenchRecord))
+        return Fail(std::string(path) + " has an unsupported version");
+
+    // Everything up to the first record that is incomplete or damaged
+    BenchRecord record;
+    while (fread(&record, sizeof(record), 1, m_File) == 1 && RecordChecksum(record) == record.Checksum)
+    {
+        m_Index.emplace_back(Key(record.VendorId, record.ProductId, record.Slot), m_Records.size());
+        m_Records.push_back(record);
+    }
+    std::sort(m_Index.begin(), m_Index.end());
+
+    uint64_t valid = sizeof(header) + m_Records.size() * sizeof(BenchRecord);
+    if (!GD::TruncateFile(m_File, valid) || fseek(m_File, 0, SEEK_END) != 0)
+        return Fail(std::string("Failed to repair ") + path);
+    return true;
+}
+
+void BenchStore::Index(size_t index)
+{
+    const BenchRecord& record = m_Records[index];
+    std::pair<uint64_t, size_t> entry(Key(record.VendorId, record.ProductId, record.Slot), index);
+    m_Index.insert(std::upper_bound(m_Index.begin(), m_Index.end(), entry), entry);
+}
+
+bool BenchStore::Append(const BenchRecord& record)
+{
+    if (!m_File)
+        return false;
+
+    BenchRecord stored = record;
+    stored.Checksum = RecordChecksum(stored);
+    if (fwrite(&stored, sizeof(stored), 1, m_File) != 1 || !GD::SyncFile(m_File))
+    {
+        m_Error = "Failed to write the result";
+        return false;
+    }
+    m_Records.push_back(stored);
+    Index(m_Records.size() - 1);
+    return true;
+}
+
+std::vector<size_t> BenchStore::Find(uint16_t vendorId, uint16_t productId, int slot) const
+{
+    uint64_t first = Key(vendorId, productId, slot < 0 ? 0 : (uint8_t)slot);
+    uint64_t last = Key(vendorId, productId, slot < 0 ? 255 : (uint8_t)slot);
+    auto begin = std::lower_bound(m_Index.begin(), m_Index.end(), std::make_pair(first, (size_t)0));
+    auto end = std::upper_bound(m_Index.begin(), m_Index.end(), std::make_pair(last, SIZE_MAX));
+
+    std::vector<size_t> indices;
+    for (auto it = begin; it != end; ++it)
+        indices.push_back(it->second);
+    // Over several instances the order is by key first, make it the order they were added
+    std::sort(indices.begin(), indices.end());
+    return indices;
+}
+
+std::vector<uint64_t> BenchStore::Keys() const
+{
+    std::vector<uint64_t> keys;
+    for (const auto& entry : m_Index)
+    {
+        if (keys.empty() || keys.back() != entry.first)
+            keys.push_back(entry.first);
+    }
+    return keys;
+}
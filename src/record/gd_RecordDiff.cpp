@@ -0,0 +1,364 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Compare the behavior of a device in two recordings
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordDiff.h"
+#include "record/gd_RecordAlign.h"
+#include "record/gd_RecordAnalytics.h"
+#include "record/gd_RecordReader.h"
+#include "gd_resolution.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+
+using namespace GD::Record;
+
+// Level bits: the buttons, then every axis past half of its range, then the thumbs past half in the negative direction
+constexpr int LevelBits = 32;
+constexpr int LevelFirstAxis = 16;
+constexpr int LevelFirstNegative = 24;
+constexpr double MinAlignCorrelation = 0.8;                 // Below this the motion of both recordings did not really match
+constexpr double RestBand = 0.01;                           // Fraction of the axis range that a still axis stays within
+constexpr uint64_t StillTime = 100000;                      // How long it has to stay there before its changes count as noise
+constexpr double StepTolerance = 0.05;                      // The step is a mean of gaps, 64 and 65 on firmware that scales 10 bits to 16
+
+static uint32_t Levels(const GD::Sample& sample)
+{
+    uint32_t levels = sample.Buttons;
+    for (int axis = 0; axis < GD::Axis_Count; ++axis)
+    {
+        int32_t value = GD::GetAxis(sample, axis);
+        int32_t half = axis <= GD::Axis_RightTrigger ? 128 : 16384;
+        levels |= (uint32_t)(value >= half) << (LevelFirstAxis + axis);
+        levels |= (uint32_t)(value <= -half) << (LevelFirstNegative + axis);
+    }
+    return levels;
+}
+
+static bool AtRest(const GD::Sample& sample, int axis)
+{
+    auto inside = [](int32_t x, int32_t y, int32_t deadzone)
+        {
+            return x > -deadzone && x < deadzone && y > -deadzone && y < deadzone;
+        };
+    switch (axis)
+    {
+    case GD::Axis_LeftTrigger: return sample.LeftTrigger < GD::TriggerThreshold;
+    case GD::Axis_RightTrigger: return sample.RightTrigger < GD::TriggerThreshold;
+    case GD::Axis_ThumbLX:
+    case GD::Axis_ThumbLY: return inside(sample.ThumbLX, sample.ThumbLY, GD::LeftThumbDeadzone);
+    default: return inside(sample.ThumbRX, sample.ThumbRY, GD::RightThumbDeadzone);
+    }
+}
+
+struct AxisBehavior
+{
+    // Changes while the axis is at rest and has not left a narrow band for StillTime. A slow movement leaves it,
+    // otherwise its changes would grow with the report interval. The spread of each stretch is around its own mean,
+    // so drift within the band cancels out and what is left is the noise.
+    Moments Rest;
+    Moments Still;                  // The changes since the axis entered the band, until it is known to stay long enough
+    int32_t StillValue = 0;
+    uint64_t StillStart = 0;
+    uint64_t StillEnd = 0;
+    int32_t MinNonZero = INT32_MAX; // Smallest magnitude that is not reported as 0
+    GD::AxisResolution Resolution;  // The values seen, for their number and the step between them
+
+    void EndStill(int32_t value, uint64_t timestamp)
+    {
+        if (StillEnd - StillStart >= StillTime)
+            Rest.Merge(Still);
+        Still = {};
+        StillValue = value;
+        StillStart = StillEnd = timestamp;
+    }
+};
+
+// What one recording shows about its device, collected one sample at a time
+struct Behavior
+{
+    Behavior()
+    {
+        for (int axis = 0; axis < GD::Axis_Count; ++axis)
+        {
+            Axes[axis].Resolution = GD::AxisResolution(axis);
+            Bands[axis] = std::max((int32_t)std::lround(RestBand * (axis <= GD::Axis_RightTrigger ? 255 : 65535)), 1);
+        }
+    }
+
+    uint64_t Samples = 0;
+    Moments Intervals;
+    AxisBehavior Axes[GD::Axis_Count];
+    int32_t Bands[GD::Axis_Count];
+    GD::Sample Last;
+    bool HasLast = false;
+
+    void Add(const GD::Sample& sample)
+    {
+        Samples++;
+        if (HasLast)
+            Intervals.MergeSums(1, (double)(sample.Timestamp - Last.Timestamp), (double)(sample.Timestamp - Last.Timestamp) * (sample.Timestamp - Last.Timestamp));
+        for (int axis = 0; axis < GD::Axis_Count; ++axis)
+        {
+            auto& stats = Axes[axis];
+            int32_t value = GD::GetAxis(sample, axis);
+            stats.Resolution.Add(value);
+            if (value)
+                stats.MinNonZero = std::min(stats.MinNonZero, std::abs(value));
+            if (!HasLast || !AtRest(sample, axis) || !AtRest(Last, axis) || std::abs(value - stats.StillValue) > Bands[axis])
+            {
+                stats.EndStill(value, sample.Timestamp);
+                continue;
+            }
+            int32_t delta = value - GD::GetAxis(Last, axis);
+            stats.Still.MergeSums(1, delta, (double)delta * delta);
+            stats.StillEnd = sample.Timestamp;
+        }
+        Last = sample;
+        HasLast = true;
+    }
+
+    // The last stretch of rest also counts when it was long enough
+    void Finish()
+    {
+        for (auto& stats : Axes)
+            stats.EndStill(0, 0);
+    }
+};
+
+// Timestamp of the first button press or stick movement past half of its range
+static bool FirstEdge(const Reader& reader, uint16_t device, uint64_t& timestamp, uint64_t& interval)
+{
+    DeviceStream stream(reader, device, 0);
+    GD::Sample sample;
+    if (!stream.Next(sample))
+        return false;
+    uint32_t last = Levels(sample);
+    uint64_t previous = sample.Timestamp;
+    while (stream.Next(sample))
+    {
+        uint32_t levels = Levels(sample);
+        if (~last & levels)
+        {
+            timestamp = sample.Timestamp;
+            interval = sample.Timestamp - previous;
+            return true;
+        }
+        last = levels;
+        previous = sample.Timestamp;
+    }
+    return false;
+}
+
+// Pairs the edges of both recordings that are closest in time, oldest first
+class EdgeMatcher
+{
+public:
+    explicit EdgeMatcher(uint64_t window) : m_Window(window) {}
+
+    void Add(int side, uint32_t edges, uint64_t timestamp)
+    {
+        while (edges)
+        {
+            int bit = 0;
+            while (!(edges & (1u << bit)))
+                bit++;
+            edges &= ~(1u << bit);
+
+            auto& other = m_Pending[!side][bit];
+            while (!other.empty() && other.front() + m_Window < timestamp)
+                other.pop_front();
+            if (other.empty())
+            {
+                m_Pending[side][bit].push_back(timestamp);
+                continue;
+            }
+
+            double delta = side ? (double)timestamp - (double)other.front() : (double)other.front() - (double)timestamp;
+            other.pop_front();
+            (bit < LevelFirstAxis ? Buttons : Axes).MergeSums(1, delta, delta * delta);
+        }
+    }
+
+    Moments Buttons;    // Microseconds that B is later than A
+    Moments Axes;
+
+private:
+    uint64_t m_Window;
+    std::deque<uint64_t> m_Pending[2][LevelBits];
+};
+
+static double NormalPValue(double z)
+{
+    return std::erfc(std::fabs(z) / std::sqrt(2.0));
+}
+
+// Welch's test, with a normal distribution because the sample counts are large
+static double MeansPValue(const Moments& a, const Moments& b)
+{
+    if (a.Count < 2 || b.Count < 2)
+        return 1.0;
+    double error = std::sqrt(a.Variance() / a.Count + b.Variance() / b.Count);
+    if (error == 0.0)
+        return a.Mean == b.Mean ? 1.0 : 0.0;
+    return NormalPValue((a.Mean - b.Mean) / error);
+}
+
+// Compares the logarithm of the variances, which is close to normal for large counts
+static double VariancesPValue(const Moments& a, const Moments& b)
+{
+    if (a.Count < 3 || b.Count < 3)
+        return 1.0;
+    double va = a.Variance(), vb = b.Variance();
+    if (va == 0.0 || vb == 0.0)
+        return va == vb ? 1.0 : 0.0;
+    return NormalPValue(std::log(va / vb) / std::sqrt(2.0 / (a.Count - 1) + 2.0 / (b.Count - 1)));
+}
+
+static double ZeroMeanPValue(const Moments& m)
+{
+    if (m.Count < 2)
+        return 1.0;
+    double error = std::sqrt(m.Variance() / m.Count);
+    if (error == 0.0)
+        return m.Mean == 0.0 ? 1.0 : 0.0;
+    return NormalPValue(m.Mean / error);
+}
+
+bool GD::Record::Diff(const char* a, const char* b, const DiffOptions& options, DiffResult& result, std::string& error)
+{
+    Reader readers[2];
+    const char* paths[2] = { a, b };
+    int ids[2] = { options.DeviceA, options.DeviceB };
+    DeviceInfo* infos[2] = { &result.InfoA, &result.InfoB };
+    for (int side = 0; side < 2; ++side)
+    {
+        if (!readers[side].Open(paths[side]))
+        {
+            error = std::string(paths[side]) + ": " + readers[side].Error();
+            return false;
+        }
+        if (!readers[side].FindDevice(ids[side], *infos[side]))
+        {
+            error = std::string(paths[side]) + ": device not found";
+            return false;
+        }
+    }
+
+    result.Offset = options.Offset;
+    if (options.Align)
+    {
+        uint64_t first[2], interval[2];
+        for (int side = 0; side < 2; ++side)
+        {
+            if (!FirstEdge(readers[side], infos[side]->Id, first[side], interval[side]))
+            {
+                error = std::string(paths[side]) + ": nothing to align on, the device is never used";
+                return false;
+            }
+        }
+        result.Offset = (int64_t)first[0] - (int64_t)first[1];
+
+        // The first edge is only as precise as the report interval, the correlation of the whole motion is better.
+        // It is only used when it stays within that interval and the motion really matched, otherwise the guess stays.
+        AlignOptions align;
+        align.DeviceA = infos[0]->Id;
+        align.DeviceB = infos[1]->Id;
+        align.Start = AlignStart_Given;
+        align.Guess = result.Offset;
+        AlignResult aligned;
+        std::string alignError;
+        uint64_t reach = std::max(interval[0], interval[1]);
+        if (GD::Record::Align(a, b, align, aligned, alignError) && aligned.Correlation >= MinAlignCorrelation &&
+            (uint64_t)std::llabs(aligned.Offset - result.Offset) <= reach)
+        {
+            result.Offset = aligned.Offset;
+            result.Correlation = aligned.Correlation;
+        }
+    }
+
+    int64_t startB = (int64_t)readers[1].FirstTimestamp() + result.Offset, endB = (int64_t)readers[1].LastTimestamp() + result.Offset;
+    int64_t start = std::max((int64_t)readers[0].FirstTimestamp(), startB);
+    int64_t end = std::min((int64_t)readers[0].LastTimestamp(), endB);
+    if (end <= start)
+    {
+        error = "The recordings do not overlap";
+        return false;
+    }
+    result.Overlap = (uint64_t)(end - start);
+
+    // Both streams are merged by time, so matching edges only need a window of pending edges
+    auto behavior = std::make_unique<Behavior[]>(2);
+    EdgeMatcher matcher(options.MatchWindow);
+    DeviceStream streams[2] = { { readers[0], infos[0]->Id, 0 }, { readers[1], infos[1]->Id, result.Offset } };
+    GD::Sample samples[2];
+    bool has[2] = { streams[0].Next(samples[0]), streams[1].Next(samples[1]) };
+    uint32_t levels[2] = { Levels(samples[0]), Levels(samples[1]) };
+    while (has[0] || has[1])
+    {
+        int side = (has[0] && (!has[1] || samples[0].Timestamp <= samples[1].Timestamp)) ? 0 : 1;
+        const GD::Sample& sample = samples[side];
+        uint32_t current = Levels(sample);
+        if ((int64_t)sample.Timestamp >= start && (int64_t)sample.Timestamp <= end)
+        {
+            behavior[side].Add(sample);
+            matcher.Add(side, ~levels[side] & current, sample.Timestamp);
+        }
+        levels[side] = current;
+        has[side] = streams[side].Next(samples[side]);
+    }
+    behavior[0].Finish();
+    behavior[1].Finish();
+    result.SamplesA = behavior[0].Samples;
+    result.SamplesB = behavior[1].Samples;
+    result.MatchedEdges = matcher.Buttons.Count + matcher.Axes.Count;
+
+    auto add = [&](std::string name, double valueA, double valueB, double pValue)
+        {
+            result.Metrics.push_back({ std::move(name), valueA, valueB, pValue, false });
+        };
+    auto addExact = [&](std::string name, int axis, double valueA, double valueB, double tolerance)
+        {
+            double range = axis <= Axis_RightTrigger ? 255.0 : 65535.0;
+            result.Metrics.push_back({ std::move(name), valueA, valueB, -1.0, std::fabs(valueA - valueB) > tolerance * range });
+        };
+    auto addRelative = [&](std::string name, double valueA, double valueB, double tolerance)
+        {
+            result.Metrics.push_back({ std::move(name), valueA, valueB, -1.0, std::fabs(valueA - valueB) > tolerance * std::max(valueA, valueB) });
+        };
+
+    // Without a shared clock the edge delay also holds the error of the offset, the axes compared to the buttons do not
+    Moments edges = matcher.Buttons;
+    edges.Merge(matcher.Axes);
+    result.Delays.push_back({ "Edges", edges.Mean / 1000, ZeroMeanPValue(edges), false });
+    result.Delays.push_back({ "Axes after buttons", (matcher.Axes.Mean - matcher.Buttons.Mean) / 1000, MeansPValue(matcher.Axes, matcher.Buttons), false });
+    add("Report interval (ms)", behavior[0].Intervals.Mean / 1000, behavior[1].Intervals.Mean / 1000, MeansPValue(behavior[0].Intervals, behavior[1].Intervals));
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        const auto& axisA = behavior[0].Axes[axis];
+        const auto& axisB = behavior[1].Axes[axis];
+        GD::ResolutionInfo resolutionA = axisA.Resolution.Analyze();
+        GD::ResolutionInfo resolutionB = axisB.Resolution.Analyze();
+        std::string name = AxisName(axis);
+        // The difference of two independent noise values has twice the variance
+        add(name + " noise at rest", std::sqrt(axisA.Rest.Variance() / 2), std::sqrt(axisB.Rest.Variance() / 2), VariancesPValue(axisA.Rest, axisB.Rest));
+        addExact(name + " smallest non-zero", axis, axisA.MinNonZero == INT32_MAX ? 0 : axisA.MinNonZero, axisB.MinNonZero == INT32_MAX ? 0 : axisB.MinNonZero, options.Tolerance);
+        addExact(name + " distinct values", axis, (double)resolutionA.Codes, (double)resolutionB.Codes, options.Tolerance);
+        // A coarser step means bits were dropped, that is never noise
+        addRelative(name + " step", resolutionA.Step, resolutionB.Step, StepTolerance);
+    }
+
+    // Bonferroni correction, every test gets an equal share of alpha
+    size_t tests = result.Delays.size() + std::count_if(result.Metrics.begin(), result.Metrics.end(), [](const DiffMetric& metric) { return metric.PValue >= 0; });
+    for (auto& delay : result.Delays)
+        delay.Significant = delay.PValue < options.Alpha / tests;
+    for (auto& metric : result.Metrics)
+    {
+        if (metric.PValue >= 0)
+            metric.Significant = metric.PValue < options.Alpha / tests;
+    }
+    return true;
+}
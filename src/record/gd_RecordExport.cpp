@@ -0,0 +1,32 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Convert recordings to formats that other tools understand
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordExport.h"
+#include <cctype>
+#include <cstring>
+
+static bool HasExtension(const char* path, const char* extension)
+{
+    size_t length = strlen(path), extensionLength = strlen(extension);
+    if (length < extensionLength)
+        return false;
+    path += length - extensionLength;
+    for (size_t n = 0; n < extensionLength; ++n)
+    {
+        if (tolower((unsigned char)path[n]) != extension[n])
+            return false;
+    }
+    return true;
+}
+
+bool GD::Record::Export(const char* recording, const char* output, std::string& error)
+{
+    if (HasExtension(output, ".parquet"))
+        return ExportParquet(recording, output, error);
+    if (HasExtension(output, ".vcd"))
+        return ExportVcd(recording, output, error);
+    error = "Unknown export format, expected .parquet or .vcd";
+    return false;
+}
@@ -0,0 +1,349 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     On-disk layout and sample codec of recordings
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordFormat.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+using namespace GD::Record;
+
+
+uint32_t GD::Record::Crc32(const void* data, size_t size, uint32_t crc)
+{
+    static const auto table = []()
+        {
+            std::array<uint32_t, 256> table{};
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+                uint32_t value = n;
+                for (int bit = 0; bit < 8; ++bit)
+                    value = (value >> 1) ^ ((value & 1) ? 0xEDB88320u : 0);
+                table[n] = value;
+            }
+            return table;
+        }();
+
+    const uint8_t* cur = (const uint8_t*)data;
+    crc = ~crc;
+    while (size--)
+        crc = table[(crc ^ *cur++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+void GD::Record::EncodeLogBlock(const std::vector<LogRecord>& records, std::vector<uint8_t>& out)
+{
+    size_t start = out.size();
+    out.resize(start + sizeof(LogBlockHeader));
+
+    LogBlockHeader header;
+    for (const auto& record : records)
+    {
+        size_t length = std::min<size_t>(record.Text.size(), UINT16_MAX);
+        size_t offset = out.size();
+        out.resize(offset + sizeof(uint64_t) + sizeof(uint16_t) + length);
+        uint16_t length16 = (uint16_t)length;
+        memcpy(&out[offset], &record.Timestamp, sizeof(uint64_t));
+        memcpy(&out[offset + sizeof(uint64_t)], &length16, sizeof(uint16_t));
+        memcpy(&out[offset + sizeof(uint64_t) + sizeof(uint16_t)], record.Text.data(), length);
+        header.Count++;
+    }
+
+    header.PayloadSize = (uint32_t)(out.size() - start - sizeof(header));
+    uint32_t checksum = Crc32(&header, sizeof(header));
+    header.Checksum = Crc32(&out[start + sizeof(header)], header.PayloadSize, checksum);
+    memcpy(&out[start], &header, sizeof(header));
+}
+
+bool GD::Record::DecodeLogBlock(const uint8_t* data, size_t available, std::vector<LogRecord>& records)
+{
+    if (!ValidBlockSize(data, available))
+        return false;
+
+    LogBlockHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.Magic != LogMagic)
+        return false;
+
+    const uint8_t* cur = data + sizeof(header);
+    const uint8_t* end = cur + header.PayloadSize;
+    for (uint32_t n = 0; n < header.Count; ++n)
+    {
+        LogRecord record;
+        uint16_t length;
+        if (end - cur < (ptrdiff_t)(sizeof(uint64_t) + sizeof(uint16_t)))
+            return false;
+        memcpy(&record.Timestamp, cur, sizeof(uint64_t));
+        memcpy(&length, cur + sizeof(uint64_t), sizeof(uint16_t));
+        cur += sizeof(uint64_t) + sizeof(uint16_t);
+        if (end - cur < length)
+            return false;
+        record.Text.assign((const char*)cur, length);
+        cur += length;
+        records.push_back(std::move(record));
+    }
+    return true;
+}
+
+size_t GD::Record::ValidBlockSize(const uint8_t* data, size_t available)
+{
+    uint32_t magic;
+    if (available < sizeof(magic))
+        return 0;
+    memcpy(&magic, data, sizeof(magic));
+
+    if (magic == ChunkMagic)
+    {
+        ChunkDecoder decoder;
+        if (!decoder.Begin(data, available))
+            return 0;
+        return sizeof(ChunkHeader) + decoder.Header().PayloadSize;
+    }
+
+    if (magic == LogMagic && available >= sizeof(LogBlockHeader))
+    {
+        LogBlockHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (header.PayloadSize > available - sizeof(header))
+            return 0;
+
+        uint32_t checksum = header.Checksum;
+        header.Checksum = 0;
+        if (Crc32(data + sizeof(header), header.PayloadSize, Crc32(&header, sizeof(header))) != checksum)
+            return 0;
+        return sizeof(header) + header.PayloadSize;
+    }
+    return 0;
+}
+
+void ChunkSummary::Add(const Sample& sample, bool first)
+{
+    ButtonsOr |= sample.Buttons;
+    ButtonsAnd &= sample.Buttons;
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        int16_t value = (int16_t)GD::GetAxis(sample, axis);
+        if (first || value < Min[axis])
+            Min[axis] = value;
+        if (first || value > Max[axis])
+            Max[axis] = value;
+    }
+}
+
+void ChunkEncoder::Reserve(size_t devices, size_t records)
+{
+    m_Last.reserve(devices);
+    m_Payload.reserve(devices * sizeof(KeyframeEntry) + records * MaxRecordSize);
+}
+
+void ChunkEncoder::Begin(const std::vector<KeyframeEntry>& keyframe, uint64_t timestamp)
+{
+    m_Header = {};
+    m_Header.FirstTimestamp = timestamp;
+    m_Header.LastTimestamp = timestamp;
+    m_Header.DeviceCount = (uint16_t)keyframe.size();
+    m_LastTimestamp = timestamp;
+
+    m_Summary = {};
+    m_Last.clear();
+    for (const auto& entry : keyframe)
+    {
+        m_Summary.Add(entry.State, m_Last.empty());
+        m_Last.push_back(entry.State);
+    }
+
+    m_Payload.resize(keyframe.size() * sizeof(KeyframeEntry));
+    if (!keyframe.empty())
+        memcpy(m_Payload.data(), keyframe.data(), m_Payload.size());
+    m_Header.PayloadSize = (uint32_t)(sizeof(ChunkSummary) + m_Payload.size());
+}
+
+bool ChunkEncoder::Add(const Sample& sample)
+{
+    size_t index = 0;
+    while (index < m_Last.size() && m_Last[index].Device != sample.Device)
+        index++;
+    if (index == m_Last.size())
+        return false;
+
+    Sample& last = m_Last[index];
+    uint8_t mask = 0;
+    if (sample.Buttons != last.Buttons)
+        mask |= RecordField_Buttons;
+    if (sample.LeftTrigger != last.LeftTrigger)
+        mask |= RecordField_LeftTrigger;
+    if (sample.RightTrigger != last.RightTrigger)
+        mask |= RecordField_RightTrigger;
+    if (sample.ThumbLX != last.ThumbLX)
+        mask |= RecordField_ThumbLX;
+    if (sample.ThumbLY != last.ThumbLY)
+        mask |= RecordField_ThumbLY;
+    if (sample.ThumbRX != last.ThumbRX)
+        mask |= RecordField_ThumbRX;
+    if (sample.ThumbRY != last.ThumbRY)
+        mask |= RecordField_ThumbRY;
+    if (sample.PacketNumber != last.PacketNumber + 1)
+        mask |= RecordField_PacketJump;
+
+    PutVarint(m_Payload, ZigZag((int64_t)(sample.Timestamp - m_LastTimestamp)));
+    PutVarint(m_Payload, index);
+    m_Payload.push_back(mask);
+
+    if (mask & RecordField_Buttons)
+    {
+        m_Payload.push_back((uint8_t)sample.Buttons);
+        m_Payload.push_back((uint8_t)(sample.Buttons >> 8));
+    }
+    if (mask & RecordField_LeftTrigger)
+        m_Payload.push_back(sample.LeftTrigger);
+    if (mask & RecordField_RightTrigger)
+        m_Payload.push_back(sample.RightTrigger);
+    if (mask & RecordField_ThumbLX)
+        PutVarint(m_Payload, ZigZag(sample.ThumbLX - last.ThumbLX));
+    if (mask & RecordField_ThumbLY)
+        PutVarint(m_Payload, ZigZag(sample.ThumbLY - last.ThumbLY));
+    if (mask & RecordField_ThumbRX)
+        PutVarint(m_Payload, ZigZag(sample.ThumbRX - last.ThumbRX));
+    if (mask & RecordField_ThumbRY)
+        PutVarint(m_Payload, ZigZag(sample.ThumbRY - last.ThumbRY));
+    if (mask & RecordField_PacketJump)
+        PutVarint(m_Payload, ZigZag((int64_t)sample.PacketNumber - (int64_t)last.PacketNumber));
+
+    if (mask & ~RecordField_PacketJump)
+        m_Summary.ChangeCount++;
+    m_Summary.Add(sample, false);
+
+    last = sample;
+    m_LastTimestamp = sample.Timestamp;
+    m_Header.LastTimestamp = sample.Timestamp;
+    m_Header.RecordCount++;
+    m_Header.PayloadSize = (uint32_t)(sizeof(ChunkSummary) + m_Payload.size());
+    return true;
+}
+
+ChunkHeader ChunkEncoder::Seal() const
+{
+    ChunkHeader header = m_Header;
+    header.Checksum = 0;
+    uint32_t checksum = Crc32(&header, sizeof(header));
+    checksum = Crc32(&m_Summary, sizeof(m_Summary), checksum);
+    header.Checksum = Crc32(m_Payload.data(), m_Payload.size(), checksum);
+    return header;
+}
+
+
+bool ChunkDecoder::Begin(const uint8_t* chunk, size_t available, bool verify)
+{
+    m_Devices.clear();
+    m_Remaining = 0;
+    if (available < sizeof(ChunkHeader))
+        return false;
+
+    memcpy(&m_Header, chunk, sizeof(m_Header));
+    size_t keyframeSize = m_Header.DeviceCount * sizeof(KeyframeEntry);
+    if (m_Header.Magic != ChunkMagic || m_Header.PayloadSize > available - sizeof(ChunkHeader) ||
+        sizeof(ChunkSummary) + keyframeSize > m_Header.PayloadSize)
+    {
+        return false;
+    }
+
+    const uint8_t* payload = chunk + sizeof(ChunkHeader);
+    if (verify)
+    {
+        ChunkHeader header = m_Header;
+        header.Checksum = 0;
+        uint32_t checksum = Crc32(&header, sizeof(header));
+        if (Crc32(payload, m_Header.PayloadSize, checksum) != m_Header.Checksum)
+            return false;
+    }
+
+    memcpy(&m_Summary, payload, sizeof(m_Summary));
+    m_Devices.resize(m_Header.DeviceCount);
+    if (keyframeSize)
+        memcpy(m_Devices.data(), payload + sizeof(ChunkSummary), keyframeSize);
+
+    m_Cur = payload + sizeof(ChunkSummary) + keyframeSize;
+    m_End = payload + m_Header.PayloadSize;
+    m_Remaining = m_Header.RecordCount;
+    m_LastTimestamp = m_Header.FirstTimestamp;
+    return true;
+}
+
+bool ChunkDecoder::Next(Sample& sample)
+{
+    if (!m_Remaining)
+        return false;
+    m_Remaining--;
+
+    uint64_t delta, index;
+    if (!GetVarint(m_Cur, m_End, delta) || !GetVarint(m_Cur, m_End, index) || index >= m_Devices.size() || m_Cur >= m_End)
+    {
+        m_Remaining = 0;
+        return false;
+    }
+
+    uint8_t mask = *m_Cur++;
+    Sample& state = m_Devices[index].State;
+    uint32_t packet = state.PacketNumber + 1;
+
+    auto thumb = [this](int16_t& value) -> bool
+        {
+            uint64_t raw;
+            if (!GetVarint(m_Cur, m_End, raw))
+                return false;
+            value = (int16_t)(value + UnZigZag(raw));
+            return true;
+        };
+
+    bool ok = true;
+    if (mask & RecordField_Buttons)
+    {
+        ok = ok && m_End - m_Cur >= 2;
+        if (ok)
+        {
+            state.Buttons = (uint16_t)(m_Cur[0] | (m_Cur[1] << 8));
+            m_Cur += 2;
+        }
+    }
+    if (ok && (mask & RecordField_LeftTrigger))
+    {
+        ok = m_Cur < m_End;
+        if (ok)
+            state.LeftTrigger = *m_Cur++;
+    }
+    if (ok && (mask & RecordField_RightTrigger))
+    {
+        ok = m_Cur < m_End;
+        if (ok)
+            state.RightTrigger = *m_Cur++;
+    }
+    if (ok && (mask & RecordField_ThumbLX))
+        ok = thumb(state.ThumbLX);
+    if (ok && (mask & RecordField_ThumbLY))
+        ok = thumb(state.ThumbLY);
+    if (ok && (mask & RecordField_ThumbRX))
+        ok = thumb(state.ThumbRX);
+    if (ok && (mask & RecordField_ThumbRY))
+        ok = thumb(state.ThumbRY);
+    if (ok && (mask & RecordField_PacketJump))
+    {
+        uint64_t raw;
+        ok = GetVarint(m_Cur, m_End, raw);
+        packet = (uint32_t)((int64_t)state.PacketNumber + UnZigZag(raw));
+    }
+
+    if (!ok)
+    {
+        m_Remaining = 0;
+        return false;
+    }
+
+    m_LastTimestamp += (uint64_t)UnZigZag(delta);
+    state.Timestamp = m_LastTimestamp;
+    state.PacketNumber = packet;
+    sample = state;
+    return true;
+}
@@ -0,0 +1,476 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Export recordings as Apache Parquet files
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordExport.h"
+#include "record/gd_RecordReader.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+using namespace GD::Record;
+
+// See https://github.com/apache/parquet-format, only the parts that are needed for flat, required columns
+enum ParquetType
+{
+    ParquetType_Int32 = 1,
+    ParquetType_Int64 = 2,
+};
+
+enum ConvertedType
+{
+    ConvertedType_TimestampMicros = 10,
+    ConvertedType_UInt8 = 11,
+    ConvertedType_UInt16 = 12,
+    ConvertedType_UInt32 = 13,
+    ConvertedType_Int16 = 16,
+};
+
+constexpr int32_t Encoding_Rle = 3;
+constexpr int32_t Encoding_DeltaBinaryPacked = 5;
+constexpr size_t PageValues = 16384;
+
+// Thrift compact protocol, which is what the Parquet metadata is written in
+class CompactWriter
+{
+public:
+    enum Type
+    {
+        Type_I32 = 5,
+        Type_I64 = 6,
+        Type_Binary = 8,
+        Type_List = 9,
+        Type_Struct = 12,
+    };
+
+    std::vector<uint8_t> Out;
+
+    void BeginStruct() { m_LastField.push_back(0); }
+    void EndStruct()
+    {
+        Out.push_back(0);
+        m_LastField.pop_back();
+    }
+
+    void I32(int id, int32_t value)
+    {
+        Field(id, Type_I32);
+        PutVarint(Out, ZigZag(value));
+    }
+    void I64(int id, int64_t value)
+    {
+        Field(id, Type_I64);
+        PutVarint(Out, ZigZag(value));
+    }
+    void Binary(int id, const void* data, size_t size)
+    {
+        Field(id, Type_Binary);
+        ElementBinary(data, size);
+    }
+    void String(int id, const std::string& value) { Binary(id, value.data(), value.size()); }
+    void Struct(int id)
+    {
+        Field(id, Type_Struct);
+        BeginStruct();
+    }
+    void List(int id, Type element, size_t count)
+    {
+        Field(id, Type_List);
+        if (count < 15)
+        {
+            Out.push_back((uint8_t)(count << 4 | element));
+        }
+        else
+        {
+            Out.push_back((uint8_t)(0xf0 | element));
+            PutVarint(Out, count);
+        }
+    }
+
+    void ElementI32(int32_t value) { PutVarint(Out, ZigZag(value)); }
+    void ElementBinary(const void* data, size_t size)
+    {
+        PutVarint(Out, size);
+        Out.insert(Out.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+    }
+    void ElementString(const std::string& value) { ElementBinary(value.data(), value.size()); }
+
+private:
+    void Field(int id, Type type)
+    {
+        int delta = id - m_LastField.back();
+        if (delta > 0 && delta <= 15)
+        {
+            Out.push_back((uint8_t)(delta << 4 | type));
+        }
+        else
+        {
+            Out.push_back((uint8_t)type);
+            PutVarint(Out, ZigZag(id));
+        }
+        m_LastField.back() = id;
+    }
+
+    std::vector<int> m_LastField;
+};
+
+
+struct ColumnDef
+{
+    const char* Name;
+    ParquetType Type;
+    ConvertedType Converted;
+};
+
+static const ColumnDef s_Columns[] = {
+    { "timestamp", ParquetType_Int64, ConvertedType_TimestampMicros },
+    { "device", ParquetType_Int32, ConvertedType_UInt16 },
+    { "dwPacketNumber", ParquetType_Int32, ConvertedType_UInt32 },
+    { "wButtons", ParquetType_Int32, ConvertedType_UInt16 },
+    { "bLeftTrigger", ParquetType_Int32, ConvertedType_UInt8 },
+    { "bRightTrigger", ParquetType_Int32, ConvertedType_UInt8 },
+    { "sThumbLX", ParquetType_Int32, ConvertedType_Int16 },
+    { "sThumbLY", ParquetType_Int32, ConvertedType_Int16 },
+    { "sThumbRX", ParquetType_Int32, ConvertedType_Int16 },
+    { "sThumbRY", ParquetType_Int32, ConvertedType_Int16 },
+};
+constexpr size_t ColumnCount = sizeof(s_Columns) / sizeof(s_Columns[0]);
+
+// The values are kept as their logical value (unsigned types are not negative), so min / max sort correctly
+static int64_t ColumnValue(const GD::Sample& sample, uint64_t unixTime, size_t column)
+{
+    switch (column)
+    {
+    case 0: return (int64_t)unixTime;
+    case 1: return sample.Device;
+    case 2: return sample.PacketNumber;
+    case 3: return sample.Buttons;
+    default: return GD::GetAxis(sample, (int)column - 4 + GD::Axis_LeftTrigger);
+    }
+}
+
+static void PackBits(const uint64_t* values, size_t count, int width, std::vector<uint8_t>& out)
+{
+    uint64_t acc = 0;
+    int bits = 0;
+    for (size_t n = 0; n < count; ++n)
+    {
+        uint64_t value = values[n];
+        for (int remaining = width; remaining > 0;)
+        {
+            int take = std::min(remaining, 64 - bits);
+            acc |= (take == 64 ? value : value & ((1ull << take) - 1)) << bits;
+            value = take == 64 ? 0 : value >> take;
+            bits += take;
+            remaining -= take;
+            for (; bits >= 8; bits -= 8)
+            {
+                out.push_back((uint8_t)acc);
+                acc >>= 8;
+            }
+        }
+    }
+    if (bits)
+        out.push_back((uint8_t)acc);
+}
+
+// DELTA_BINARY_PACKED: blocks of 128 deltas in 4 miniblocks, each bit packed with its own width.
+// INT32 columns use 32 bit wrapping arithmetic, as the format requires.
+static void EncodeDeltas(const int64_t* values, size_t count, bool is32, std::vector<uint8_t>& out)
+{
+    constexpr size_t BlockValues = 128;
+    constexpr size_t Miniblocks = 4;
+    constexpr size_t MiniblockValues = BlockValues / Miniblocks;
+
+    auto wrap = [is32](int64_t value) { return is32 ? (int64_t)(int32_t)(uint32_t)value : value; };
+
+    PutVarint(out, BlockValues);
+    PutVarint(out, Miniblocks);
+    PutVarint(out, count);
+    PutVarint(out, ZigZag(count ? wrap(values[0]) : 0));
+
+    int64_t deltas[BlockValues];
+    uint64_t packed[MiniblockValues];
+    for (size_t start = 1; start < count; start += BlockValues)
+    {
+        size_t n = std::min(BlockValues, count - start);
+        int64_t minDelta = INT64_MAX;
+        for (size_t i = 0; i < n; ++i)
+        {
+            deltas[i] = wrap((int64_t)((uint64_t)values[start + i] - (uint64_t)values[start + i - 1]));
+            minDelta = std::min(minDelta, deltas[i]);
+        }
+        PutVarint(out, ZigZag(minDelta));
+
+        size_t used = (n + MiniblockValues - 1) / MiniblockValues;
+        uint8_t widths[Miniblocks]{};
+        size_t widthsAt = out.size();
+        out.insert(out.end(), widths, widths + Miniblocks);
+        for (size_t m = 0; m < used; ++m)
+        {
+            uint64_t all = 0;
+            for (size_t i = 0; i < MiniblockValues; ++i)
+            {
+                size_t index = m * MiniblockValues + i;
+                uint64_t value = 0;
+                if (index < n)
+                    value = is32 ? (uint32_t)((uint32_t)deltas[index] - (uint32_t)minDelta) : (uint64_t)deltas[index] - (uint64_t)minDelta;
+                packed[i] = value;
+                all |= value;
+            }
+            int width = 0;
+            while (width < 64 && (all >> width))
+                width++;
+            out[widthsAt + m] = (uint8_t)width;
+            PackBits(packed, MiniblockValues, width, out);
+        }
+    }
+}
+
+struct ColumnChunkInfo
+{
+    uint64_t Offset = 0;
+    uint64_t Size = 0;
+    int64_t Min = 0;
+    int64_t Max = 0;
+};
+
+struct RowGroupInfo
+{
+    uint64_t Rows = 0;
+    ColumnChunkInfo Columns[ColumnCount];
+};
+
+// One column of the current row group
+struct ColumnState
+{
+    std::vector<int64_t> Page;
+    std::vector<uint8_t> Data;      // Encoded pages, including their headers
+    std::vector<uint8_t> Encoded;
+    int64_t Min = INT64_MAX;
+    int64_t Max = INT64_MIN;
+};
+
+static void FlushPage(ColumnState& column, bool is32)
+{
+    if (column.Page.empty())
+        return;
+
+    column.Encoded.clear();
+    EncodeDeltas(column.Page.data(), column.Page.size(), is32, column.Encoded);
+
+    CompactWriter header;
+    header.BeginStruct();
+    header.I32(1, 0);   // DATA_PAGE
+    header.I32(2, (int32_t)column.Encoded.size());
+    header.I32(3, (int32_t)column.Encoded.size());
+    header.Struct(5);
+    header.I32(1, (int32_t)column.Page.size());
+    header.I32(2, Encoding_DeltaBinaryPacked);
+    header.I32(3, Encoding_Rle);
+    header.I32(4, Encoding_Rle);
+    header.EndStruct();
+    header.EndStruct();
+
+    column.Data.insert(column.Data.end(), header.Out.begin(), header.Out.end());
+    column.Data.insert(column.Data.end(), column.Encoded.begin(), column.Encoded.end());
+    column.Page.clear();
+}
+
+static void StatisticsValue(const ColumnDef& def, int64_t value, uint8_t (&bytes)[8], size_t& size)
+{
+    // Plain encoding, little endian
+    size = def.Type == ParquetType_Int64 ? 8 : 4;
+    for (size_t n = 0; n < size; ++n)
+        bytes[n] = (uint8_t)((uint64_t)value >> (8 * n));
+}
+
+static std::vector<uint8_t> FileMetaData(const std::vector<RowGroupInfo>& groups, uint64_t rows, const std::string& devices, uint64_t startUnixTime)
+{
+    CompactWriter meta;
+    meta.BeginStruct();
+    meta.I32(1, 1);
+
+    meta.List(2, CompactWriter::Type_Struct, ColumnCount + 1);
+    meta.BeginStruct();
+    meta.String(4, "schema");
+    meta.I32(5, (int32_t)ColumnCount);
+    meta.EndStruct();
+    for (const auto& column : s_Columns)
+    {
+        meta.BeginStruct();
+        meta.I32(1, column.Type);
+        meta.I32(3, 0);     // REQUIRED
+        meta.String(4, column.Name);
+        meta.I32(6, column.Converted);
+        meta.EndStruct();
+    }
+
+    meta.I64(3, (int64_t)rows);
+
+    meta.List(4, CompactWriter::Type_Struct, groups.size());
+    for (const auto& group : groups)
+    {
+        uint64_t total = 0;
+        meta.BeginStruct();
+        meta.List(1, CompactWriter::Type_Struct, ColumnCount);
+        for (size_t n = 0; n < ColumnCount; ++n)
+        {
+            const auto& def = s_Columns[n];
+            const auto& chunk = group.Columns[n];
+            total += chunk.Size;
+
+            meta.BeginStruct();
+            meta.I64(2, (int64_t)chunk.Offset);
+            meta.Struct(3);
+            meta.I32(1, def.Type);
+            meta.List(2, CompactWriter::Type_I32, 1);
+            meta.ElementI32(Encoding_DeltaBinaryPacked);
+            meta.List(3, CompactWriter::Type_Binary, 1);
+            meta.ElementString(def.Name);
+            meta.I32(4, 0);     // UNCOMPRESSED, the encoding already takes care of that
+            meta.I64(5, (int64_t)group.Rows);
+            meta.I64(6, (int64_t)chunk.Size);
+            meta.I64(7, (int64_t)chunk.Size);
+            meta.I64(9, (int64_t)chunk.Offset);
+            meta.Struct(12);
+            uint8_t bytes[8];
+            size_t size;
+            meta.I64(3, 0);
+            StatisticsValue(def, chunk.Max, bytes, size);
+            meta.Binary(5, bytes, size);
+            StatisticsValue(def, chunk.Min, bytes, size);
+            meta.Binary(6, bytes, size);
+            meta.EndStruct();
+            meta.EndStruct();
+            meta.EndStruct();
+        }
+        meta.I64(2, (int64_t)total);
+        meta.I64(3, (int64_t)group.Rows);
+        meta.EndStruct();
+    }
+
+    meta.List(5, CompactWriter::Type_Struct, 2);
+    meta.BeginStruct();
+    meta.String(1, "GamepadDebug.StartUnixTime");
+    meta.String(2, std::to_string(startUnixTime));
+    meta.EndStruct();
+    meta.BeginStruct();
+    meta.String(1, "GamepadDebug.Devices");
+    meta.String(2, devices);
+    meta.EndStruct();
+
+    meta.String(6, "GamepadDebug");
+
+    // Without a column order, readers ignore min_value / max_value
+    meta.List(7, CompactWriter::Type_Struct, ColumnCount);
+    for (size_t n = 0; n < ColumnCount; ++n)
+    {
+        meta.BeginStruct();
+        meta.Struct(1);     // TYPE_ORDER
+        meta.EndStruct();
+        meta.EndStruct();
+    }
+    meta.EndStruct();
+    return std::move(meta.Out);
+}
+
+bool GD::Record::ExportParquet(const char* recording, const char* output, std::string& error)
+{
+    Reader reader;
+    if (!reader.Open(recording))
+    {
+        error = reader.Error();
+        return false;
+    }
+
+    FILE* file = GD::OpenFile(output, "wb");
+    if (!file)
+    {
+        error = "Unable to create the output file";
+        return false;
+    }
+
+    static const char magic[4] = { 'P', 'A', 'R', '1' };
+    uint64_t offset = fwrite(magic, 1, sizeof(magic), file);
+
+    std::vector<ColumnState> columns(ColumnCount);
+    for (auto& column : columns)
+        column.Page.reserve(PageValues);
+    std::vector<RowGroupInfo> groups;
+    RowGroupInfo group;
+    uint64_t rows = 0;
+
+    auto flushGroup = [&]()
+        {
+            if (!group.Rows)
+                return;
+            for (size_t n = 0; n < ColumnCount; ++n)
+            {
+                auto& column = columns[n];
+                FlushPage(column, s_Columns[n].Type == ParquetType_Int32);
+                group.Columns[n] = { offset, column.Data.size(), column.Min, column.Max };
+                offset += fwrite(column.Data.data(), 1, column.Data.size(), file);
+                column.Data.clear();
+                column.Min = INT64_MAX;
+                column.Max = INT64_MIN;
+            }
+            groups.push_back(group);
+            group = {};
+        };
+
+    // Device descriptions for the metadata, as 'id:api:slot:vid:pid:version' separated by ';'
+    std::string devices;
+    std::vector<uint16_t> seen;
+    size_t lastChunk = SIZE_MAX;
+
+    const auto& header = reader.Header();
+    SampleStream stream(reader);
+    GD::Sample sample;
+    while (stream.Next(sample))
+    {
+        if (stream.Chunk() != lastChunk)
+        {
+            lastChunk = stream.Chunk();
+            for (const auto& device : stream.Devices())
+            {
+                if (std::find(seen.begin(), seen.end(), device.Info.Id) != seen.end())
+                    continue;
+                seen.push_back(device.Info.Id);
+                char text[64];
+                snprintf(text, sizeof(text), "%s%u:%u:%u:%04X:%04X:%04X", devices.empty() ? "" : ";", device.Info.Id, device.Info.Api,
+                    device.Info.Slot, device.Info.VendorId, device.Info.ProductId, device.Info.ProductVersion);
+                devices += text;
+            }
+        }
+
+        uint64_t unixTime = header.StartUnixTime + (sample.Timestamp - header.StartTimestamp);
+        for (size_t n = 0; n < ColumnCount; ++n)
+        {
+            auto& column = columns[n];
+            int64_t value = ColumnValue(sample, unixTime, n);
+            column.Page.push_back(value);
+            column.Min = std::min(column.Min, value);
+            column.Max = std::max(column.Max, value);
+            if (column.Page.size() == PageValues)
+                FlushPage(column, s_Columns[n].Type == ParquetType_Int32);
+        }
+        rows++;
+        if (++group.Rows == ParquetRowGroupRows)
+            flushGroup();
+    }
+    flushGroup();
+
+    auto meta = FileMetaData(groups, rows, devices, header.StartUnixTime);
+    uint32_t length = (uint32_t)meta.size();
+    uint8_t trailer[8] = { (uint8_t)length, (uint8_t)(length >> 8), (uint8_t)(length >> 16), (uint8_t)(length >> 24), 'P', 'A', 'R', '1' };
+    fwrite(meta.data(), 1, meta.size(), file);
+    fwrite(trailer, 1, sizeof(trailer), file);
+
+    bool ok = !ferror(file);
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        error = "Unable to write the output file";
+    return ok;
+}
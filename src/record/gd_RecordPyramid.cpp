@@ -0,0 +1,441 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Min/max overview of recordings at every zoom level
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordPyramid.h"
+#include "gd_file.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace GD::Record;
+
+
+// Level-0 bucket of a timestamp
+static uint64_t BucketIndex(uint64_t timestamp, uint64_t start)
+{
+    return timestamp > start ? (timestamp - start) >> PyramidBaseShift : 0;
+}
+
+void Bucket::Clear()
+{
+    std::fill_n(Min, Axis_Count, INT16_MAX);
+    std::fill_n(Max, Axis_Count, INT16_MIN);
+    ButtonsOr = 0;
+    ButtonsAnd = 0xffff;
+}
+
+void Bucket::Add(const Sample& sample)
+{
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        int16_t value = (int16_t)GetAxis(sample, axis);
+        Min[axis] = std::min(Min[axis], value);
+        Max[axis] = std::max(Max[axis], value);
+    }
+    ButtonsOr |= sample.Buttons;
+    ButtonsAnd &= sample.Buttons;
+}
+
+void Bucket::Merge(const Bucket& other)
+{
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        Min[axis] = std::min(Min[axis], other.Min[axis]);
+        Max[axis] = std::max(Max[axis], other.Max[axis]);
+    }
+    ButtonsOr |= other.ButtonsOr;
+    ButtonsAnd &= other.ButtonsAnd;
+}
+
+
+void Pyramid::Begin(uint64_t startTimestamp)
+{
+    m_StartTimestamp = startTimestamp;
+    m_LastTimestamp = startTimestamp;
+    m_Devices.clear();
+}
+
+int Pyramid::FindDevice(uint16_t id) const
+{
+    for (size_t n = 0; n < m_Devices.size(); ++n)
+    {
+        if (m_Devices[n].Info.Id == id)
+            return (int)n;
+    }
+    return -1;
+}
+
+Pyramid::DeviceLevels& Pyramid::Find(const DeviceInfo& info)
+{
+    int index = FindDevice(info.Id);
+    if (index >= 0)
+        return m_Devices[index];
+    m_Devices.emplace_back();
+    m_Devices.back().Info = info;
+    m_Devices.back().Levels.resize(1);
+    return m_Devices.back();
+}
+
+void Pyramid::HoldUntil(DeviceLevels& device, uint64_t bucket)
+{
+    while (device.Current < bucket)
+    {
+        device.Levels[0].push_back(device.Pending);
+        device.Current++;
+        device.Pending.Clear();
+        device.Pending.Add(device.Held);
+    }
+}
+
+void Pyramid::Add(const DeviceInfo& info, const Sample& sample)
+{
+    DeviceLevels& device = Find(info);
+    uint64_t bucket = BucketIndex(sample.Timestamp, m_StartTimestamp);
+    if (device.Holding)
+    {
+        HoldUntil(device, bucket);
+    }
+    else
+    {
+        // Nothing was held since the device was last seen
+        while (device.Written + device.Levels[0].size() < bucket)
+            device.Levels[0].emplace_back();
+        device.Current = device.Written + device.Levels[0].size();
+        device.Pending.Clear();
+        device.Holding = true;
+    }
+    device.Pending.Add(sample);
+    device.Held = sample;
+}
+
+void Pyramid::RemoveDevice(uint16_t id)
+{
+    int index = FindDevice(id);
+    if (index < 0 || !m_Devices[index].Holding)
+        return;
+    DeviceLevels& device = m_Devices[index];
+    device.Levels[0].push_back(device.Pending);
+    device.Holding = false;
+}
+
+void Pyramid::Finish(uint64_t lastTimestamp)
+{
+    m_LastTimestamp = lastTimestamp;
+    uint64_t last = BucketIndex(lastTimestamp, m_StartTimestamp);
+    for (auto& device : m_Devices)
+    {
+        if (device.Holding)
+        {
+            HoldUntil(device, last);
+            device.Levels[0].push_back(device.Pending);
+            device.Holding = false;
+        }
+    }
+}
+
+void Pyramid::BuildLevels()
+{
+    for (auto& device : m_Devices)
+    {
+        device.Levels.resize(1);
+        for (size_t level = 0; device.Levels[level].size() > 1; ++level)
+        {
+            // A bucket without a sibling is the whole of its parent
+            const auto& below = device.Levels[level];
+            std::vector<Bucket> buckets((below.size() + 1) / 2);
+            for (size_t n = 0; n < below.size(); ++n)
+                buckets[n / 2].Merge(below[n]);
+            device.Levels.push_back(std::move(buckets));
+        }
+    }
+}
+
+bool Pyramid::WriteHeader(FILE* file, uint32_t chunkCount) const
+{
+    PyramidHeader header;
+    header.StartTimestamp = m_StartTimestamp;
+    if (chunkCount)
+    {
+        header.LastTimestamp = m_LastTimestamp;
+        header.ChunkCount = chunkCount;
+    }
+    return fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1 && fseek(file, 0, SEEK_END) == 0;
+}
+
+bool Pyramid::WriteBlock(FILE* file, const DeviceLevels& device, uint32_t chunk, uint64_t chunkTimestamp) const
+{
+    const auto& buckets = device.Levels[0];
+    PyramidBlock block;
+    block.Info = device.Info;
+    block.Count = (uint32_t)buckets.size();
+    block.First = device.Written;
+    block.ChunkTimestamp = chunkTimestamp;
+    block.Chunk = chunk;
+    block.Holding = device.Holding;
+    block.Checksum = Crc32(buckets.data(), buckets.size() * sizeof(Bucket), Crc32(&block, sizeof(block)));
+    return fwrite(&block, sizeof(block), 1, file) == 1 && fwrite(buckets.data(), sizeof(Bucket), buckets.size(), file) == buckets.size();
+}
+
+bool Pyramid::AppendFinished(FILE* file, uint32_t chunk, uint64_t chunkTimestamp)
+{
+    // Also devices without new buckets, so a load knows which were still connected
+    bool ok = true;
+    for (auto& device : m_Devices)
+    {
+        ok = WriteBlock(file, device, chunk, chunkTimestamp) && ok;
+        device.Written += device.Levels[0].size();
+        device.Levels[0].clear();
+    }
+    return ok;
+}
+
+bool Pyramid::Save(const char* path, const Reader& reader) const
+{
+    if (!reader.ChunkCount())
+        return false;
+    FILE* file = GD::OpenFile(path, "wb");
+    if (!file)
+        return false;
+
+    uint32_t last = (uint32_t)reader.ChunkCount() - 1;
+    bool ok = WriteHeader(file, last + 1);
+    for (const auto& device : m_Devices)
+        ok = ok && WriteBlock(file, device, last, reader.Chunk(last).Timestamp);
+    ok = GD::SyncFile(file) && ok;
+    fclose(file);
+    return ok;
+}
+
+// Adds everything from the given chunk on, the devices in its keyframe are held from the start of the chunk
+static bool AddChunks(const Reader& reader, size_t first, Pyramid& pyramid)
+{
+    ChunkDecoder decoder;
+    std::vector<uint16_t> present;
+    for (size_t chunk = first; chunk < reader.ChunkCount(); ++chunk)
+    {
+        if (!reader.BeginChunk(chunk, decoder))
+            return false;
+
+        // Devices that are missing from this keyframe were disconnected in between
+        const auto& devices = decoder.Devices();
+        for (uint16_t id : present)
+        {
+            if (std::none_of(devices.begin(), devices.end(), [id](const KeyframeEntry& entry) { return entry.Info.Id == id; }))
+                pyramid.RemoveDevice(id);
+        }
+        present.clear();
+        for (const auto& entry : devices)
+        {
+            GD::Sample state = entry.State;
+            state.Timestamp = reader.Chunk(chunk).Timestamp;
+            pyramid.Add(entry.Info, state);
+            present.push_back(entry.Info.Id);
+        }
+
+        GD::Sample sample;
+        while (decoder.Next(sample))
+        {
+            for (const auto& entry : devices)
+            {
+                if (entry.Info.Id == sample.Device)
+                    pyramid.Add(entry.Info, sample);
+            }
+        }
+    }
+    return true;
+}
+
+bool Pyramid::Load(const char* path, const Reader& reader)
+{
+    GD::MappedFile file;
+    if (!file.Open(path))
+        return false;
+
+    const uint8_t* data = file.Data();
+    size_t size = file.Size();
+    PyramidHeader header;
+    if (size < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.Magic != PyramidMagic || header.Version != PyramidVersion || header.BaseShift != PyramidBaseShift ||
+        header.StartTimestamp != reader.Header().StartTimestamp)
+    {
+        return false;
+    }
+
+    // Every block has to follow the one before it, and the chunk it was written after has to be in the recording.
+    // The first one that does not is where the writer stopped, or where the recording was cut by a recovery.
+    Pyramid loaded;
+    loaded.Begin(header.StartTimestamp);
+    size_t offset = sizeof(header);
+    size_t resume = 0;
+    PyramidBlock block;
+    while (size - offset >= sizeof(block))
+    {
+        memcpy(&block, data + offset, sizeof(block));
+        uint32_t checksum = block.Checksum;
+        block.Checksum = 0;
+        if (block.Count > (size - offset - sizeof(block)) / sizeof(Bucket) || block.Chunk >= reader.ChunkCount() ||
+            reader.Chunk(block.Chunk).Timestamp != block.ChunkTimestamp)
+        {
+            break;
+        }
+        const uint8_t* buckets = data + offset + sizeof(block);
+        if (Crc32(buckets, block.Count * sizeof(Bucket), Crc32(&block, sizeof(block))) != checksum)
+            break;
+        DeviceLevels& device = loaded.Find(block.Info);
+        auto& level = device.Levels[0];
+        if (block.First != level.size())
+            break;
+        level.resize(level.size() + block.Count);
+        memcpy(level.data() + block.First, buckets, block.Count * sizeof(Bucket));
+        device.Holding = block.Holding != 0;
+        resume = block.Chunk + 1;
+        offset += sizeof(block) + block.Count * sizeof(Bucket);
+    }
+    if (offset == sizeof(header) && reader.ChunkCount())
+        return false;
+
+    // The bucket a connected device was in when the writer stopped is not complete, and neither is anything after it.
+    // Those are built again, from the last chunk that starts before the first of them.
+    uint64_t complete = UINT64_MAX;
+    for (const auto& device : loaded.m_Devices)
+    {
+        if (device.Holding)
+            complete = std::min<uint64_t>(complete, device.Levels[0].size());
+    }
+    while (resume > 0 && complete != UINT64_MAX &&
+        (resume == reader.ChunkCount() || BucketIndex(reader.Chunk(resume).Timestamp, loaded.m_StartTimestamp) >= complete))
+    {
+        resume--;
+    }
+
+    Pyramid rest;
+    rest.Begin(loaded.m_StartTimestamp);
+    if (!AddChunks(reader, resume, rest))
+        return false;
+    rest.Finish(reader.LastTimestamp());
+    for (const auto& added : rest.m_Devices)
+    {
+        auto& level = loaded.Find(added.Info).Levels[0];
+        if (added.Levels[0].size() > level.size())
+            level.insert(level.end(), added.Levels[0].begin() + level.size(), added.Levels[0].end());
+    }
+    for (auto& device : loaded.m_Devices)
+        device.Holding = false;
+
+    loaded.m_LastTimestamp = reader.LastTimestamp();
+    loaded.BuildLevels();
+    *this = std::move(loaded);
+    return true;
+}
+
+bool Pyramid::Query(size_t device, uint64_t start, uint64_t end, int columns, std::vector<Bucket>& out, int* level) const
+{
+    out.assign(std::max(columns, 0), Bucket());
+    if (device >= m_Devices.size() || columns <= 0 || end <= start)
+        return false;
+
+    // The coarsest level with buckets of at most half a column. A column merges at most five buckets,
+    // and the buckets it shares with its neighbours make it at most one column too wide.
+    uint64_t perColumn = (end - start) / columns;
+    if (perColumn < (2ull << PyramidBaseShift))
+        return false;
+    const auto& levels = m_Devices[device].Levels;
+    int found = 0;
+    while (found + 1 < (int)levels.size() && (2ull << (PyramidBaseShift + found + 1)) <= perColumn)
+        found++;
+    if (level)
+        *level = found;
+
+    const auto& buckets = levels[found];
+    uint32_t shift = PyramidBaseShift + found;
+    for (int column = 0; column < columns; ++column)
+    {
+        uint64_t from = start + (end - start) * column / columns;
+        uint64_t to = start + (end - start) * (column + 1) / columns;
+        if (to <= m_StartTimestamp)
+            continue;
+        uint64_t first = (std::max(from, m_StartTimestamp) - m_StartTimestamp) >> shift;
+        uint64_t last = std::min<uint64_t>((to - 1 - m_StartTimestamp) >> shift, buckets.size() - 1);
+        for (uint64_t n = first; n <= last && n < buckets.size(); ++n)
+            out[column].Merge(buckets[(size_t)n]);
+    }
+    return true;
+}
+
+
+void GD::Record::Decimate(const Reader& reader, const Pyramid* pyramid, uint16_t device, uint64_t start, uint64_t end, int columns, std::vector<Bucket>& out, int* level)
+{
+    if (pyramid)
+    {
+        int index = pyramid->FindDevice(device);
+        if (index >= 0 && pyramid->Query(index, start, end, columns, out, level))
+            return;
+    }
+    if (level)
+        *level = -1;
+    out.assign(std::max(columns, 0), Bucket());
+    if (columns <= 0 || end <= start)
+        return;
+
+    // Zoomed in this far only a few chunks are visible, so the records themselves are walked.
+    // Every state counts for all columns it was held in, up to the next record of the device.
+    auto hold = [&](const Sample& sample, uint64_t from, uint64_t to)
+        {
+            to = std::min(std::max(to, from + 1), end);
+            from = std::max(from, start);
+            if (from >= to)
+                return;
+            int first = (int)((from - start) * columns / (end - start));
+            int last = (int)((to - 1 - start) * columns / (end - start));
+            for (int column = first; column <= last; ++column)
+                out[column].Add(sample);
+        };
+
+    ChunkDecoder decoder;
+    for (size_t chunk = reader.FindChunk(start); chunk < reader.ChunkCount() && reader.Chunk(chunk).Timestamp < end; ++chunk)
+    {
+        if (!reader.BeginChunk(chunk, decoder))
+            break;
+
+        // The keyframe is the state at the start of the chunk
+        Sample held;
+        bool holding = false;
+        for (const auto& entry : decoder.Devices())
+        {
+            if (entry.Info.Id == device)
+            {
+                held = entry.State;
+                holding = true;
+            }
+        }
+        uint64_t since = reader.Chunk(chunk).Timestamp;
+
+        Sample sample;
+        while (decoder.Next(sample) && since < end)
+        {
+            if (sample.Device != device)
+                continue;
+            if (holding)
+                hold(held, since, sample.Timestamp);
+            held = sample;
+            since = sample.Timestamp;
+            holding = true;
+        }
+        uint64_t until = chunk + 1 < reader.ChunkCount() ? reader.Chunk(chunk + 1).Timestamp : reader.LastTimestamp();
+        if (holding)
+            hold(held, since, until);
+    }
+}
+
+bool GD::Record::BuildPyramid(const Reader& reader, Pyramid& pyramid)
+{
+    pyramid.Begin(reader.Header().StartTimestamp);
+    if (!AddChunks(reader, 0, pyramid))
+        return false;
+    pyramid.Finish(reader.LastTimestamp());
+    pyramid.BuildLevels();
+    return true;
+}
@@ -0,0 +1,321 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Search recordings for device states, using the chunk summaries
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordQuery.h"
+#include "record/gd_RecordReader.h"
+#include "gd_threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+using namespace GD::Record;
+
+
+Condition::Condition()
+{
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        Min[axis] = INT32_MIN;
+        Max[axis] = INT32_MAX;
+    }
+}
+
+bool Condition::Matches(const Sample& sample) const
+{
+    if (Device >= 0 && sample.Device != Device)
+        return false;
+    if ((sample.Buttons & ButtonsDown) != ButtonsDown || (sample.Buttons & ButtonsUp))
+        return false;
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        int32_t value = GD::GetAxis(sample, axis);
+        if (value < Min[axis] || value > Max[axis])
+            return false;
+    }
+    return true;
+}
+
+bool Condition::MayMatch(const ChunkSummary& summary) const
+{
+    if ((summary.ButtonsOr & ButtonsDown) != ButtonsDown || (summary.ButtonsAnd & ButtonsUp))
+        return false;
+    for (int axis = 0; axis < Axis_Count; ++axis)
+    {
+        if (summary.Max[axis] < Min[axis] || summary.Min[axis] > Max[axis])
+            return false;
+    }
+    return true;
+}
+
+
+bool GD::Record::ParseDuration(const char* text, uint64_t& duration)
+{
+    char* end;
+    double value = strtod(text, &end);
+    if (end == text || value < 0)
+        return false;
+    if (!strcmp(end, "us"))
+        duration = (uint64_t)value;
+    else if (!strcmp(end, "ms") || !*end)
+        duration = (uint64_t)(value * 1e3);
+    else if (!strcmp(end, "s"))
+        duration = (uint64_t)(value * 1e6);
+    else
+        return false;
+    return true;
+}
+
+static int FindAxis(const std::string& name)
+{
+    static const char* aliases[GD::Axis_Count] = { "LT", "RT", "LX", "LY", "RX", "RY" };
+    for (int axis = 0; axis < GD::Axis_Count; ++axis)
+    {
+        if (GD::EqualsNoCase(name, GD::AxisName(axis)) || GD::EqualsNoCase(name, aliases[axis]))
+            return axis;
+    }
+    return -1;
+}
+
+static bool ParseTerm(const std::string& term, Condition& condition, std::string& error)
+{
+    size_t op = term.find_first_of("<>=");
+    if (op == std::string::npos)
+    {
+        bool released = term[0] == '!';
+        uint16_t button = GD::FindButton(released ? term.substr(1) : term);
+        if (!button)
+        {
+            error = "Unknown button '" + term + "'";
+            return false;
+        }
+        (released ? condition.ButtonsUp : condition.ButtonsDown) |= button;
+        return true;
+    }
+
+    std::string name = term.substr(0, op);
+    size_t opEnd = term.find_first_not_of("<>=", op);
+    std::string oper = term.substr(op, opEnd == std::string::npos ? std::string::npos : opEnd - op);
+    std::string value = opEnd == std::string::npos ? std::string() : term.substr(opEnd);
+
+    if (GD::EqualsNoCase(name, "for"))
+    {
+        if ((oper != ">=" && oper != ">" && oper != "=") || !ParseDuration(value.c_str(), condition.MinDuration))
+        {
+            error = "Expected a duration like 'for>=2s'";
+            return false;
+        }
+        return true;
+    }
+
+    char* end;
+    long number = strtol(value.c_str(), &end, 0);
+    if (value.empty() || *end)
+    {
+        error = "Expected a number in '" + term + "'";
+        return false;
+    }
+
+    if (GD::EqualsNoCase(name, "device"))
+    {
+        if (oper != "=")
+        {
+            error = "Only 'device=N' is supported";
+            return false;
+        }
+        condition.Device = (int)number;
+        return true;
+    }
+
+    int axis = FindAxis(name);
+    if (axis < 0)
+    {
+        error = "Unknown axis '" + name + "'";
+        return false;
+    }
+
+    int32_t& lo = condition.Min[axis];
+    int32_t& hi = condition.Max[axis];
+    if (oper == ">")
+        lo = std::max(lo, (int32_t)number + 1);
+    else if (oper == ">=")
+        lo = std::max(lo, (int32_t)number);
+    else if (oper == "<")
+        hi = std::min(hi, (int32_t)number - 1);
+    else if (oper == "<=")
+        hi = std::min(hi, (int32_t)number);
+    else if (oper == "=" || oper == "==")
+    {
+        lo = std::max(lo, (int32_t)number);
+        hi = std::min(hi, (int32_t)number);
+    }
+    else
+    {
+        error = "Unknown operator '" + oper + "'";
+        return false;
+    }
+    return true;
+}
+
+bool GD::Record::ParseCondition(const char* text, Condition& condition, std::string& error)
+{
+    condition = Condition();
+    std::string term;
+    for (const char* cur = text;; ++cur)
+    {
+        if (*cur && *cur != ' ' && *cur != '\t' && *cur != '&' && *cur != ',')
+        {
+            term += *cur;
+            continue;
+        }
+        if (!term.empty() && !ParseTerm(term, condition, error))
+            return false;
+        term.clear();
+        if (!*cur)
+            return true;
+    }
+}
+
+
+// A range of consecutive chunks that passed the summary check
+struct CandidateRun
+{
+    uint32_t File;
+    size_t FirstChunk;
+    size_t LastChunk;
+};
+
+static void DecodeRun(const Condition& condition, const Reader& reader, const CandidateRun& run, std::vector<QueryMatch>& matches)
+{
+    struct Active
+    {
+        uint16_t Device;
+        uint64_t Start;
+    };
+    std::vector<Active> active;
+
+    auto close = [&](size_t index, uint64_t end)
+        {
+            if (end - active[index].Start >= condition.MinDuration)
+                matches.push_back({ run.File, active[index].Device, active[index].Start, end });
+            active.erase(active.begin() + index);
+        };
+    auto update = [&](const GD::Sample& sample)
+        {
+            bool match = condition.Matches(sample);
+            for (size_t n = 0; n < active.size(); ++n)
+            {
+                if (active[n].Device == sample.Device)
+                {
+                    if (!match)
+                        close(n, sample.Timestamp);
+                    return;
+                }
+            }
+            if (match)
+                active.push_back({ sample.Device, sample.Timestamp });
+        };
+
+    for (size_t chunk = run.FirstChunk; chunk <= run.LastChunk; ++chunk)
+    {
+        ChunkDecoder decoder;
+        if (!reader.BeginChunk(chunk, decoder))
+            break;
+
+        // Devices that are no longer part of the chunk stop matching at its start
+        uint64_t start = decoder.Header().FirstTimestamp;
+        for (size_t n = active.size(); n-- > 0;)
+        {
+            bool present = false;
+            for (const auto& device : decoder.Devices())
+                present = present || device.Info.Id == active[n].Device;
+            if (!present)
+                close(n, start);
+        }
+
+        for (const auto& device : decoder.Devices())
+        {
+            GD::Sample state = device.State;
+            state.Timestamp = start;
+            update(state);
+        }
+
+        GD::Sample sample;
+        while (decoder.Next(sample))
+            update(sample);
+    }
+
+    uint64_t end = run.LastChunk + 1 < reader.ChunkCount() ? reader.Chunk(run.LastChunk + 1).Timestamp : reader.LastTimestamp();
+    while (!active.empty())
+        close(active.size() - 1, end);
+}
+
+std::vector<QueryMatch> GD::Record::RunQuery(const Condition& condition, const std::vector<std::string>& files, unsigned threads, QueryStats* stats)
+{
+    GD::ThreadPool pool(threads);
+    std::vector<std::unique_ptr<Reader>> readers(files.size());
+    std::vector<CandidateRun> runs;
+    std::mutex lock;
+    std::atomic<uint64_t> chunks{ 0 }, decoded{ 0 };
+    std::atomic<uint32_t> failed{ 0 };
+
+    // First pass: only look at the summaries, and collect the chunks that could match
+    GD::ParallelFor(pool, files.size(), [&](size_t file)
+        {
+            auto reader = std::make_unique<Reader>();
+            if (!reader->Open(files[file].c_str()))
+            {
+                failed++;
+                return;
+            }
+
+            std::vector<CandidateRun> local;
+            for (size_t chunk = 0; chunk < reader->ChunkCount(); ++chunk)
+            {
+                ChunkHeader header;
+                ChunkSummary summary;
+                reader->ReadChunkHeader(chunk, header, summary);
+                if (!condition.MayMatch(summary))
+                    continue;
+
+                if (!local.empty() && local.back().LastChunk + 1 == chunk)
+                    local.back().LastChunk = chunk;
+                else
+                    local.push_back({ (uint32_t)file, chunk, chunk });
+                decoded++;
+            }
+            chunks += reader->ChunkCount();
+
+            std::unique_lock<std::mutex> guard(lock);
+            runs.insert(runs.end(), local.begin(), local.end());
+            readers[file] = std::move(reader);
+        });
+
+    // Second pass: decode the candidates, a state can only carry over between chunks of the same run
+    std::vector<std::vector<QueryMatch>> results(runs.size());
+    GD::ParallelFor(pool, runs.size(), [&](size_t n)
+        {
+            DecodeRun(condition, *readers[runs[n].File], runs[n], results[n]);
+        });
+
+    std::vector<QueryMatch> matches;
+    for (const auto& result : results)
+        matches.insert(matches.end(), result.begin(), result.end());
+    std::sort(matches.begin(), matches.end(), [](const QueryMatch& a, const QueryMatch& b)
+        {
+            return a.File != b.File ? a.File < b.File : a.Start < b.Start;
+        });
+
+    if (stats)
+    {
+        stats->Chunks = chunks;
+        stats->DecodedChunks = decoded;
+        stats->FailedFiles = failed;
+    }
+    return matches;
+}
@@ -0,0 +1,196 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Random access to recordings through the chunk index
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordReader.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace GD::Record;
+
+
+bool Reader::Fail(const char* error)
+{
+    Close();
+    m_Error = error;
+    return false;
+}
+
+bool Reader::Open(const char* path)
+{
+    Close();
+    m_Error.clear();
+
+    if (!m_File.Open(path))
+        return Fail("Unable to open file");
+
+    const uint8_t* data = m_File.Data();
+    size_t size = m_File.Size();
+    if (size < sizeof(FileHeader) + sizeof(Footer))
+        return Fail("File too small");
+
+    memcpy(&m_Header, data, sizeof(m_Header));
+    if (m_Header.Magic != FileMagic)
+        return Fail("Not a recording");
+    if (m_Header.Version != FormatVersion)
+        return Fail("Unsupported recording version");
+
+    Footer footer;
+    memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+    if (footer.Magic != FooterMagic || footer.IndexOffset % 8 != 0 || footer.IndexOffset > size - sizeof(footer) ||
+        footer.IndexCount > (size - sizeof(footer) - footer.IndexOffset) / sizeof(IndexEntry) ||
+        Crc32(data + footer.IndexOffset, footer.IndexCount * sizeof(IndexEntry)) != footer.Checksum)
+    {
+        return Fail("Missing or damaged index");
+    }
+
+    m_Index = (const IndexEntry*)(data + footer.IndexOffset);
+    m_IndexCount = footer.IndexCount;
+    m_IndexOffset = footer.IndexOffset;
+    ChunkDecoder decoder;
+    m_Damaged.assign(m_IndexCount, false);
+    for (size_t n = 0; n < m_IndexCount; ++n)
+    {
+        if (m_Index[n].Offset + sizeof(ChunkHeader) + sizeof(ChunkSummary) > footer.IndexOffset)
+            return Fail("Index points outside of the file");
+        m_Damaged[n] = !decoder.Begin(data + m_Index[n].Offset, size - (size_t)m_Index[n].Offset);
+    }
+
+    m_LastTimestamp = m_Header.StartTimestamp;
+    if (m_IndexCount)
+    {
+        ChunkHeader last;
+        memcpy(&last, data + m_Index[m_IndexCount - 1].Offset, sizeof(last));
+        m_LastTimestamp = last.LastTimestamp;
+    }
+    return true;
+}
+
+void Reader::Close()
+{
+    m_File.Close();
+    m_Index = nullptr;
+    m_IndexCount = 0;
+    m_IndexOffset = 0;
+    m_LastTimestamp = 0;
+    m_Damaged.clear();
+}
+
+size_t Reader::FindChunk(uint64_t timestamp) const
+{
+    const IndexEntry* end = m_Index + m_IndexCount;
+    const IndexEntry* it = std::upper_bound(m_Index, end, timestamp,
+        [](uint64_t value, const IndexEntry& entry) { return value < entry.Timestamp; });
+    return it == m_Index ? 0 : (size_t)(it - m_Index) - 1;
+}
+
+bool Reader::BeginChunk(size_t index, ChunkDecoder& decoder) const
+{
+    if (index >= m_IndexCount || m_Damaged[index])
+        return false;
+    uint64_t offset = m_Index[index].Offset;
+    return decoder.Begin(m_File.Data() + offset, m_File.Size() - (size_t)offset, false);
+}
+
+void Reader::ReadChunkHeader(size_t index, ChunkHeader& header, ChunkSummary& summary) const
+{
+    const uint8_t* chunk = m_File.Data() + m_Index[index].Offset;
+    memcpy(&header, chunk, sizeof(header));
+    memcpy(&summary, chunk + sizeof(header), sizeof(summary));
+}
+
+bool Reader::Seek(uint64_t timestamp, std::vector<KeyframeEntry>& devices) const
+{
+    ChunkDecoder decoder;
+    if (!BeginChunk(FindChunk(timestamp), decoder))
+        return false;
+
+    devices = decoder.Devices();
+    Sample sample;
+    while (decoder.Next(sample) && sample.Timestamp <= timestamp)
+    {
+        for (auto& device : devices)
+        {
+            if (device.Info.Id == sample.Device)
+                device.State = sample;
+        }
+    }
+    return true;
+}
+
+void Reader::ReadLog(std::vector<LogRecord>& records) const
+{
+    records.clear();
+    const uint8_t* data = m_File.Data();
+    uint64_t offset = sizeof(FileHeader);
+    while (offset + 2 * sizeof(uint32_t) <= m_IndexOffset)
+    {
+        // Chunks are skipped by their size, only log blocks are decoded
+        uint32_t magic, payload;
+        memcpy(&magic, data + offset, sizeof(magic));
+        memcpy(&payload, data + offset + sizeof(magic), sizeof(payload));
+        if (magic == ChunkMagic)
+        {
+            offset += sizeof(ChunkHeader) + payload;
+        }
+        else if (magic == LogMagic)
+        {
+            DecodeLogBlock(data + offset, (size_t)(m_IndexOffset - offset), records);
+            offset += sizeof(LogBlockHeader) + payload;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+bool Reader::FindDevice(int id, DeviceInfo& info) const
+{
+    ChunkDecoder decoder;
+    for (size_t chunk = 0; chunk < m_IndexCount; ++chunk)
+    {
+        if (!BeginChunk(chunk, decoder))
+            return false;
+        for (const auto& device : decoder.Devices())
+        {
+            if (id < 0 || device.Info.Id == id)
+            {
+                info = device.Info;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool SampleStream::Next(Sample& sample)
+{
+    for (;;)
+    {
+        if (m_Started && m_Decoder.Next(sample))
+            return true;
+
+        size_t next = m_Started ? m_Chunk + 1 : 0;
+        if (next >= m_Reader.ChunkCount())
+            return false;
+        m_Chunk = next;
+        m_Started = m_Reader.BeginChunk(m_Chunk, m_Decoder);
+        if (!m_Started)
+            return false;
+    }
+}
+
+bool DeviceStream::Next(Sample& sample)
+{
+    while (m_Stream.Next(sample))
+    {
+        if (sample.Device == m_Device)
+        {
+            sample.Timestamp = (uint64_t)((int64_t)sample.Timestamp + m_Offset);
+            return true;
+        }
+    }
+    return false;
+}
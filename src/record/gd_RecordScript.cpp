@@ -0,0 +1,338 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Scripted input tests, run against live devices or recordings
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordScript.h"
+#include "record/gd_RecordReader.h"
+#include "gd_file.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+using namespace GD::Record;
+
+
+static std::string Trim(const std::string& text)
+{
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+        return std::string();
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+static bool ParseStep(const std::string& text, ScriptStep& step, std::string& error)
+{
+    // The condition is everything except "within <duration>"
+    std::string condition;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t start = text.find_first_not_of(" \t", pos);
+        if (start == std::string::npos)
+            break;
+        size_t end = text.find_first_of(" \t", start);
+        std::string word = text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        pos = end == std::string::npos ? text.size() : end;
+
+        if (word != "within")
+        {
+            condition += word + " ";
+            continue;
+        }
+        size_t valueStart = text.find_first_not_of(" \t", pos);
+        if (valueStart == std::string::npos)
+        {
+            error = "Expected a duration after 'within'";
+            return false;
+        }
+        size_t valueEnd = text.find_first_of(" \t", valueStart);
+        std::string value = text.substr(valueStart, valueEnd == std::string::npos ? std::string::npos : valueEnd - valueStart);
+        if (!ParseDuration(value.c_str(), step.Within) || !step.Within)
+        {
+            error = "Invalid duration '" + value + "'";
+            return false;
+        }
+        pos = valueEnd == std::string::npos ? text.size() : valueEnd;
+    }
+
+    step.Text = text;
+    return ParseCondition(condition.c_str(), step.When, error);
+}
+
+bool GD::Record::ParseScript(const char* text, Script& script, std::string& error)
+{
+    script = Script();
+    int line = 0;
+    for (const char* cur = text; *cur;)
+    {
+        const char* end = strchr(cur, '\n');
+        std::string content(cur, end ? end : cur + strlen(cur));
+        cur = end ? end + 1 : cur + content.size();
+        line++;
+
+        size_t comment = content.find('#');
+        if (comment != std::string::npos)
+            content.resize(comment);
+        content = Trim(content);
+        if (content.empty())
+            continue;
+
+        if (content.compare(0, 5, "test ") == 0 || content == "test")
+        {
+            if (!script.Tests.empty() && script.Tests.back().Steps.empty())
+            {
+                error = "line " + std::to_string(line) + ": the test before it has no steps";
+                return false;
+            }
+            script.Tests.emplace_back();
+            script.Tests.back().Name = Trim(content.substr(4));
+            if (script.Tests.back().Name.empty())
+                script.Tests.back().Name = "Test " + std::to_string(script.Tests.size());
+            continue;
+        }
+        if (script.Tests.empty())
+        {
+            error = "line " + std::to_string(line) + ": a step needs a 'test <name>' line before it";
+            return false;
+        }
+
+        ScriptStep step;
+        step.Line = line;
+        std::string message;
+        if (!ParseStep(content, step, message))
+        {
+            error = "line " + std::to_string(line) + ": " + message;
+            return false;
+        }
+        script.Tests.back().Steps.push_back(step);
+    }
+
+    if (script.Tests.empty() || script.Tests.back().Steps.empty())
+    {
+        error = script.Tests.empty() ? "The script has no tests" : "The last test has no steps";
+        return false;
+    }
+    return true;
+}
+
+bool GD::Record::LoadScript(const char* path, Script& script, std::string& error)
+{
+    FILE* file = GD::OpenFile(path, "rb");
+    if (!file)
+    {
+        error = std::string("Failed to open ") + path;
+        return false;
+    }
+    std::string text;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, read);
+    fclose(file);
+    return ParseScript(text.c_str(), script, error);
+}
+
+
+bool TestResult::TightestMargin(const ScriptTest& test, int64_t& margin) const
+{
+    bool found = false;
+    for (size_t n = 0; n < Steps.size() && n < test.Steps.size(); ++n)
+    {
+        if (!test.Steps[n].Within)
+            continue;
+        margin = found ? std::min(margin, Steps[n].Margin) : Steps[n].Margin;
+        found = true;
+    }
+    return found;
+}
+
+
+ScriptMatcher::ScriptMatcher(const Script& script)
+    : m_Script(script)
+    , m_Results(script.Tests.size())
+{
+}
+
+size_t ScriptMatcher::Failed() const
+{
+    return (size_t)std::count_if(m_Results.begin(), m_Results.end(), [](const TestResult& result) { return result.State == Test_Failed; });
+}
+
+void ScriptMatcher::Begin(uint64_t timestamp)
+{
+    m_Step = 0;
+    m_Holding = false;
+    m_Reference = timestamp;
+    if (Done())
+        return;
+    m_Results[m_Test].State = Test_Running;
+    m_Results[m_Test].Start = timestamp;
+}
+
+void ScriptMatcher::Fail(uint64_t timestamp, const std::string& message)
+{
+    const ScriptStep& step = m_Script.Tests[m_Test].Steps[m_Step];
+    TestResult& result = m_Results[m_Test];
+    result.State = Test_Failed;
+    result.End = timestamp;
+    result.Message = "step " + std::to_string(m_Step + 1) + " '" + step.Text + "' " + message;
+    m_Test++;
+    Begin(timestamp);
+}
+
+// Moves on with the current state, which holds from m_Since up to now
+void ScriptMatcher::Settle(uint64_t now)
+{
+    while (!Done())
+    {
+        const ScriptStep& step = m_Script.Tests[m_Test].Steps[m_Step];
+        uint64_t deadline = step.Within ? m_Reference + step.Within : UINT64_MAX;
+        if (!step.When.Matches(m_State))
+        {
+            m_Holding = false;
+            if (now <= deadline)
+                return;
+            Fail(deadline, "did not happen in time");
+            continue;
+        }
+
+        // A state that already matches when the step begins counts from the begin of the step
+        if (!m_Holding)
+        {
+            m_Holding = true;
+            m_HoldStart = std::max(m_Since, m_Reference);
+        }
+        if (m_HoldStart > deadline)
+        {
+            Fail(deadline, "did not happen in time");
+            continue;
+        }
+        uint64_t end = m_HoldStart + step.When.MinDuration;
+        if (end > now)
+            return;
+
+        StepResult passed;
+        passed.Start = m_HoldStart;
+        passed.End = end;
+        passed.Margin = step.Within ? (int64_t)(deadline - m_HoldStart) : 0;
+        TestResult& result = m_Results[m_Test];
+        result.Steps.push_back(passed);
+
+        m_Holding = false;
+        m_Reference = end;
+        if (++m_Step < m_Script.Tests[m_Test].Steps.size())
+            continue;
+        result.State = Test_Passed;
+        result.End = end;
+        m_Test++;
+        Begin(end);
+    }
+}
+
+void ScriptMatcher::Add(const Sample& sample)
+{
+    if (!m_Started)
+    {
+        m_Started = true;
+        Begin(sample.Timestamp);
+    }
+    else
+    {
+        // The previous state held until this sample
+        Settle(std::max(sample.Timestamp, m_Since));
+    }
+    m_State = sample;
+    m_Since = std::max(sample.Timestamp, m_Since);
+    Settle(m_Since);
+}
+
+void ScriptMatcher::Advance(uint64_t now)
+{
+    if (m_Started)
+        Settle(std::max(now, m_Since));
+}
+
+void ScriptMatcher::Finish(uint64_t timestamp)
+{
+    if (!m_Started)
+    {
+        m_Started = true;
+        Begin(timestamp);
+    }
+    Settle(std::max(timestamp, m_Since));
+    if (Done())
+        return;
+
+    const ScriptStep& step = m_Script.Tests[m_Test].Steps[m_Step];
+    if (m_Holding && step.When.MinDuration)
+        Fail(timestamp, "was held for only " + std::to_string((timestamp - m_HoldStart) / 1000) + " ms");
+    else
+        Fail(timestamp, "was not seen");
+    // The tests after it never ran
+    while (!Done())
+    {
+        m_Results[m_Test].State = Test_Failed;
+        m_Results[m_Test].Start = m_Results[m_Test].End = timestamp;
+        m_Results[m_Test].Message = "not started";
+        m_Test++;
+    }
+}
+
+
+bool GD::Record::RunScript(const Script& script, const char* recording, std::vector<ScriptDeviceResult>& results, std::string& error)
+{
+    results.clear();
+    Reader reader;
+    if (!reader.Open(recording))
+    {
+        error = reader.Error();
+        return false;
+    }
+
+    struct DeviceRun
+    {
+        DeviceInfo Info;
+        ScriptMatcher Matcher;
+    };
+    std::vector<DeviceRun> runs;
+
+    // The devices that are there from the start begin with their keyframe state
+    std::vector<KeyframeEntry> devices;
+    reader.Seek(reader.FirstTimestamp(), devices);
+    for (const auto& device : devices)
+    {
+        runs.push_back({ device.Info, ScriptMatcher(script) });
+        Sample state = device.State;
+        state.Timestamp = reader.FirstTimestamp();
+        runs.back().Matcher.Add(state);
+    }
+
+    SampleStream stream(reader);
+    Sample sample;
+    while (stream.Next(sample))
+    {
+        auto it = std::find_if(runs.begin(), runs.end(), [&sample](const DeviceRun& run) { return run.Info.Id == sample.Device; });
+        if (it == runs.end())
+        {
+            DeviceInfo info{};
+            info.Id = sample.Device;
+            for (const auto& device : stream.Devices())
+            {
+                if (device.Info.Id == sample.Device)
+                    info = device.Info;
+            }
+            runs.push_back({ info, ScriptMatcher(script) });
+            it = runs.end() - 1;
+        }
+        it->Matcher.Add(sample);
+    }
+
+    for (auto& run : runs)
+    {
+        run.Matcher.Finish(reader.LastTimestamp());
+        results.push_back({ run.Info, run.Matcher.Results() });
+    }
+    return true;
+}
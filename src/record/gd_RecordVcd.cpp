@@ -0,0 +1,320 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Export recordings as Value Change Dump files for waveform viewers
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordExport.h"
+#include "record/gd_RecordReader.h"
+#include <algorithm>
+#include <ctime>
+#include <vector>
+
+using namespace GD::Record;
+
+// Per device: a 'connected' wire, one wire per button bit and one real per axis
+constexpr int ButtonSignals = 16;
+constexpr int SignalConnected = 0;
+constexpr int SignalFirstButton = 1;
+constexpr int SignalFirstAxis = SignalFirstButton + ButtonSignals;
+constexpr int SignalsPerDevice = SignalFirstAxis + GD::Axis_Count;
+constexpr size_t OutputBuffer = 1 << 16;
+
+struct DeviceSignals
+{
+    GD::DeviceInfo Info;
+    GD::Sample State;
+    bool Connected = false;
+    bool Known = false;     // State holds the values that were written last
+};
+
+class VcdWriter
+{
+public:
+    explicit VcdWriter(FILE* file) : m_File(file) { m_Buffer.reserve(OutputBuffer + 256); }
+
+    void Text(const char* text) { m_Buffer += text; }
+
+    // Identifiers are the printable characters '!' to '~', as a base 94 number
+    void Identifier(size_t index)
+    {
+        do
+        {
+            m_Buffer += (char)('!' + index % 94);
+            index /= 94;
+        } while (index);
+    }
+
+    void Number(int64_t value)
+    {
+        char digits[24];
+        int count = 0;
+        uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+        do
+        {
+            digits[count++] = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+        if (value < 0)
+            m_Buffer += '-';
+        while (count)
+            m_Buffer += digits[--count];
+    }
+
+    // Starts a new timestamp before the first change at that time
+    void Time(uint64_t time)
+    {
+        if (m_HasTime && time <= m_Time)
+            return;
+        m_Buffer += '#';
+        Number((int64_t)time);
+        m_Buffer += '\n';
+        m_Time = time;
+        m_HasTime = true;
+    }
+
+    void Bit(char value, size_t id)
+    {
+        m_Buffer += value;
+        Identifier(id);
+        m_Buffer += '\n';
+        Flush(false);
+    }
+
+    void Real(int32_t value, size_t id)
+    {
+        m_Buffer += 'r';
+        Number(value);
+        m_Buffer += ' ';
+        Identifier(id);
+        m_Buffer += '\n';
+        Flush(false);
+    }
+
+    void Flush(bool always)
+    {
+        if (always || m_Buffer.size() >= OutputBuffer)
+        {
+            fwrite(m_Buffer.data(), 1, m_Buffer.size(), m_File);
+            m_Buffer.clear();
+        }
+    }
+
+private:
+    FILE* m_File;
+    std::string m_Buffer;
+    uint64_t m_Time = 0;
+    bool m_HasTime = false;
+};
+
+static size_t SignalId(size_t device, int signal)
+{
+    return device * SignalsPerDevice + signal;
+}
+
+static void WriteHeader(VcdWriter& out, const FileHeader& header, const std::vector<DeviceSignals>& devices)
+{
+    time_t seconds = (time_t)(header.StartUnixTime / 1000000);
+    char date[64] = "";
+    if (const tm* utc = gmtime(&seconds))
+        strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S UTC", utc);
+
+    out.Text("$date ");
+    out.Text(date);
+    out.Text(" $end\n$version GamepadDebug $end\n$timescale 1us $end\n");
+
+    for (size_t n = 0; n < devices.size(); ++n)
+    {
+        const auto& info = devices[n].Info;
+        char line[128];
+        snprintf(line, sizeof(line), "$scope module xuser%u_device%u $end\n$comment %04X / %04X / %04X $end\n",
+            info.Slot, info.Id, info.VendorId, info.ProductId, info.ProductVersion);
+        out.Text(line);
+
+        out.Text("$var wire 1 ");
+        out.Identifier(SignalId(n, SignalConnected));
+        out.Text(" connected $end\n");
+        for (int bit = 0; bit < ButtonSignals; ++bit)
+        {
+            if (!GD::ButtonName(bit))
+                continue;
+            out.Text("$var wire 1 ");
+            out.Identifier(SignalId(n, SignalFirstButton + bit));
+            out.Text(" ");
+            out.Text(GD::ButtonName(bit));
+            out.Text(" $end\n");
+        }
+        for (int axis = 0; axis < GD::Axis_Count; ++axis)
+        {
+            out.Text("$var real 64 ");
+            out.Identifier(SignalId(n, SignalFirstAxis + axis));
+            out.Text(" ");
+            out.Text(GD::AxisName(axis));
+            out.Text(" $end\n");
+        }
+        out.Text("$upscope $end\n");
+    }
+    out.Text("$enddefinitions $end\n");
+}
+
+// Writes the signals of a device that differ from what was written before
+static void WriteChanges(VcdWriter& out, DeviceSignals& device, size_t index, uint64_t time, const GD::Sample& state)
+{
+    uint16_t buttons = device.Known ? (uint16_t)(device.State.Buttons ^ state.Buttons) : 0xffff;
+    bool axes = !device.Known || device.State.LeftTrigger != state.LeftTrigger || device.State.RightTrigger != state.RightTrigger ||
+        device.State.ThumbLX != state.ThumbLX || device.State.ThumbLY != state.ThumbLY ||
+        device.State.ThumbRX != state.ThumbRX || device.State.ThumbRY != state.ThumbRY;
+    buttons &= ~0x0800;     // Bit 11 has no button
+    if (!buttons && !axes)
+        return;
+
+    out.Time(time);
+    while (buttons)
+    {
+        int bit = 0;
+        while (!(buttons & (1u << bit)))
+            bit++;
+        buttons &= (uint16_t)~(1u << bit);
+        out.Bit((state.Buttons & (1u << bit)) ? '1' : '0', SignalId(index, SignalFirstButton + bit));
+    }
+    if (axes)
+    {
+        for (int axis = 0; axis < GD::Axis_Count; ++axis)
+        {
+            int32_t value = GD::GetAxis(state, axis);
+            if (!device.Known || GD::GetAxis(device.State, axis) != value)
+                out.Real(value, SignalId(index, SignalFirstAxis + axis));
+        }
+    }
+    device.State = state;
+    device.Known = true;
+}
+
+static void WriteConnected(VcdWriter& out, DeviceSignals& device, size_t index, uint64_t time, bool connected)
+{
+    if (device.Connected == connected)
+        return;
+    out.Time(time);
+    out.Bit(connected ? '1' : '0', SignalId(index, SignalConnected));
+    device.Connected = connected;
+    if (connected)
+        return;
+
+    // The buttons of a device that is gone are unknown, until it comes back.
+    // A real has no unknown value, so the axes keep their last value.
+    for (int bit = 0; bit < ButtonSignals; ++bit)
+    {
+        if (GD::ButtonName(bit))
+            out.Bit('x', SignalId(index, SignalFirstButton + bit));
+    }
+    device.Known = false;
+}
+
+bool GD::Record::ExportVcd(const char* recording, const char* output, std::string& error)
+{
+    Reader reader;
+    if (!reader.Open(recording))
+    {
+        error = reader.Error();
+        return false;
+    }
+
+    // The variables are declared up front, so collect the devices from the keyframes first.
+    // Devices are only added or removed at a chunk boundary, so the keyframes name all of them.
+    std::vector<DeviceSignals> devices;
+    ChunkDecoder decoder;
+    for (size_t chunk = 0; chunk < reader.ChunkCount(); ++chunk)
+    {
+        if (!reader.BeginChunk(chunk, decoder))
+            continue;
+        for (const auto& entry : decoder.Devices())
+        {
+            auto it = std::find_if(devices.begin(), devices.end(), [&](const DeviceSignals& device)
+                {
+                    return device.Info.Id == entry.Info.Id;
+                });
+            if (it == devices.end())
+            {
+                devices.emplace_back();
+                devices.back().Info = entry.Info;
+            }
+        }
+    }
+
+    FILE* file = GD::OpenFile(output, "wb");
+    if (!file)
+    {
+        error = "Unable to create the output file";
+        return false;
+    }
+
+    VcdWriter out(file);
+    WriteHeader(out, reader.Header(), devices);
+
+    out.Text("$dumpvars\n");
+    for (size_t n = 0; n < devices.size(); ++n)
+    {
+        out.Bit('0', SignalId(n, SignalConnected));
+        for (int bit = 0; bit < ButtonSignals; ++bit)
+        {
+            if (GD::ButtonName(bit))
+                out.Bit('x', SignalId(n, SignalFirstButton + bit));
+        }
+    }
+    out.Text("$end\n");
+
+    // Times are relative to the start of the recording, and never go back
+    uint64_t first = reader.FirstTimestamp();
+    uint64_t time = 0;
+    auto relative = [&](uint64_t timestamp)
+        {
+            time = std::max(time, timestamp > first ? timestamp - first : 0);
+            return time;
+        };
+
+    std::vector<size_t> present;    // Index in devices for every device of the current chunk
+    for (size_t chunk = 0; chunk < reader.ChunkCount(); ++chunk)
+    {
+        if (!reader.BeginChunk(chunk, decoder))
+            continue;
+
+        uint64_t start = relative(reader.Chunk(chunk).Timestamp);
+        present.clear();
+        for (const auto& entry : decoder.Devices())
+        {
+            for (size_t n = 0; n < devices.size(); ++n)
+            {
+                if (devices[n].Info.Id == entry.Info.Id)
+                    present.push_back(n);
+            }
+        }
+        for (size_t n = 0; n < devices.size(); ++n)
+        {
+            bool connected = std::find(present.begin(), present.end(), n) != present.end();
+            WriteConnected(out, devices[n], n, start, connected);
+        }
+        // The keyframe holds the state before the first record
+        for (size_t k = 0; k < present.size(); ++k)
+            WriteChanges(out, devices[present[k]], present[k], start, decoder.State(k));
+
+        GD::Sample sample;
+        while (decoder.Next(sample))
+        {
+            const auto& entries = decoder.Devices();
+            for (size_t k = 0; k < entries.size(); ++k)
+            {
+                if (entries[k].Info.Id == sample.Device)
+                {
+                    WriteChanges(out, devices[present[k]], present[k], relative(sample.Timestamp), sample);
+                    break;
+                }
+            }
+        }
+    }
+    out.Flush(true);
+
+    bool ok = !ferror(file);
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        error = "Unable to write the output file";
+    return ok;
+}
@@ -0,0 +1,390 @@
+// PROJECT:     Gamepad Debug
+// LICENSE:     MIT (https://spdx.org/licenses/MIT.html)
+// PURPOSE:     Write controller samples to a recording
+// COPYRIGHT:   Copyright 2025 Mark Jansen <mark.jansen@reactos.org>
+
+#include "record/gd_RecordWriter.h"
+#include "gd_file.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace GD::Record;
+
+
+// Pads the file, then writes the index entries and the footer. Returns the number of bytes written.
+static uint64_t WriteIndex(FILE* file, uint64_t offset, const std::vector<IndexEntry>& index)
+{
+    uint64_t start = offset;
+
+    // The index is read in-place from a mapping, so keep it aligned
+    static const uint8_t padding[8]{};
+    offset += fwrite(padding, 1, (8 - offset % 8) % 8, file);
+
+    Footer footer;
+    footer.IndexOffset = offset;
+    footer.IndexCount = (uint32_t)index.size();
+    footer.Checksum = Crc32(index.data(), index.size() * sizeof(IndexEntry));
+    if (!index.empty())
+        offset += fwrite(index.data(), sizeof(IndexEntry), index.size(), file) * sizeof(IndexEntry);
+    offset += fwrite(&footer, 1, sizeof(footer), file);
+    return offset - start;
+}
+
+bool Writer::Open(const char* path, uint32_t keyframeInterval, bool background, uint64_t startTimestamp)
+{
+    Close();
+
+    m_File = GD::OpenFile(path, "wb");
+    if (!m_File)
+        return false;
+
+    m_Header = {};
+    m_Header.StartTimestamp = startTimestamp ? startTimestamp : GD::Now();
+    m_Header.StartUnixTime = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    m_Header.KeyframeInterval = keyframeInterval;
+    m_Path = path;
+    m_Pyramid.Begin(m_Header.StartTimestamp);
+    // Without the overview the recording still works, it is then built when it is opened
+    m_PyramidFile = GD::OpenFile((m_Path + PyramidExtension).c_str(), "wb");
+    if (m_PyramidFile && !m_Pyramid.WriteHeader(m_PyramidFile, 0))
+    {
+        fclose(m_PyramidFile);
+        m_PyramidFile = nullptr;
+    }
+    m_LastTimestamp = m_ChunkTimestamp = m_Header.StartTimestamp;
+
+    m_ChunkOpen = false;
+    m_Devices.clear();
+    m_Index.clear();
+    if (!m_Queue)
+        m_Queue.reset(new Command[WriterQueueSize]);
+    m_QueueHead = m_QueueTail = 0;
+    m_Dropped = 0;
+    m_LogQueue.clear();
+    m_Log.clear();
+    m_Stop = false;
+    m_Offset = fwrite(&m_Header, 1, sizeof(m_Header), m_File);
+    GD::SyncFile(m_File);
+
+    if (background)
+        m_Thread = std::thread(&Writer::ThreadProc, this);
+    return true;
+}
+
+void Writer::Close()
+{
+    if (!m_File)
+        return;
+
+    if (m_Thread.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Lock);
+            m_Stop = true;
+        }
+        m_Wake.notify_one();
+        m_Thread.join();
+    }
+
+    FlushChunk();
+    FlushLog();
+    m_Offset += WriteIndex(m_File, m_Offset, m_Index);
+    GD::SyncFile(m_File);
+
+    fclose(m_File);
+    m_File = nullptr;
+
+    // Ends where a reader sees the recording end, the upper levels are built when it is loaded
+    if (m_PyramidFile)
+    {
+        m_Pyramid.Finish(m_ChunkTimestamp);
+        if (!m_Index.empty())
+            m_Pyramid.AppendFinished(m_PyramidFile, (uint32_t)m_Index.size() - 1, m_Index.back().Timestamp);
+        m_Pyramid.WriteHeader(m_PyramidFile, (uint32_t)m_Index.size());
+        GD::SyncFile(m_PyramidFile);
+        fclose(m_PyramidFile);
+        m_PyramidFile = nullptr;
+    }
+    m_Pyramid.Begin(0);
+    m_Index.clear();
+    m_Devices.clear();
+    m_Log.clear();
+}
+
+void Writer::AddDevice(const DeviceInfo& info, const Sample& state)
+{
+    if (!m_File)
+        return;
+    while (!Queue({ Command_AddDevice, info, state }))
+        std::this_thread::yield();
+}
+
+void Writer::RemoveDevice(uint16_t id)
+{
+    if (m_File)
+    {
+        Command command{};
+        command.Type = Command_RemoveDevice;
+        command.Info.Id = id;
+        while (!Queue(command))
+            std::this_thread::yield();
+    }
+}
+
+void Writer::Append(const Sample& sample)
+{
+    if (m_File && !Queue({ Command_Sample, {}, sample }))
+        m_Dropped++;
+}
+
+void Writer::AppendLog(uint64_t timestamp, const char* text, size_t length)
+{
+    if (!m_File)
+        return;
+
+    LogRecord record;
+    record.Timestamp = timestamp;
+    record.Text.assign(text, length);
+    if (!m_Thread.joinable())
+    {
+        m_Log.push_back(std::move(record));
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_Lock);
+    m_LogQueue.push_back(std::move(record));
+}
+
+bool Writer::Queue(const Command& command)
+{
+    if (!m_Thread.joinable())
+    {
+        Process(command);
+        return true;
+    }
+
+    // The writer thread wakes up on its own, so we do not pay for a notify on every sample
+    size_t head = m_QueueHead.load(std::memory_order_relaxed);
+    if (head - m_QueueTail.load(std::memory_order_acquire) == WriterQueueSize)
+        return false;
+    m_Queue[head % WriterQueueSize] = command;
+    m_QueueHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+void Writer::ThreadProc()
+{
+    bool stop = false;
+    while (!stop)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Lock);
+            m_Wake.wait_for(lock, std::chrono::milliseconds(50), [this]() { return m_Stop; });
+            stop = m_Stop;
+            for (auto& record : m_LogQueue)
+                m_Log.push_back(std::move(record));
+            m_LogQueue.clear();
+        }
+
+        // Every slot is handed back as soon as it is processed, so a slow write does not drop more than it has to
+        size_t head = m_QueueHead.load(std::memory_order_acquire);
+        for (size_t tail = m_QueueTail.load(std::memory_order_relaxed); tail != head; ++tail)
+        {
+            Process(m_Queue[tail % WriterQueueSize]);
+            m_QueueTail.store(tail + 1, std::memory_order_release);
+        }
+
+        // Log lines ride along with the chunks, unless there are no samples for a while
+        if (!m_Log.empty() && GD::Now() - m_Log.front().Timestamp >= m_Header.KeyframeInterval)
+            FlushLog();
+    }
+}
+
+void Writer::Process(const Command& command)
+{
+    switch (command.Type)
+    {
+    case Command_AddDevice:
+    case Command_RemoveDevice:
+        for (auto it = m_Devices.begin(); it != m_Devices.end(); ++it)
+        {
+            if (it->Info.Id == command.Info.Id)
+            {
+                FlushChunk();
+                m_Devices.erase(it);
+                break;
+            }
+        }
+        if (command.Type == Command_RemoveDevice && m_PyramidFile)
+            m_Pyramid.RemoveDevice(command.Info.Id);
+        if (command.Type == Command_AddDevice)
+        {
+            FlushChunk();
+            KeyframeEntry entry;
+            entry.Info = command.Info;
+            entry.State = command.State;
+            entry.State.Device = command.Info.Id;
+            m_Devices.push_back(entry);
+
+            // The state can be older than the recording, it is held from the moment the device was added
+            Sample state = entry.State;
+            state.Timestamp = std::max(state.Timestamp, m_LastTimestamp);
+            if (m_PyramidFile)
+                m_Pyramid.Add(entry.Info, state);
+        }
+        break;
+
+    case Command_Sample:
+    {
+        const Sample& sample = command.State;
+        KeyframeEntry* device = nullptr;
+        for (auto& entry : m_Devices)
+        {
+            if (entry.Info.Id == sample.Device)
+                device = &entry;
+        }
+        if (!device)
+            break;
+
+        if (m_ChunkOpen)
+        {
+            const auto& header = m_Encoder.Header();
+            if (sample.Timestamp - header.FirstTimestamp >= m_Header.KeyframeInterval || header.PayloadSize >= MaxChunkPayload)
+                FlushChunk();
+        }
+
+        if (!m_ChunkOpen)
+        {
+            // The keyframe holds the state just before the first record of the chunk
+            m_Encoder.Begin(m_Devices, sample.Timestamp);
+            m_ChunkOpen = true;
+        }
+
+        m_Encoder.Add(sample);
+        device->State = sample;
+        if (m_PyramidFile)
+            m_Pyramid.Add(device->Info, sample);
+        m_LastTimestamp = std::max(m_LastTimestamp, sample.Timestamp);
+        break;
+    }
+    }
+}
+
+void Writer::FlushChunk()
+{
+    if (!m_ChunkOpen)
+        return;
+    m_ChunkOpen = false;
+
+    ChunkHeader header = m_Encoder.Seal();
+    const auto& summary = m_Encoder.Summary();
+    const auto& payload = m_Encoder.Payload();
+
+    uint64_t offset = m_Offset;
+    m_Index.push_back({ header.FirstTimestamp, offset });
+    m_ChunkTimestamp = header.LastTimestamp;
+    offset += fwrite(&header, 1, sizeof(header), m_File);
+    offset += fwrite(&summary, 1, sizeof(summary), m_File);
+    offset += fwrite(payload.data(), 1, payload.size(), m_File);
+    m_Offset = offset;
+
+    FlushLog();
+
+    // A chunk spans at most one keyframe interval, so this is also how much a crash can lose
+    GD::SyncFile(m_File);
+
+    // Only after the chunk is on disk, so the overview never covers more than the recording
+    if (m_PyramidFile)
+        m_Pyramid.AppendFinished(m_PyramidFile, (uint32_t)m_Index.size() - 1, header.FirstTimestamp);
+}
+
+void Writer::FlushLog()
+{
+    if (m_Log.empty())
+        return;
+
+    m_LogBlock.clear();
+    EncodeLogBlock(m_Log, m_LogBlock);
+    m_Log.clear();
+    m_Offset += fwrite(m_LogBlock.data(), 1, m_LogBlock.size(), m_File);
+}
+
+
+bool GD::Record::Recover(const char* path, RecoverResult& result, std::string& error)
+{
+    result = {};
+    std::vector<IndexEntry> index;
+    {
+        GD::MappedFile file;
+        if (!file.Open(path))
+        {
+            error = "Unable to open file";
+            return false;
+        }
+
+        const uint8_t* data = file.Data();
+        size_t size = file.Size();
+        result.OriginalSize = size;
+
+        FileHeader header;
+        if (size >= sizeof(header))
+            memcpy(&header, data, sizeof(header));
+        if (size < sizeof(header) || header.Magic != FileMagic)
+        {
+            error = "Not a recording";
+            return false;
+        }
+        if (header.Version != FormatVersion)
+        {
+            error = "Unsupported recording version";
+            return false;
+        }
+
+        Footer footer;
+        if (size >= sizeof(header) + sizeof(footer))
+        {
+            memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+            if (footer.Magic == FooterMagic && footer.IndexOffset <= size - sizeof(footer) &&
+                footer.IndexCount == (size - sizeof(footer) - footer.IndexOffset) / sizeof(IndexEntry) &&
+                Crc32(data + footer.IndexOffset, footer.IndexCount * sizeof(IndexEntry)) == footer.Checksum)
+            {
+                result.HadIndex = true;
+                result.ValidSize = size;
+                result.Chunks = footer.IndexCount;
+                return true;
+            }
+        }
+
+        uint64_t offset = sizeof(header);
+        while (size_t block = ValidBlockSize(data + offset, size - (size_t)offset))
+        {
+            ChunkHeader chunk;
+            memcpy(&chunk, data + offset, std::min(block, sizeof(chunk)));
+            if (chunk.Magic == ChunkMagic)
+                index.push_back({ chunk.FirstTimestamp, offset });
+            offset += block;
+        }
+        result.ValidSize = offset;
+        result.Chunks = (uint32_t)index.size();
+    }
+
+    FILE* file = GD::OpenFile(path, "r+b");
+    if (!file)
+    {
+        error = "Unable to open file for writing";
+        return false;
+    }
+
+    bool ok = GD::TruncateFile(file, result.ValidSize) && fseek(file, 0, SEEK_END) == 0;
+    if (ok)
+    {
+        WriteIndex(file, result.ValidSize, index);
+        ok = GD::SyncFile(file);
+    }
+    fclose(file);
+
+    if (!ok)
+        error = "Unable to write the new index";
+    return ok;
+}